@@ -0,0 +1,183 @@
+// Benchmark: epoll vs io_uring evdev ingestion. Pipes stand in for evdev
+// nodes; a writer thread feeds every "device" at --rate Hz, staggered, with
+// CLOCK_MONOTONIC stamps as the kernel would. The reader drains them with
+// Wait()/Read() like InputThread::ThreadProc, blocking (or spinning on
+// Wait(0) with --poll), and records stamp -> read latency. Reports syscalls
+// and reader CPU time per event and the latency distribution per backend.
+#ifdef __linux__
+#include "../include/EvdevInputSource.h"
+#include "../include/LatencyHistogram.h"
+#include "../include/UringInputSource.h"
+#include <linux/input.h>
+#include <sys/prctl.h>
+#include <time.h>
+#include <unistd.h>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+static constexpr int kReadBatch = 64;
+
+struct Options {
+    int devices = 4;
+    double rateHz = 8000.0;
+    double durationSec = 5.0;
+    bool poll = false;
+};
+
+struct Result {
+    std::wstring name;
+    uint64_t events = 0;
+    uint64_t wakeups = 0;
+    uint64_t syscalls = 0;
+    double cpuNs = 0.0;
+    LatencyHistogram latency{ 1, 1000000000ull, 3 };
+};
+
+static int64_t NowNs(clockid_t clock) {
+    timespec ts{};
+    clock_gettime(clock, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000ll + ts.tv_nsec;
+}
+
+// One event per device per period, device i offset by i/devices of a period.
+static void Feed(const std::vector<int>& writers, const Options& o, const std::atomic<bool>& stop) {
+    prctl(PR_SET_TIMERSLACK, 1ul);
+    const int64_t step = static_cast<int64_t>(1e9 / o.rateHz / static_cast<double>(writers.size()));
+    timespec next{};
+    clock_gettime(CLOCK_MONOTONIC, &next);
+
+    for (size_t k = 0; !stop.load(std::memory_order_relaxed); k++) {
+        next.tv_nsec += step;
+        while (next.tv_nsec >= 1000000000l) {
+            next.tv_nsec -= 1000000000l;
+            next.tv_sec++;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, nullptr);
+
+        timespec now{};
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        input_event ev{};
+        ev.input_event_sec = now.tv_sec;
+        ev.input_event_usec = now.tv_nsec / 1000;
+        ev.type = EV_REL;
+        ev.code = REL_X;
+        ev.value = static_cast<int>(k);
+        const ssize_t w = write(writers[k % writers.size()], &ev, sizeof(ev));
+        (void)w;
+    }
+}
+
+template<typename Source>
+static Result Run(const Options& o) {
+    std::vector<int> readers, writers;
+    for (int i = 0; i < o.devices; i++) {
+        int p[2];
+        if (pipe(p) != 0) return Result{};
+        readers.push_back(p[0]);
+        writers.push_back(p[1]);
+    }
+
+    Result r{};
+    {
+        Source source(readers);
+        if (source.Open()) {
+            r.name = source.Name();
+            std::atomic<bool> stop{ false };
+            std::thread writer(Feed, std::cref(writers), std::cref(o), std::cref(stop));
+
+            InputEvent events[kReadBatch];
+            const int64_t end = NowNs(CLOCK_MONOTONIC) + static_cast<int64_t>(o.durationSec * 1e9);
+            const uint64_t syscalls0 = source.SyscallCount();
+            const int64_t cpu0 = NowNs(CLOCK_THREAD_CPUTIME_ID);
+
+            while (NowNs(CLOCK_MONOTONIC) < end) {
+                const InputSource::WaitResult w = source.Wait(o.poll ? 0 : 100);
+                if (w == InputSource::WaitResult::Exit) break;
+                if (w == InputSource::WaitResult::Timeout) continue;
+
+                const int n = source.Read(events, kReadBatch);
+                if (n < 0) break;
+                if (n == 0) continue;
+
+                const int64_t now = NowNs(CLOCK_MONOTONIC);
+                r.wakeups++;
+                r.events += static_cast<uint64_t>(n);
+                for (int i = 0; i < n; i++) {
+                    const int64_t lat = now - static_cast<int64_t>(events[i].timestampNs);
+                    r.latency.record(lat > 0 ? static_cast<uint64_t>(lat) : 0);
+                }
+            }
+
+            r.cpuNs = static_cast<double>(NowNs(CLOCK_THREAD_CPUTIME_ID) - cpu0);
+            r.syscalls = source.SyscallCount() - syscalls0;
+            stop = true;
+            writer.join();
+        }
+        source.Close();
+    }
+
+    for (int fd : readers) close(fd);
+    for (int fd : writers) close(fd);
+    return r;
+}
+
+static void Print(const Result& r) {
+    const double ev = r.events ? static_cast<double>(r.events) : 1.0;
+    const double us = 1000.0;
+    std::printf("%-34ls %9llu %10.2f %10.3f %9.0f %8.1f %8.1f %8.1f %9.1f\n",
+        r.name.c_str(), static_cast<unsigned long long>(r.events),
+        r.events / (r.wakeups ? static_cast<double>(r.wakeups) : 1.0),
+        r.syscalls / ev, r.cpuNs / ev,
+        r.latency.percentile(0.50) / us, r.latency.percentile(0.99) / us,
+        r.latency.percentile(0.999) / us, r.latency.max() / us);
+}
+
+static void Usage(const char* argv0) {
+    std::fprintf(stderr,
+        "usage: %s [options]\n"
+        "  --devices N     simulated devices (default: 4)\n"
+        "  --rate HZ       report rate per device (default: 8000)\n"
+        "  --duration SEC  per backend (default: 5)\n"
+        "  --poll          spin on Wait(0) instead of blocking\n",
+        argv0);
+}
+
+int main(int argc, char** argv) {
+    Options o;
+    for (int i = 1; i < argc; i++) {
+        const std::string a = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (a == "--devices" && hasValue) o.devices = std::max(1, std::atoi(argv[++i]));
+        else if (a == "--rate" && hasValue) o.rateHz = std::atof(argv[++i]);
+        else if (a == "--duration" && hasValue) o.durationSec = std::atof(argv[++i]);
+        else if (a == "--poll") o.poll = true;
+        else {
+            Usage(argv[0]);
+            return 2;
+        }
+    }
+    if (o.rateHz <= 0.0) o.rateHz = 8000.0;
+
+    std::printf("devices: %d x %.0f Hz, %s, %.1f s per backend\n",
+        o.devices, o.rateHz, o.poll ? "polling" : "blocking", o.durationSec);
+    std::printf("%-34s %9s %10s %10s %9s %8s %8s %8s %9s\n",
+        "backend", "events", "ev/wakeup", "sys/event", "cpu ns/ev", "p50 us", "p99 us", "p99.9 us", "max us");
+
+    Print(Run<EvdevInputSource>(o));
+    Print(Run<UringInputSource>(o));
+    return 0;
+}
+
+#else
+#include <cstdio>
+int main() {
+    std::printf("input_ingest_bench: evdev only (Linux)\n");
+    return 0;
+}
+#endif
@@ -0,0 +1,113 @@
+// Microbenchmark: per-event vs batched EvdevInputSource reads. Four pipes
+// stand in for 8 kHz devices; each round queues a burst on every pipe and the
+// reader drains it with Wait()/Read() exactly like InputThread::ThreadProc.
+// Reports syscalls and reader CPU time per event.
+#ifdef __linux__
+#include "../include/EvdevInputSource.h"
+#include <linux/input.h>
+#include <time.h>
+#include <unistd.h>
+#include <cstdio>
+#include <vector>
+
+static constexpr int kDevices = 4;
+static constexpr int kReadBatch = 64;
+
+struct Result {
+    uint64_t events;
+    uint64_t reads;
+    uint64_t syscalls;
+    double cpuNs;
+};
+
+static int64_t ThreadCpuNs() {
+    timespec ts{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000ll + ts.tv_nsec;
+}
+
+static void Fill(const std::vector<int>& writers, int perDevice) {
+    std::vector<input_event> burst(static_cast<size_t>(perDevice));
+    for (int i = 0; i < perDevice; i++) {
+        burst[i].type = EV_REL;
+        burst[i].code = REL_X;
+        burst[i].value = i;
+    }
+    for (int fd : writers) {
+        const ssize_t w = write(fd, burst.data(), burst.size() * sizeof(input_event));
+        (void)w;
+    }
+}
+
+static Result Run(int batch, int rounds, int perDevice) {
+    std::vector<int> readers, writers;
+    for (int i = 0; i < kDevices; i++) {
+        int p[2];
+        if (pipe(p) != 0) return Result{};
+        readers.push_back(p[0]);
+        writers.push_back(p[1]);
+    }
+
+    Result r{};
+    {
+        EvdevInputSource source(readers);
+        if (!source.Open()) return r;
+
+        InputEvent events[kReadBatch];
+        const uint64_t target = static_cast<uint64_t>(kDevices) * perDevice;
+
+        for (int round = 0; round < rounds; round++) {
+            Fill(writers, perDevice);
+
+            const uint64_t syscalls0 = source.SyscallCount();
+            const int64_t cpu0 = ThreadCpuNs();
+
+            uint64_t got = 0;
+            while (got < target) {
+                if (source.Wait(100) != InputSource::WaitResult::Ready) break;
+                const int n = source.Read(events, batch);
+                if (n < 0) break;
+                r.reads++;
+                got += static_cast<uint64_t>(n);
+            }
+
+            r.cpuNs += static_cast<double>(ThreadCpuNs() - cpu0);
+            r.syscalls += source.SyscallCount() - syscalls0;
+            r.events += got;
+        }
+        source.Close();
+    }
+
+    for (int fd : readers) close(fd);
+    for (int fd : writers) close(fd);
+    return r;
+}
+
+int main() {
+    // 8 kHz x 4 devices, drained every 1 ms (8 events/device) and every 8 ms.
+    const int bursts[] = { 8, 64 };
+
+    std::printf("devices: %d\n", kDevices);
+    std::printf("burst  mode       events  reads/event  syscalls/event  cpu ns/event\n");
+
+    for (int perDevice : bursts) {
+        const int rounds = 200000 / perDevice;
+        for (int batch : { 1, kReadBatch }) {
+            const Result r = Run(batch, rounds, perDevice);
+            const double ev = r.events ? static_cast<double>(r.events) : 1.0;
+            std::printf("%5d  %-9s  %7llu  %11.3f  %14.3f  %12.1f\n",
+                perDevice, batch == 1 ? "per-event" : "batched",
+                static_cast<unsigned long long>(r.events),
+                r.reads / ev, r.syscalls / ev, r.cpuNs / ev);
+        }
+    }
+    return 0;
+}
+
+#else
+#include <cstdio>
+int main() {
+    std::printf("input_read_bench: evdev only (Linux)\n");
+    return 0;
+}
+#endif
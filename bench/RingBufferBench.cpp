@@ -0,0 +1,74 @@
+// Microbenchmark: generic RingBuffer (heap vector, % indexing, scalar
+// aggregates) vs the power-of-two specialization (inline storage, mask
+// indexing, SIMD aggregates) for N = 256 .. 65536.
+#include "../include/RingBuffer.h"
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <random>
+
+using Clock = std::chrono::steady_clock;
+
+static volatile double g_sink = 0.0;
+
+struct Result {
+    double pushNs;
+    double queryNs;
+};
+
+template<typename Ring>
+static Result Run(const std::vector<double>& samples, size_t queries) {
+    auto ring = std::make_unique<Ring>();
+
+    auto t0 = Clock::now();
+    for (double v : samples) ring->push(v);
+    auto t1 = Clock::now();
+
+    double acc = 0.0;
+    auto t2 = Clock::now();
+    for (size_t i = 0; i < queries; i++) {
+        acc += ring->min() + ring->max() + ring->average();
+    }
+    auto t3 = Clock::now();
+    g_sink = acc;
+
+    Result r{};
+    r.pushNs = std::chrono::duration<double, std::nano>(t1 - t0).count() / samples.size();
+    r.queryNs = std::chrono::duration<double, std::nano>(t3 - t2).count() / queries;
+    return r;
+}
+
+template<size_t N>
+static void Compare(const std::vector<double>& samples) {
+    const size_t queries = std::max<size_t>(64, (1u << 24) / N);
+
+    Result generic = Run<RingBuffer<double, N, false>>(samples, queries);
+    Result pow2 = Run<RingBuffer<double, N>>(samples, queries);
+
+    std::printf("%6zu  %9.2f  %9.2f  %12.1f  %12.1f  %6.2fx\n",
+        N, generic.pushNs, pow2.pushNs, generic.queryNs, pow2.queryNs,
+        pow2.queryNs > 0 ? generic.queryNs / pow2.queryNs : 0.0);
+}
+
+int main() {
+    std::mt19937_64 rng(42);
+    std::lognormal_distribution<double> dist(2.0, 0.75);
+
+    std::vector<double> samples(1u << 21);
+    for (double& v : samples) v = dist(rng);
+
+    std::printf("kernel: %s\n", RingBufferSimd::KernelName());
+    std::printf("%6s  %9s  %9s  %12s  %12s  %7s\n",
+        "N", "push(gen)", "push(p2)", "query(gen)", "query(p2)", "speedup");
+
+    Compare<256>(samples);
+    Compare<512>(samples);
+    Compare<1024>(samples);
+    Compare<2048>(samples);
+    Compare<4096>(samples);
+    Compare<8192>(samples);
+    Compare<16384>(samples);
+    Compare<32768>(samples);
+    Compare<65536>(samples);
+    return 0;
+}
@@ -0,0 +1,412 @@
+// Cyclictest-style wakeup latency benchmark. One periodic thread per selected
+// CPU, pinned and at the requested scheduling policy, wakes every interval
+// through one wait mechanism at a time and records how late it woke. Prints a
+// summary table on stderr and full per-CPU histograms as JSON on stdout (or
+// --out), for comparing machines and kernels.
+#ifdef __linux__
+#include "../include/CpuSet.h"
+#include <linux/futex.h>
+#include <sched.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/timerfd.h>
+#include <sys/utsname.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef SYS_epoll_pwait2
+#define SYS_epoll_pwait2 441
+#endif
+
+enum class Mechanism { Nanosleep, ClockNanosleepAbs, Timerfd, Epoll, Futex };
+
+static const char* Name(Mechanism m) {
+    switch (m) {
+    case Mechanism::Nanosleep: return "nanosleep";
+    case Mechanism::ClockNanosleepAbs: return "clock_nanosleep_abs";
+    case Mechanism::Timerfd: return "timerfd";
+    case Mechanism::Epoll: return "epoll";
+    case Mechanism::Futex: return "futex";
+    }
+    return "?";
+}
+
+struct Options {
+    CpuSet cpus;
+    int64_t intervalNs = 1000000;
+    double durationS = 5.0;
+    int policy = SCHED_FIFO;
+    int priority = 80;
+    int histMaxUs = 10000;
+    bool lockMemory = false;
+    std::vector<Mechanism> mechanisms = {
+        Mechanism::Nanosleep, Mechanism::ClockNanosleepAbs, Mechanism::Timerfd, Mechanism::Epoll, Mechanism::Futex
+    };
+    std::string outPath;
+};
+
+// One thread's results for one mechanism. Latency histogram in 1 us buckets
+// up to histMaxUs; later wakeups land in `overflow`.
+struct CoreRun {
+    int cpu = -1;
+    bool pinned = false;
+    bool policyApplied = false;
+    uint64_t samples = 0;
+    uint64_t overruns = 0; // whole periods missed
+    uint64_t overflow = 0;
+    int64_t minNs = INT64_MAX;
+    int64_t maxNs = 0;
+    double sumNs = 0.0;
+    std::vector<uint64_t> histogram;
+};
+
+static int64_t NowNs() {
+    timespec ts{};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000ll + ts.tv_nsec;
+}
+
+static timespec ToTimespec(int64_t ns) {
+    timespec ts{};
+    if (ns < 0) ns = 0;
+    ts.tv_sec = static_cast<time_t>(ns / 1000000000ll);
+    ts.tv_nsec = static_cast<long>(ns % 1000000000ll);
+    return ts;
+}
+
+// Cleared on the first ENOSYS; every thread then uses epoll_wait.
+static std::atomic<bool> g_epollPwait2{true};
+
+// Blocks until `deadline` (CLOCK_MONOTONIC ns) using `m`. Relative waits
+// compute their timeout from the current time, as callers of those APIs do.
+class Waiter {
+public:
+    explicit Waiter(Mechanism m) : m_(m) {
+        if (m_ == Mechanism::Timerfd) tfd_ = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+        if (m_ == Mechanism::Epoll) epfd_ = epoll_create1(EPOLL_CLOEXEC);
+    }
+
+    ~Waiter() {
+        if (tfd_ >= 0) close(tfd_);
+        if (epfd_ >= 0) close(epfd_);
+    }
+
+    bool Ok() const {
+        if (m_ == Mechanism::Timerfd) return tfd_ >= 0;
+        if (m_ == Mechanism::Epoll) return epfd_ >= 0;
+        return true;
+    }
+
+    // The timerfd is armed once as an absolute periodic timer; it reports
+    // how many periods elapsed, which may exceed 1 after an overrun.
+    void Arm(int64_t first, int64_t interval) {
+        if (m_ != Mechanism::Timerfd) return;
+        itimerspec its{};
+        its.it_value = ToTimespec(first);
+        its.it_interval = ToTimespec(interval);
+        timerfd_settime(tfd_, TFD_TIMER_ABSTIME, &its, nullptr);
+    }
+
+    // Returns timer expirations consumed (1 except for timerfd overruns).
+    uint64_t WaitUntil(int64_t deadline) {
+        switch (m_) {
+        case Mechanism::Nanosleep: {
+            const timespec ts = ToTimespec(deadline - NowNs());
+            nanosleep(&ts, nullptr);
+            return 1;
+        }
+        case Mechanism::ClockNanosleepAbs: {
+            const timespec ts = ToTimespec(deadline);
+            while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {}
+            return 1;
+        }
+        case Mechanism::Timerfd: {
+            uint64_t expirations = 0;
+            if (read(tfd_, &expirations, sizeof(expirations)) != sizeof(expirations)) return 1;
+            return expirations;
+        }
+        case Mechanism::Epoll: {
+            epoll_event ev{};
+            const int64_t rel = deadline - NowNs();
+            if (g_epollPwait2) {
+                const timespec ts = ToTimespec(rel);
+                if (syscall(SYS_epoll_pwait2, epfd_, &ev, 1, &ts, nullptr, 0) >= 0 || errno != ENOSYS) return 1;
+                g_epollPwait2 = false; // kernel < 5.11: millisecond timeouts only
+            }
+            epoll_wait(epfd_, &ev, 1, rel > 0 ? static_cast<int>((rel + 999999) / 1000000) : 0);
+            return 1;
+        }
+        case Mechanism::Futex: {
+            // Nobody wakes this word; FUTEX_WAIT_BITSET takes an absolute
+            // CLOCK_MONOTONIC timeout, as condition_variable::wait_until does.
+            const timespec ts = ToTimespec(deadline);
+            syscall(SYS_futex, &word_, FUTEX_WAIT_BITSET | FUTEX_PRIVATE_FLAG, 0, &ts, nullptr, FUTEX_BITSET_MATCH_ANY);
+            return 1;
+        }
+        }
+        return 1;
+    }
+
+private:
+    Mechanism m_;
+    int tfd_ = -1;
+    int epfd_ = -1;
+    uint32_t word_ = 0;
+};
+
+static void RunCore(const Options& o, Mechanism m, int64_t start, CoreRun& run) {
+    run.pinned = CpuSet::Of(static_cast<uint32_t>(run.cpu)).ApplyTo(0);
+
+    sched_param sp{};
+    sp.sched_priority = (o.policy == SCHED_OTHER) ? 0 : o.priority;
+    run.policyApplied = sched_setscheduler(0, o.policy, &sp) == 0;
+
+    run.histogram.assign(static_cast<size_t>(o.histMaxUs) + 1, 0);
+    Waiter waiter(m);
+    if (!waiter.Ok()) return;
+
+    const int64_t end = start + static_cast<int64_t>(o.durationS * 1e9);
+    int64_t next = start;
+    waiter.Arm(next, o.intervalNs);
+
+    while (next < end) {
+        const uint64_t expirations = waiter.WaitUntil(next);
+        const int64_t late = NowNs() - next;
+
+        const int64_t ns = late < 0 ? 0 : late;
+        const uint64_t us = static_cast<uint64_t>(ns / 1000);
+        if (us > static_cast<uint64_t>(o.histMaxUs)) run.overflow++;
+        else run.histogram[us]++;
+        run.samples++;
+        run.sumNs += static_cast<double>(ns);
+        if (ns < run.minNs) run.minNs = ns;
+        if (ns > run.maxNs) run.maxNs = ns;
+
+        // Periods that passed while we were late are skipped, not queued.
+        uint64_t periods = expirations;
+        if (m != Mechanism::Timerfd) periods = 1 + static_cast<uint64_t>(ns / o.intervalNs);
+        run.overruns += periods - 1;
+        next += static_cast<int64_t>(periods) * o.intervalNs;
+    }
+
+    sp.sched_priority = 0;
+    sched_setscheduler(0, SCHED_OTHER, &sp);
+}
+
+static double PercentileUs(const CoreRun& r, double p) {
+    if (r.samples == 0) return 0.0;
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(p * static_cast<double>(r.samples))));
+    uint64_t seen = 0;
+    for (size_t us = 0; us < r.histogram.size(); us++) {
+        seen += r.histogram[us];
+        if (seen >= rank) return static_cast<double>(us);
+    }
+    return static_cast<double>(r.maxNs) / 1000.0;
+}
+
+static std::vector<CoreRun> RunMechanism(const Options& o, Mechanism m) {
+    std::vector<CoreRun> runs;
+    for (int c = o.cpus.First(); c >= 0; c = o.cpus.Next(c)) {
+        CoreRun r;
+        r.cpu = c;
+        runs.push_back(std::move(r));
+    }
+
+    // Threads share the period but start staggered across it, so their
+    // wakeups do not all land on the same timer tick.
+    const int64_t start = NowNs() + 100000000ll;
+    std::vector<std::thread> pool;
+    for (size_t t = 0; t < runs.size(); t++) {
+        const int64_t offset = o.intervalNs * static_cast<int64_t>(t) / static_cast<int64_t>(runs.size());
+        pool.emplace_back(RunCore, std::cref(o), m, start + offset, std::ref(runs[t]));
+    }
+    for (std::thread& t : pool) t.join();
+    return runs;
+}
+
+static const char* PolicyName(int policy) {
+    switch (policy) {
+    case SCHED_FIFO: return "fifo";
+    case SCHED_RR: return "rr";
+    default: return "other";
+    }
+}
+
+static void WriteJson(FILE* f, const Options& o, const std::vector<std::pair<Mechanism, std::vector<CoreRun>>>& all) {
+    utsname u{};
+    uname(&u);
+
+    std::fprintf(f, "{\n  \"benchmark\": \"wakeup_bench\",\n");
+    std::fprintf(f, "  \"kernel\": \"%s %s\",\n", u.sysname, u.release);
+    std::fprintf(f, "  \"intervalUs\": %.3f,\n  \"durationS\": %.3f,\n",
+        static_cast<double>(o.intervalNs) / 1000.0, o.durationS);
+    std::fprintf(f, "  \"policy\": \"%s\",\n  \"priority\": %d,\n  \"histogramMaxUs\": %d,\n",
+        PolicyName(o.policy), o.priority, o.histMaxUs);
+    std::fprintf(f, "  \"epollTimeout\": \"%s\",\n", g_epollPwait2 ? "epoll_pwait2 (ns)" : "epoll_wait (ms)");
+    std::fprintf(f, "  \"mechanisms\": [\n");
+
+    for (size_t mi = 0; mi < all.size(); mi++) {
+        std::fprintf(f, "    {\n      \"name\": \"%s\",\n      \"cores\": [\n", Name(all[mi].first));
+        const std::vector<CoreRun>& runs = all[mi].second;
+        for (size_t ci = 0; ci < runs.size(); ci++) {
+            const CoreRun& r = runs[ci];
+            std::fprintf(f, "        {\"cpu\": %d, \"pinned\": %s, \"policyApplied\": %s, \"samples\": %llu, "
+                "\"overruns\": %llu, \"minUs\": %.3f, \"avgUs\": %.3f, \"p50Us\": %.0f, \"p99Us\": %.0f, "
+                "\"p999Us\": %.0f, \"maxUs\": %.3f, \"overflow\": %llu,\n         \"histogram\": [",
+                r.cpu, r.pinned ? "true" : "false", r.policyApplied ? "true" : "false",
+                static_cast<unsigned long long>(r.samples), static_cast<unsigned long long>(r.overruns),
+                r.samples ? static_cast<double>(r.minNs) / 1000.0 : 0.0,
+                r.samples ? r.sumNs / static_cast<double>(r.samples) / 1000.0 : 0.0,
+                PercentileUs(r, 0.50), PercentileUs(r, 0.99), PercentileUs(r, 0.999),
+                static_cast<double>(r.maxNs) / 1000.0, static_cast<unsigned long long>(r.overflow));
+
+            // Sparse [us, count] pairs; empty buckets are omitted.
+            bool first = true;
+            for (size_t us = 0; us < r.histogram.size(); us++) {
+                if (!r.histogram[us]) continue;
+                std::fprintf(f, "%s[%zu, %llu]", first ? "" : ", ", us, static_cast<unsigned long long>(r.histogram[us]));
+                first = false;
+            }
+            std::fprintf(f, "]}%s\n", ci + 1 < runs.size() ? "," : "");
+        }
+        std::fprintf(f, "      ]\n    }%s\n", mi + 1 < all.size() ? "," : "");
+    }
+    std::fprintf(f, "  ]\n}\n");
+}
+
+static bool ParseMechanisms(const std::string& list, std::vector<Mechanism>& out) {
+    out.clear();
+    size_t pos = 0;
+    while (pos <= list.size()) {
+        const size_t comma = list.find(',', pos);
+        const std::string name = list.substr(pos, comma == std::string::npos ? std::string::npos : comma - pos);
+        bool found = false;
+        for (Mechanism m : { Mechanism::Nanosleep, Mechanism::ClockNanosleepAbs, Mechanism::Timerfd,
+                             Mechanism::Epoll, Mechanism::Futex }) {
+            if (name == Name(m)) {
+                out.push_back(m);
+                found = true;
+            }
+        }
+        if (!found) return false;
+        if (comma == std::string::npos) break;
+        pos = comma + 1;
+    }
+    return !out.empty();
+}
+
+static void Usage(const char* argv0) {
+    std::fprintf(stderr,
+        "usage: %s [options]\n"
+        "  --cpus LIST           CPUs to run a periodic thread on (default: process affinity)\n"
+        "  --interval US         wakeup period (default: 1000)\n"
+        "  --duration S          seconds per mechanism (default: 5)\n"
+        "  --policy NAME[:PRIO]  other | fifo | rr (default: fifo:80)\n"
+        "  --mechanisms LIST     comma list of nanosleep, clock_nanosleep_abs, timerfd,\n"
+        "                        epoll, futex (default: all)\n"
+        "  --hist-max US         histogram range, 1 us buckets (default: 10000)\n"
+        "  --mlock               lock memory (mlockall) before measuring\n"
+        "  --out FILE            write JSON to FILE instead of stdout\n",
+        argv0);
+}
+
+int main(int argc, char** argv) {
+    Options o;
+    o.cpus = CpuSet::Process();
+
+    for (int i = 1; i < argc; i++) {
+        const std::string a = argv[i];
+        const bool hasValue = i + 1 < argc;
+
+        if (a == "--cpus" && hasValue) {
+            if (!CpuSet::Parse(argv[++i], o.cpus) || o.cpus.Empty()) {
+                Usage(argv[0]);
+                return 2;
+            }
+        } else if (a == "--interval" && hasValue) o.intervalNs = static_cast<int64_t>(std::atof(argv[++i]) * 1000.0);
+        else if (a == "--duration" && hasValue) o.durationS = std::atof(argv[++i]);
+        else if (a == "--policy" && hasValue) {
+            const std::string spec = argv[++i];
+            const std::string name = spec.substr(0, spec.find(':'));
+            if (name == "other") o.policy = SCHED_OTHER;
+            else if (name == "fifo") o.policy = SCHED_FIFO;
+            else if (name == "rr") o.policy = SCHED_RR;
+            else {
+                Usage(argv[0]);
+                return 2;
+            }
+            if (spec.find(':') != std::string::npos) o.priority = std::atoi(spec.c_str() + spec.find(':') + 1);
+        } else if (a == "--mechanisms" && hasValue) {
+            if (!ParseMechanisms(argv[++i], o.mechanisms)) {
+                Usage(argv[0]);
+                return 2;
+            }
+        } else if (a == "--hist-max" && hasValue) o.histMaxUs = std::atoi(argv[++i]);
+        else if (a == "--mlock") o.lockMemory = true;
+        else if (a == "--out" && hasValue) o.outPath = argv[++i];
+        else {
+            Usage(argv[0]);
+            return 2;
+        }
+    }
+
+    if (o.intervalNs < 10000 || o.durationS <= 0.0 || o.histMaxUs < 1) {
+        Usage(argv[0]);
+        return 2;
+    }
+    if (o.policy == SCHED_OTHER) o.priority = 0;
+    if (o.lockMemory && mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+        std::fprintf(stderr, "mlockall: %s (continuing unlocked)\n", std::strerror(errno));
+    }
+
+    std::fprintf(stderr, "cpus %s, interval %.0f us, %.1f s per mechanism, policy %s:%d\n",
+        o.cpus.ToString().c_str(), static_cast<double>(o.intervalNs) / 1000.0, o.durationS,
+        PolicyName(o.policy), o.priority);
+    std::fprintf(stderr, "mechanism            cpu   samples  overruns   p50 us   p99 us  p99.9 us    max us\n");
+
+    std::vector<std::pair<Mechanism, std::vector<CoreRun>>> all;
+    bool policyFailed = false;
+    for (Mechanism m : o.mechanisms) {
+        std::vector<CoreRun> runs = RunMechanism(o, m);
+        for (const CoreRun& r : runs) {
+            if (!r.policyApplied) policyFailed = true;
+            std::fprintf(stderr, "%-19s  %3d  %8llu  %8llu  %7.0f  %7.0f  %8.0f  %8.0f%s\n",
+                Name(m), r.cpu, static_cast<unsigned long long>(r.samples),
+                static_cast<unsigned long long>(r.overruns), PercentileUs(r, 0.50), PercentileUs(r, 0.99),
+                PercentileUs(r, 0.999), static_cast<double>(r.maxNs) / 1000.0, r.pinned ? "" : "  (not pinned)");
+        }
+        all.emplace_back(m, std::move(runs));
+    }
+    if (policyFailed) {
+        std::fprintf(stderr, "note: could not set policy %s (needs CAP_SYS_NICE); ran as SCHED_OTHER\n",
+            PolicyName(o.policy));
+    }
+
+    FILE* f = o.outPath.empty() ? stdout : std::fopen(o.outPath.c_str(), "w");
+    if (!f) {
+        std::fprintf(stderr, "cannot write %s\n", o.outPath.c_str());
+        return 1;
+    }
+    WriteJson(f, o, all);
+    if (f != stdout) std::fclose(f);
+    return 0;
+}
+
+#else
+#include <cstdio>
+int main() {
+    std::printf("wakeup_bench: Linux wait mechanisms only\n");
+    return 0;
+}
+#endif
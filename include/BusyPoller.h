@@ -0,0 +1,107 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include "InputSource.h"
+#include "LatencyHistogram.h"
+#include "SeqLock.h"
+
+struct BusyPollStats {
+    bool polling = false;          // false: on battery, or waiting out the budget
+    bool onBattery = false;
+    double budget = 0.0;           // allowed fraction of one CPU
+    double spinFraction = 0.0;     // CPU actually spent polling, last window
+    uint64_t polls = 0;            // non-blocking Wait(0) calls
+    uint64_t budgetExhausted = 0;  // windows that fell back to blocking
+    uint64_t polledWakeups = 0;
+    uint64_t blockedWakeups = 0;
+    double polledAvgUs = 0.0;      // oldest event stamp -> read done
+    double polledP99Us = 0.0;
+    double blockedAvgUs = 0.0;
+    double blockedP99Us = 0.0;
+    double removedUs = 0.0;        // blockedAvgUs - polledAvgUs
+};
+
+// Linux "Max+" input wait: instead of sleeping in the source's Wait, spin on
+// Wait(0) (one non-blocking epoll_wait for all evdev fds), backing off with
+// PAUSE and, where the CPU has WAITPKG, a short UMWAIT between empty polls.
+// Time is cut into 100 ms windows; once polling has used `budget` of a window
+// the rest of it blocks as usual, and every 16th window blocks on purpose so
+// the wakeup latency polling removes is measured under the same load. Polling
+// stops on battery, checked every 10 s on a watcher thread so the input thread
+// never reads sysfs. Wakeup latencies are handed to readers by swapping the
+// histograms at window starts (when a reader has taken the last ones), and
+// summarized by Stats() on the reader's thread, so they trail the counters by
+// up to one Stats() interval. Input thread only, except Stats(), SetBudget()
+// and the power watch.
+class BusyPoller {
+public:
+    static constexpr double kDefaultBudget = 0.5;
+
+    BusyPoller();
+    ~BusyPoller();
+
+    // Any thread; takes effect at the next window.
+    void SetBudget(double fraction);
+
+    // Start checks the power state once on the caller's thread, then every
+    // 10 s on a watcher thread until Stop. Without it polling assumes AC.
+    void StartPowerWatch();
+    void StopPowerWatch();
+
+    // Drop-in for source.Wait(timeoutMs).
+    InputSource::WaitResult Wait(InputSource& source, int timeoutMs);
+
+    // After the read that followed Wait(): `events` as returned, `readEndTicks`
+    // on the measurer's clock. Events without a source stamp are ignored.
+    void RecordWakeup(const InputEvent* events, int n, int64_t readEndTicks);
+
+    // Any thread.
+    BusyPollStats Stats() const;
+
+    void Reset();
+
+    // Input thread, before it exits: hands off the wakeups recorded since the
+    // last window start.
+    void Flush();
+
+private:
+    void StartWindow(int64_t now);
+    void Publish();
+    void DrainPending() const; // exchange_mutex_ held
+    void Backoff();
+    void WatchPower();
+
+    std::atomic<double> budget_{kDefaultBudget};
+    std::atomic<bool> battery_{false}; // written by the power watch
+
+    std::thread power_thread_;
+    std::mutex power_mutex_;
+    std::condition_variable power_cv_;
+    bool power_stop_ = false;
+
+    int64_t frequency_ = 0;
+    int64_t window_ticks_ = 0;
+    int64_t window_start_ = 0;
+    int64_t window_spun_ = 0;
+    uint64_t window_index_ = 0;
+    double window_budget_ = kDefaultBudget;
+    bool window_blocking_ = false;  // baseline, battery or budget spent
+    bool last_wait_polled_ = false;
+    bool on_battery_ = false;       // battery_ as of the window start
+    unsigned empty_polls_ = 0;
+
+    BusyPollStats stats_{};
+    LatencyHistogram polled_;       // since the last hand-off
+    LatencyHistogram blocked_;
+    SeqLock<BusyPollStats> published_;
+
+    mutable std::mutex exchange_mutex_;
+    mutable LatencyHistogram pending_polled_;
+    mutable LatencyHistogram pending_blocked_;
+    mutable bool pending_full_ = false;
+    mutable LatencyHistogram merged_polled_;
+    mutable LatencyHistogram merged_blocked_;
+};
@@ -0,0 +1,30 @@
+#pragma once
+#include <string>
+#include "DeviceTuner.h"
+
+// DeviceTuner calibration persisted across launches, so a start under the
+// login storm reuses an earlier quiet measurement instead of taking a noisy
+// one. Windows keeps it beside the ConfigStore values
+// (HKCU\Software\InputLatencyOptimizer, value "Calibration"); Linux in
+// $XDG_CACHE_HOME/input-latency-optimizer/calibration.
+struct CachedCalibration {
+    std::string fingerprint;     // Fingerprint() of the machine it was measured on
+    bool idleValidated = false;  // measured by the idle revalidation pass
+    CalibrationResult result;    // result.measuredAt dates it
+};
+
+class CalibrationCache {
+public:
+    // CPU model, logical CPU count, RAM, timer caps and OS build. Any change
+    // invalidates the stored result.
+    static std::string Fingerprint(const DeviceProfile& p);
+
+    static bool Load(CachedCalibration& out);
+    static bool Save(const CachedCalibration& c);
+
+    // Stored form: one "key=value" per line, unknown keys ignored.
+    static std::string Serialize(const CachedCalibration& c);
+    static bool Parse(const std::string& text, CachedCalibration& out);
+
+    static long long Now(); // unix seconds
+};
@@ -0,0 +1,72 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Set of logical CPUs of any size. CPU i is Linux CPU i; on Windows it is
+// group * 64 + number, so word g of the set is exactly processor group g's
+// KAFFINITY mask. Replaces DWORD_PTR masks, which stop at 64 CPUs and
+// cannot name a processor group.
+class CpuSet {
+public:
+    CpuSet() = default;
+
+    static CpuSet Of(uint32_t cpu);
+    static CpuSet FromMask(uint64_t mask, uint16_t group = 0);
+
+    // Kernel list syntax ("0-3,8,64-95"), or a hex mask ("0x..." of any
+    // length, lowest CPU in the last digit). Returns false on bad syntax.
+    static bool Parse(const std::string& text, CpuSet& out);
+
+    // Kernel list syntax; "" for the empty set. Round-trips through Parse.
+    std::string ToString() const;
+
+    void Set(uint32_t cpu);
+    void Reset(uint32_t cpu);
+    bool Test(uint32_t cpu) const;
+    void Clear() { words_.clear(); }
+
+    bool Empty() const;
+    size_t Count() const;
+    int First() const;          // -1 if empty
+    int Next(int after) const;  // next CPU above `after`, -1 at the end
+
+    // Processor group view: the 64-bit mask of group `group`, and the
+    // number of groups up to the highest one with a CPU in the set.
+    uint64_t GroupMask(uint16_t group) const;
+    uint16_t GroupCount() const;
+
+    bool Intersects(const CpuSet& other) const;
+    bool IsSubsetOf(const CpuSet& other) const;
+
+    CpuSet& operator|=(const CpuSet& other);
+    CpuSet& operator&=(const CpuSet& other);
+    CpuSet& operator-=(const CpuSet& other);
+
+    friend CpuSet operator|(CpuSet a, const CpuSet& b) { return a |= b; }
+    friend CpuSet operator&(CpuSet a, const CpuSet& b) { return a &= b; }
+    friend CpuSet operator-(CpuSet a, const CpuSet& b) { return a -= b; }
+    bool operator==(const CpuSet& other) const;
+    bool operator!=(const CpuSet& other) const { return !(*this == other); }
+
+    // CPUs this process may run on, and every active CPU.
+    static CpuSet Process();
+    static CpuSet Online();
+
+    // Thread affinity. Windows threads live in one processor group, so
+    // ApplyTo uses the lowest group in the set. On Linux a tid of 0 is the
+    // calling thread.
+#ifdef _WIN32
+    static bool OfThread(void* thread, CpuSet& out);
+    bool ApplyTo(void* thread) const;
+#else
+    static bool OfThread(int tid, CpuSet& out);
+    bool ApplyTo(int tid) const;
+#endif
+
+private:
+    void Trim();
+
+    std::vector<uint64_t> words_; // no trailing zero words
+};
@@ -0,0 +1,63 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// One logical processor as the scheduler sees it. Sharing domains (core, L2,
+// L3) are keyed by the lowest logical CPU index in the domain, so two CPUs
+// share a physical core exactly when their `core` fields are equal.
+struct LogicalCpu {
+    uint32_t index = 0;      // Linux CPU number; Windows group * 64 + number
+    uint16_t group = 0;      // Windows processor group (0 on Linux)
+    uint8_t number = 0;      // bit within the group
+    int32_t core = -1;
+    int32_t package = -1;
+    int32_t numaNode = -1;
+    int32_t l2 = -1;         // -1 when the cache is not reported
+    int32_t l3 = -1;
+    uint32_t capacity = 1024; // relative performance, 1024 = fastest class
+    uint8_t smtThreads = 1;   // logical CPUs on this physical core
+    bool online = true;
+    bool allowed = true;      // in the process affinity (or reserved for us)
+    bool isolated = false;    // isolcpus=
+    bool nohzFull = false;    // nohz_full=
+};
+
+// CPU topology model used to choose where the input thread should run.
+// Linux reads /sys/devices/system/cpu; Windows reads
+// GetLogicalProcessorInformationEx.
+class CpuTopology {
+public:
+    static CpuTopology Detect();
+
+#ifndef _WIN32
+    // Parses a sysfs CPU directory (normally /sys/devices/system/cpu). All
+    // online CPUs are marked allowed; Detect() narrows that to the affinity.
+    static CpuTopology FromSysfs(const std::string& root);
+#endif
+
+    const std::vector<LogicalCpu>& Cpus() const { return cpus_; }
+    const LogicalCpu* Find(uint32_t index) const;
+
+    size_t AllowedCount() const;
+    bool IsHybrid() const;
+    bool HasSmt() const;
+
+    // Up to `max` allowed CPUs worth probing, best first: isolated, then
+    // nohz_full, then the fastest core class away from CPU 0's core; picks are
+    // spread over distinct L3/L2 domains and physical cores before any SMT
+    // sibling is taken.
+    std::vector<uint32_t> Candidates(size_t max) const;
+
+    // Plain-text reasons a CPU ranks where it does, for the calibration report.
+    std::string Describe(uint32_t index) const;
+
+    // One-line machine summary ("8 CPUs on 4 cores (SMT), hybrid 4P+4E, ...").
+    std::string Summary() const;
+
+private:
+    void Finish();
+
+    std::vector<LogicalCpu> cpus_;
+    uint32_t max_capacity_ = 0;
+};
@@ -0,0 +1,107 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include "InputSource.h"
+#include "SeqLock.h"
+
+// Statistics of one input device, in microseconds.
+struct DeviceStats {
+    uint64_t device = 0;       // RAWINPUTHEADER::hDevice (Windows), evdev fd (Linux)
+    uint64_t events = 0;
+    uint64_t reports = 0;      // events sharing one source stamp are one report
+    double rateHz = 0.0;       // report rate while active (1 / mean interval)
+    double intervalUs = 0.0;   // mean report interval, last second of activity
+    double jitterUs = 0.0;     // standard deviation of that interval
+    bool stamped = false;      // latency is delivery (stamp -> read) rather than read time
+    uint64_t samples = 0;      // latency samples
+    double p50Us = 0.0;
+    double p95Us = 0.0;
+    double p99Us = 0.0;
+    double maxUs = 0.0;
+};
+
+struct DeviceStatsSnapshot {
+    static constexpr int kMaxDevices = 16;
+
+    int count = 0;
+    uint64_t untracked = 0;    // events from devices beyond kMaxDevices
+    DeviceStats devices[kMaxDevices];
+};
+
+// Per-device counterpart of LatencyMeasurer, which merges every device into
+// one distribution. A fixed table of kMaxDevices entries, allocated with the
+// object: Record() scans a packed array of device keys (two cache lines) and
+// bumps one entry and one bucket of its log-linear latency histogram, without
+// allocating or locking. Entries are never evicted until Reset(); events from
+// further devices are only counted.
+// Input thread only, except Snapshot() and RequestReset().
+class DeviceStatsTable {
+public:
+    static constexpr int kMaxDevices = DeviceStatsSnapshot::kMaxDevices;
+
+    DeviceStatsTable();
+
+    // After the read that returned the event, `readEndTicks` and
+    // `readElapsedTicks` on the measurer's clock. Sources that stamp events
+    // (evdev, replay) give delivery latency and report intervals from the
+    // stamps; unstamped ones (Raw Input) count one report per event, timed at
+    // the read, with the read's duration as latency.
+    void Record(const InputEvent& ev, int64_t readEndTicks, int64_t readElapsedTicks);
+
+    // Republishes at most once per publish interval (100 ms).
+    void PublishIfDue(int64_t nowTicks);
+
+    // Publishes pending samples (and applies a pending RequestReset()); call
+    // from the idle timer.
+    void PublishIfDirty();
+
+    void Reset();
+
+    // Any thread.
+    DeviceStatsSnapshot Snapshot() const { return published_.Load(); }
+    void RequestReset() { reset_requested_.store(true, std::memory_order_release); }
+
+private:
+    // 8 linear sub-buckets per power of two of nanoseconds (12.5% wide),
+    // exact below 8 ns, capped at 1 s.
+    static constexpr int kSubBuckets = 8;
+    static constexpr int kBuckets = 224;
+
+    struct alignas(64) Entry {
+        uint64_t events;
+        uint64_t reports;
+        uint64_t lastStampNs;      // last report's arrival
+        int64_t windowStartNs;
+        uint64_t windowGaps;
+        double windowSum;          // report intervals of the open window, ns
+        double windowSumSq;
+        double intervalNs;         // last closed window
+        double jitterNs;
+        bool stamped;
+        uint64_t samples;
+        uint64_t maxNs;
+        uint32_t buckets[kBuckets];
+    };
+
+    static int Bucket(uint64_t ns);
+    static double BucketValue(int index);
+
+    Entry* Find(uint64_t device);
+    void RecordReport(Entry& e, uint64_t arrivalNs);
+    void Publish(int64_t now);
+    void ApplyPendingReset();
+
+    int64_t frequency_ = 0;
+    int64_t publish_interval_ = 0;
+    int64_t last_publish_ = 0;
+    bool dirty_ = false;
+    std::atomic<bool> reset_requested_{false};
+
+    int count_ = 0;
+    int last_ = 0;                 // consecutive events mostly share a device
+    uint64_t untracked_ = 0;
+    alignas(64) uint64_t keys_[kMaxDevices];
+    Entry entries_[kMaxDevices];
+
+    SeqLock<DeviceStatsSnapshot> published_;
+};
@@ -1,7 +1,19 @@
 #pragma once
-#include <windows.h>
+#include <atomic>
+#include <string>
+#include "Platform.h"
+#include "CpuSet.h"
+#include "NoiseProbe.h"
 #include "InputThread.h"
-#include "SettingsDialog.h"
+
+#include <functional>
+#include <vector>
+
+class CpuTopology;
+struct LogicalCpu;
+
+// Tuning tiers offered by the tray (SettingsDialog::Mode) and ilo_headless.
+enum class TuningMode : DWORD { Light = 0, Medium = 1, Max = 2, Recommend = 3 };
 
 struct DeviceProfile {
     bool hasBattery = false;
@@ -12,8 +24,40 @@ struct DeviceProfile {
     ULONGLONG ramBytes = 0;
     UINT timerMinMs = 1;
     UINT timerMaxMs = 15;
-    DWORD_PTR processAffinityMask = 0;
-    DWORD_PTR systemAffinityMask = 0;
+    CpuSet processAffinity; // includes isolated CPUs on Linux
+    CpuSet systemAffinity;
+    std::string cpuModel;
+    std::string osBuild;
+};
+
+// Sleep(1) overshoot distribution of one calibration probe.
+struct OvershootStats {
+    int samples = 0; // 0: the probe did not run (e.g. could not pin)
+    double p50Us = 0.0;
+    double p95Us = 0.0;
+    double p99Us = 0.0;
+    double maxUs = 0.0;
+};
+
+struct CoreCalibration {
+    int cpu = -1;
+    bool probed = false; // false: an earlier wave already settled the choice
+    OvershootStats overshoot;
+    std::vector<double> samples; // raw overshoots (us) behind `overshoot`
+    NoiseStats noise;            // noise.cpu < 0: not noise-probed
+};
+
+// Outcome of a sequential test that a p95 overshoot gain exceeds a threshold.
+// [lowUs, highUs] is a distribution-free interval at
+// DeviceTuner::kRequiredConfidence; `confidence` is the widest level at which
+// the interval still lies on one side of the threshold. Both hold across every
+// look the sequential test may take, not just the last one.
+struct GainEstimate {
+    int verdict = 0; // +1 gain >= threshold, -1 gain < threshold, 0 undecided
+    double gainUs = 0.0;
+    double lowUs = 0.0;
+    double highUs = 0.0;
+    double confidence = 0.0;
 };
 
 struct CalibrationResult {
@@ -22,37 +66,132 @@ struct CalibrationResult {
     bool timerBoostHelps = false;
     double sleepP95OvershootUs_NoBoost = 0.0;
     double sleepP95OvershootUs_Boost = 0.0;
+    GainEstimate timerBoost;
+    int boostSamples = 0;
 
     bool affinityHelps = false;
-    DWORD_PTR bestAffinityMask = 0;
+    CpuSet bestAffinity;
     double sleepP95OvershootUs_BestCore = 0.0;
     double sleepP95OvershootUs_DefaultCore = 0.0;
+    GainEstimate affinity;
+
+    // Core chosen from the topology candidates (-1 if none was probed) and
+    // why: its topology traits plus the measured comparison.
+    int bestCpu = -1;
+    int candidatesProbed = 0;
+    int noiseCompared = 0; // cores tied on overshoot, decided by NoiseProbe
+    std::string affinityReason;
+
+    // Every probed core in candidate order, how many concurrent waves that
+    // took, and the wall time of the whole calibration.
+    std::vector<CoreCalibration> cores;
+    int probeWaves = 0;
+    double calibrationMs = 0.0;
+
+    // Loaded from CalibrationCache instead of measured by this process
+    // (raw per-core samples are not persisted), and when it was measured.
+    bool fromCache = false;
+    long long measuredAt = 0; // unix seconds
 };
 
+using CalibrationListener = std::function<void(const CalibrationResult&)>;
+
 class DeviceTuner {
 public:
+    // Confidence a calibration gain must reach before ComputeConfig acts on it.
+    static constexpr double kRequiredConfidence = 0.95;
+
     static DeviceProfile CollectProfile();
-    static CalibrationResult Calibrate(const DeviceProfile& p);
 
+    // Just DeviceProfile::onBattery, cheap enough to poll.
+    static bool OnBattery();
+
+    // Blocking measurement. `progress`, if set, gets the partial result
+    // (affinity settled, measured == false) before the timer boost pass.
+    // Setting `cancel` ends it within one check interval (or noise window);
+    // the result then has measured == false.
+    static CalibrationResult Calibrate(const DeviceProfile& p,
+                                       const CalibrationListener& progress = nullptr,
+                                       const std::atomic<bool>* cancel = nullptr);
+
+    // Non-blocking: collects the profile and loads a fresh cached result if
+    // there is one, else starts calibrating on a background worker. Until
+    // that publishes, Calibration() is profile-only (nothing measured) and
+    // ComputeConfigCached() leaves the calibrated settings off.
     static void EnsureCached();
-    static const DeviceProfile& Profile();
-    static const CalibrationResult& Calibration();
+    static DeviceProfile Profile();
+    static CalibrationResult Calibration();
+
+    // Blocks until a complete (measured) result is available.
+    static CalibrationResult WaitForCalibration();
 
-    static InputThread::Config ComputeConfig(SettingsDialog::Mode mode,
+    // Called on the worker thread with each refined result: the affinity
+    // stage, the complete result, and the later idle re-measurement.
+    static void SetCalibrationListener(CalibrationListener listener);
+
+    // The tier TuningMode::Recommend stands for on this device: Light on
+    // battery, Max on strong CPUs with 16 GB+, Medium on 4+ CPUs with 8 GB+.
+    static TuningMode RecommendedMode(const DeviceProfile& p);
+
+    static InputThread::Config ComputeConfig(TuningMode mode,
                                             const DeviceProfile& p,
                                             const CalibrationResult& c);
 
-    static InputThread::Config ComputeConfigCached(SettingsDialog::Mode mode);
+    static InputThread::Config ComputeConfigCached(TuningMode mode);
+
+    // True when the settings ComputeConfig derives from calibration (timer
+    // boost, affinity, process priority) are the same in both configs.
+    static bool SameCalibratedSettings(const InputThread::Config& a, const InputThread::Config& b);
+
+    // What a result without the timer boost pass (measured == false) may
+    // take from `refined`: only the affinity. The timer boost and process
+    // priority stay as in `current` until the complete result.
+    static InputThread::Config ApplyPartialCalibration(const InputThread::Config& current,
+                                                       const InputThread::Config& refined);
+
+    // Measures now, ignoring CalibrationCache, and stores the result.
+    static void Recalibrate();
+
+    // Cancels a running background calibration and joins the worker; none
+    // is started afterwards. Call before exit.
+    static void StopCalibration();
+
+    // Runs NoiseProbe on each CPU, pinned, concurrently in waves that never
+    // share a physical core. Unpinnable CPUs come back with cpu == -1.
+    static std::vector<NoiseStats> MeasureNoise(const CpuTopology& topo,
+                                                const std::vector<uint32_t>& cpus,
+                                                double windowMs,
+                                                double thresholdUs = NoiseProbe::kDefaultThresholdUs,
+                                                const std::atomic<bool>* cancel = nullptr);
 
     // Keep performance-first but never violate current power state safety.
     static InputThread::Config NormalizeForCurrentState(const InputThread::Config& cfg);
 
 private:
-    static DWORD ReadCpuMHzFromRegistry();
+    static DWORD ReadCpuMHz();
     static void ReadTimerCaps(UINT& minMs, UINT& maxMs);
-    static double MeasureSleepP95OvershootUs(int iterations);
+    static std::string ReadCpuModel();
+    static std::string ReadOsBuild();
+
+    // One Sleep(1) overshoot sample (us), and the distribution of many.
+    static double SleepOvershootUs();
+    static OvershootStats Summarize(std::vector<double> overs);
+
+    // Tests p95(before) - p95(after) >= threshold on the samples so far, as
+    // one of at most `looks` tests whose verdicts may stop the calibration:
+    // the error budget 1 - kRequiredConfidence is split evenly over them.
+    static GainEstimate EstimateGain(std::vector<double> before,
+                                     std::vector<double> after,
+                                     double threshold,
+                                     int looks = 1);
 
-    static DWORD_PTR LowestBit(DWORD_PTR mask);
-    static DWORD_PTR HighestBit(DWORD_PTR mask);
-    static double MeasureSleepP95OnMask(DWORD_PTR mask, int iterations);
+    // Probes every CPU concurrently, one pinned thread each, in waves that
+    // never put two threads on one physical core, against an unpinned
+    // baseline that samples throughout. Each wave ends as soon as its gains
+    // are settled; a core that clearly helps ends the whole probe.
+    static std::vector<CoreCalibration> ProbeCores(const CpuTopology& topo,
+                                                   const std::vector<uint32_t>& cpus,
+                                                   std::vector<double>* unpinned,
+                                                   int* waves,
+                                                   const std::atomic<bool>* cancel);
 };
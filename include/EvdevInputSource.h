@@ -0,0 +1,64 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "InputSource.h"
+
+// Linux evdev: epoll over /dev/input/event* (or caller-supplied fds), with
+// non-blocking reads of struct input_event. An eventfd makes Wait()
+// interruptible from other threads.
+class EvdevInputSource : public InputSource {
+public:
+    // Opens every readable /dev/input/event* node.
+    EvdevInputSource();
+    // Opens the given device nodes.
+    explicit EvdevInputSource(std::vector<std::string> paths);
+    // Uses already-open fds (any fd yielding struct input_event records). The
+    // caller keeps ownership; they are switched to non-blocking mode.
+    explicit EvdevInputSource(const std::vector<int>& fds);
+    ~EvdevInputSource() override;
+
+    const wchar_t* Name() const override { return L"evdev"; }
+
+    bool Open() override;
+    void Close() override;
+    WaitResult Wait(int timeoutMs) override;
+    int Read(InputEvent* out, int max) override;
+    void Wake() override;
+
+    size_t DeviceCount() const { return devices_.size(); }
+
+    // epoll_wait() + read() calls issued by Wait()/Read() so far.
+    uint64_t SyscallCount() const { return syscalls_; }
+
+    // Sorted /dev/input/event* paths.
+    static std::vector<std::string> ScanDevices();
+
+    // Kernel event stamps default to CLOCK_REALTIME; switch them to the
+    // measurer's clock so delivery latency is a plain subtraction. Fails
+    // harmlessly on fds that are not evdev nodes.
+    static void UseMonotonicStamps(int fd);
+
+private:
+    struct Device {
+        int fd = -1;
+        bool owned = false;
+        std::string path;
+    };
+
+    bool AddDevice(int fd, bool owned, const std::string& path);
+    void DropDevice(size_t index);
+
+    std::vector<std::string> paths_;
+    std::vector<int> external_fds_;
+    bool scan_ = false;
+
+    std::vector<Device> devices_;
+    int epoll_fd_ = -1;
+    int wake_fd_ = -1;
+
+    // Devices reported readable by the last Wait(), consumed by Read().
+    std::vector<size_t> ready_;
+    size_t ready_pos_ = 0;
+
+    uint64_t syscalls_ = 0;
+};
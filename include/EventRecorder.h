@@ -0,0 +1,128 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "EventRecording.h"
+#include "InputSource.h"
+
+// Always-available per-event recorder behind InputThread. The input thread
+// only copies raw records into a single-producer ring (allocated by the first
+// Start(), so an idle recorder costs nothing); a writer thread encodes them
+// into .ilorec column blocks (see EventRecording.h) and appends the blocks to
+// a memory-mapped file. When the ring is full, events are counted as dropped
+// rather than blocking the input thread.
+class EventRecorder {
+public:
+    EventRecorder();
+    ~EventRecorder();
+
+    EventRecorder(const EventRecorder&) = delete;
+    EventRecorder& operator=(const EventRecorder&) = delete;
+
+    // Control thread. Start() replaces any recording in progress.
+    bool Start(const std::string& path);
+    void Stop();
+    bool IsActive() const { return active_.load(std::memory_order_relaxed); }
+
+    // Input thread only: one read's events, with the measurer ticks at which
+    // the read finished and how long it took.
+    void Append(const InputEvent* events, int n, int64_t endTicks, int64_t readTicks) {
+        if (!active_.load(std::memory_order_acquire)) return;
+
+        uint64_t head = head_.load(std::memory_order_relaxed);
+        const uint64_t tail = tail_.load(std::memory_order_acquire);
+        const uint16_t batch = static_cast<uint16_t>(n > 0xFFFF ? 0xFFFF : n);
+
+        for (int i = 0; i < n; i++) {
+            if (head - tail >= kCapacity) {
+                dropped_.fetch_add(static_cast<uint64_t>(n - i), std::memory_order_relaxed);
+                break;
+            }
+            Pending& p = ring_[head & kMask];
+            p.endTicks = endTicks;
+            p.readTicks = readTicks;
+            p.stampNs = events[i].timestampNs;
+            p.device = events[i].device;
+            p.type = events[i].type;
+            p.batch = batch;
+            head++;
+        }
+        head_.store(head, std::memory_order_release);
+    }
+
+    const std::string& Path() const { return path_; }
+    uint64_t Recorded() const { return recorded_.load(std::memory_order_relaxed); }
+    uint64_t Dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    struct Pending {
+        int64_t endTicks;
+        int64_t readTicks;
+        uint64_t stampNs;
+        uint64_t device;
+        uint16_t type;
+        uint16_t batch;
+    };
+
+    // Run-length column: (varint value, varint run) pairs.
+    struct RunColumn {
+        std::vector<uint8_t> bytes;
+        uint64_t value = 0;
+        uint64_t run = 0;
+
+        void Add(uint64_t v);
+        void Finish();
+        void Clear();
+    };
+
+    static constexpr size_t kCapacity = size_t(1) << 16; // ~0.5 s at 4 x 32 kHz
+    static constexpr uint64_t kMask = kCapacity - 1;
+    static constexpr uint32_t kBlockRecords = 4096;
+
+    void WriterProc();
+    void Drain();
+    void Encode(const Pending& p);
+    bool WriteBlock();
+    bool Reserve(size_t bytes);
+    bool MapFile(size_t bytes);
+    void UnmapFile();
+    void CloseFile();
+    RecordingHeader* Header() { return reinterpret_cast<RecordingHeader*>(map_); }
+
+    std::vector<Pending> ring_;
+    std::atomic<uint64_t> head_{0}; // written by the input thread
+    std::atomic<uint64_t> tail_{0}; // written by the writer thread
+    std::atomic<bool> active_{false};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<uint64_t> recorded_{0};
+
+    std::thread writer_;
+    std::mutex writer_mutex_;
+    std::condition_variable writer_cv_;
+    bool stop_requested_ = false;
+
+    // Writer thread state.
+    std::string path_;
+    int64_t frequency_ = 0;
+    uint64_t start_ns_ = 0;
+    uint64_t last_arrival_units_ = 0;
+    uint32_t block_count_ = 0;
+    std::vector<uint8_t> arrival_col_;
+    std::vector<uint8_t> latency_col_;
+    RunColumn device_col_;
+    RunColumn type_col_;
+    RunColumn batch_col_;
+
+    uint8_t* map_ = nullptr;
+    size_t map_size_ = 0;
+#ifdef _WIN32
+    void* file_ = nullptr;    // HANDLE
+    void* mapping_ = nullptr; // HANDLE
+#else
+    int fd_ = -1;
+#endif
+};
@@ -0,0 +1,153 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Per-event session recording (.ilorec), written by EventRecorder.
+//
+//   header (64 bytes, see RecordingHeader)
+//   block*: u32 'ILOB' | u32 count | u32 column bytes[5] | columns
+//
+// Columns, in order:
+//   0 arrival  varint delta from the previous record, in arrivalUnitNs
+//              (the first record of the file is relative to startNs)
+//   1 latency  varint bucket of the latency in latencyUnitNs: exact below 8,
+//              then 8 linear sub-buckets per power of two (12.5% wide, as in
+//              the per-device histograms); decoded to the bucket midpoint.
+//              Version 1 files store the plain value.
+//   2 device   run-length (varint value, varint run)
+//   3 type     run-length
+//   4 batch    run-length
+//
+// Events of one read share their arrival time and batch size, device and type
+// rarely change, and latencies below ~1 ms take one bucket byte, so a record
+// costs ~2 bytes (about 60 MB per hour of 8 kHz input). evdev reports
+// interleave event types (REL, REL, SYN), which adds about a byte. bytesUsed
+// in the header is advanced after each complete block, so a file cut short by
+// a crash still reads up to its last block.
+struct RecordingHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t startNs;       // measurer clock at recording start
+    uint32_t arrivalUnitNs;
+    uint32_t latencyUnitNs;
+    uint64_t bytesUsed;     // header + complete blocks
+    uint64_t recordCount;
+    uint64_t dropped;       // events lost to a full hot-path buffer
+    uint64_t reserved;
+};
+
+static_assert(sizeof(RecordingHeader) == 64, "recording header layout");
+
+constexpr uint32_t kRecordingVersion = 2;
+constexpr uint32_t kRecordingBlockMagic = 0x424F4C49; // "ILOB"
+constexpr int kRecordingColumns = 5;
+
+// One decoded record.
+struct EventRecord {
+    uint64_t arrivalNs;  // read completion, measurer clock
+    uint64_t latencyNs;  // source stamp -> read completion, else read duration
+    uint64_t device;
+    uint16_t type;
+    uint16_t batch;      // events returned by the read this event came from
+};
+
+namespace RecordingVarint {
+
+inline void Put(std::vector<uint8_t>& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<uint8_t>(v) | 0x80);
+        v >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(v));
+}
+
+// Returns false on truncated input.
+inline bool Get(const uint8_t*& p, const uint8_t* end, uint64_t& v) {
+    v = 0;
+    for (int shift = 0; p < end && shift < 64; shift += 7) {
+        const uint8_t b = *p++;
+        v |= static_cast<uint64_t>(b & 0x7F) << shift;
+        if ((b & 0x80) == 0) return true;
+    }
+    return false;
+}
+
+} // namespace RecordingVarint
+
+namespace RecordingLatency {
+
+constexpr int kSubBuckets = 8;
+
+inline uint64_t Bucket(uint64_t units) {
+    if (units < kSubBuckets) return units;
+    int shift = 0;
+    while ((units >> shift) >= 2 * kSubBuckets) shift++;
+    return static_cast<uint64_t>(shift + 1) * kSubBuckets + ((units >> shift) & (kSubBuckets - 1));
+}
+
+// Midpoint of the bucket, in units.
+inline uint64_t Value(uint64_t bucket) {
+    if (bucket < kSubBuckets) return bucket;
+    const uint64_t shift = bucket / kSubBuckets - 1;
+    if (shift > 59) return UINT64_MAX;
+    const uint64_t low = (kSubBuckets + bucket % kSubBuckets) << shift;
+    return low + ((uint64_t(1) << shift) - 1) / 2;
+}
+
+} // namespace RecordingLatency
+
+// Sequential decoder over a memory-mapped recording.
+class EventRecordingReader {
+public:
+    EventRecordingReader() = default;
+    ~EventRecordingReader();
+
+    EventRecordingReader(const EventRecordingReader&) = delete;
+    EventRecordingReader& operator=(const EventRecordingReader&) = delete;
+
+    bool Open(const std::string& path);
+    void Close();
+
+    const RecordingHeader& Header() const { return header_; }
+
+    // Decodes the next record; false at the end of the recorded data or on
+    // a corrupt block.
+    bool Next(EventRecord& out);
+
+private:
+    bool LoadBlock();
+
+    struct RunColumn {
+        const uint8_t* p = nullptr;
+        const uint8_t* end = nullptr;
+        uint64_t value = 0;
+        uint64_t left = 0;
+
+        bool Next(uint64_t& v);
+    };
+
+    const uint8_t* base_ = nullptr;
+    size_t size_ = 0;         // parse limit (bytesUsed)
+#ifdef _WIN32
+    void* file_ = nullptr;    // HANDLE
+    void* mapping_ = nullptr; // HANDLE
+#else
+    size_t mapped_size_ = 0;  // whole file, for munmap
+#endif
+
+    RecordingHeader header_{};
+    size_t offset_ = 0;
+
+    uint32_t block_left_ = 0;
+    const uint8_t* arrival_ = nullptr;
+    const uint8_t* arrival_end_ = nullptr;
+    const uint8_t* latency_ = nullptr;
+    const uint8_t* latency_end_ = nullptr;
+    RunColumn device_;
+    RunColumn type_;
+    RunColumn batch_;
+    uint64_t arrival_units_ = 0;
+};
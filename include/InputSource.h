@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+
+class PreciseWaiter;
+
+// One input report as delivered by the OS.
+struct InputEvent {
+    uint64_t timestampNs = 0; // source timestamp on the measurer's clock, 0 if unknown
+    uint64_t device = 0;      // HANDLE value (Raw Input) or fd (evdev)
+    uint16_t type = 0;        // RIM_TYPE* / EV_*
+    uint16_t code = 0;
+    int32_t value = 0;
+};
+
+// Where InputThread::ThreadProc gets its events from. Open/Close/Wait/Read are
+// called on the input thread only; Wake may be called from any thread.
+class InputSource {
+public:
+    enum class WaitResult { Ready, Timeout, Exit };
+
+    virtual ~InputSource() = default;
+
+    virtual const wchar_t* Name() const = 0;
+
+    virtual bool Open() = 0;
+    virtual void Close() = 0;
+
+    // Blocks until input is pending, timeoutMs elapses (-1 = forever) or Wake().
+    virtual WaitResult Wait(int timeoutMs) = 0;
+
+    // Reads up to `max` pending events without blocking. Returns the number
+    // read (0 if the wakeup carried no input), or -1 if the source failed.
+    virtual int Read(InputEvent* out, int max) = 0;
+
+    // Makes the current or next Wait() return Exit.
+    virtual void Wake() = 0;
+
+    // Sources that wait for their own deadlines (replay) do it through a
+    // PreciseWaiter; InputThread seeds its margin and reports what it cost.
+    virtual PreciseWaiter* Waiter() { return nullptr; }
+};
+
+// Raw Input on Windows, evdev on Linux.
+std::unique_ptr<InputSource> CreateDefaultInputSource();
@@ -1,33 +1,82 @@
 #pragma once
-#ifndef NOMINMAX
-#define NOMINMAX
-#endif
-#include <windows.h>
+#include "Platform.h"
+#include <cstdint>
 #include <string>
 #include <atomic>
 #include <thread>
+#include <memory>
 #include <mutex>
+#include <utility>
 #include <vector>
+#include "BusyPoller.h"
+#include "CpuSet.h"
+#include "DeviceStats.h"
+#include "EventRecorder.h"
+#include "InputSource.h"
 #include "LatencyMeasurer.h"
 
 class InputThread {
 public:
+    // Linux scheduling class for the input thread (see Config::schedPolicy).
+    enum class SchedPolicy : uint8_t { Auto, Other, Fifo, RoundRobin, Deadline };
+
     struct Config {
         bool enableTimerBoost = false;
         bool enableProcessPriority = false;
         bool enableThreadPriority = false;
 
         bool enableAffinity = false;
-        DWORD_PTR affinityMask = 0;
+        CpuSet affinity; // any CPU, any processor group (Windows: lowest group in the set)
 
         UINT timerResolutionMs = 1;
         DWORD processPriority = HIGH_PRIORITY_CLASS;
         int threadPriority = THREAD_PRIORITY_TIME_CRITICAL;
+
+        // Drain every pending event per wakeup (one read() per evdev fd,
+        // GetRawInputBuffer on Windows) instead of one event per wakeup.
+        bool enableBatchedReads = true;
+
+        // Linux only, used when enableThreadPriority is set. Auto derives the
+        // policy from threadPriority: TIME_CRITICAL -> SCHED_FIFO 80, HIGHEST ->
+        // SCHED_FIFO 50, above normal -> SCHED_RR 10, else SCHED_OTHER at
+        // niceValue. Whatever the kernel refuses (no CAP_SYS_NICE, too low
+        // RLIMIT_RTPRIO) degrades to the next weaker policy.
+        SchedPolicy schedPolicy = SchedPolicy::Auto;
+        int schedPriority = 0;       // FIFO/RR 1..99, 0 = derive from threadPriority
+        int niceValue = -10;         // SCHED_OTHER input thread; other threads when enableProcessPriority
+        UINT deadlineRuntimeUs = 100;
+        UINT deadlineDeadlineUs = 1000;
+        UINT deadlinePeriodUs = 1000;
+
+        // Linux timer boost (enableTimerBoost): timer slack of the input
+        // thread, plus a CPU idle exit-latency request held open on the PM QoS
+        // device for as long as the thread runs.
+        UINT timerSlackNs = 1;
+        UINT pmQosLatencyUs = 0;
+
+        // Linux "Max+" (opt-in, see BusyPoller): poll the input source without
+        // blocking instead of sleeping in epoll_wait, so events skip the wakeup
+        // and scheduling delay. Polling may use busyPollBudget of one CPU and
+        // stops on battery. Pin the thread (enableAffinity) when using it.
+        bool enableBusyPoll = false;
+        double busyPollBudget = 0.5;
+
+        // Expected sleep overshoot seeding the source's PreciseWaiter margin
+        // (DeviceTuner's calibrated p95); 0 = let the waiter learn it.
+        double waitOvershootUs = 0.0;
     };
 
     InputThread();
     ~InputThread();
 
+    // Replaces the event source (default: Raw Input on Windows, evdev on
+    // Linux). Only takes effect while the thread is stopped.
+    void SetInputSource(std::unique_ptr<InputSource> source);
+
+    // Linux: PM QoS device used by the timer boost (default
+    // /dev/cpu_dma_latency). Only takes effect while the thread is stopped.
+    void SetPmQosPath(std::string path);
+
     bool Start(const Config& config);
     void Stop();
 
@@ -38,44 +87,102 @@ public:
     void UpdateConfig(const Config& newConfig);
 
     LatencyMeasurer& GetMeasurer() { return measurer_; }
+    LatencySnapshot GetLatencySnapshot() const { return measurer_.Snapshot(); }
     std::wstring GetStatus() const;
 
+    // Statistics per source device (count, report rate, jitter, latency).
+    DeviceStatsTable& GetDeviceStats() { return device_stats_; }
+    DeviceStatsSnapshot GetDeviceSnapshot() const { return device_stats_.Snapshot(); }
+
+    // Per-event .ilorec recording (see EventRecorder); independent of Start/Stop.
+    bool StartRecording(const std::string& path) { return recorder_.Start(path); }
+    void StopRecording() { recorder_.Stop(); }
+    bool IsRecording() const { return recorder_.IsActive(); }
+
 private:
+    static constexpr int kIdlePublishMs = 100;
+    static constexpr int kReadBatch = 64;
+
     void ThreadProc();
-    bool CreateHiddenWindow();
-    void DestroyHiddenWindow();
-    bool InitializeRawInput(HWND hwnd);
     void Cleanup();
 
+    // Apply*() run with settings_mutex_ held; RestoreSystemSettings() takes it.
+    void ApplySystemSettings();
     void ApplyThreadPriority();
     void ApplyProcessPriority();
     void ApplyTimerResolution();
     void ApplyAffinity();
     void RestoreSystemSettings();
 
-    static LRESULT CALLBACK HiddenWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
-
     std::thread thread_;
+#ifdef _WIN32
     HANDLE thread_handle_ = nullptr;
-    DWORD thread_id_ = 0;
+
+    HANDLE hMmcss_ = nullptr;
+    DWORD mmcss_task_index_ = 0;
+#else
+    std::atomic<int> thread_tid_{0};
+
+    // Scheduling attributes as read/written with sched_getattr/sched_setattr.
+    struct SchedState {
+        uint32_t policy = 0;
+        int32_t nice = 0;
+        uint32_t priority = 0;
+        uint64_t runtimeNs = 0;
+        uint64_t deadlineNs = 0;
+        uint64_t periodNs = 0;
+    };
+
+    bool ApplySched(int tid, const SchedState& want);
+    std::wstring SchedulingText() const;
+
+    bool original_sched_saved_ = false;
+    SchedState original_sched_{};
+    bool sched_applied_ = false;
+
+    // What the kernel accepted, for GetStatus().
+    std::atomic<uint32_t> effective_policy_{0};
+    std::atomic<int> effective_level_{0}; // RT priority, or nice for SCHED_OTHER
+    std::atomic<uint32_t> requested_policy_{0};
+
+    void ApplyTimerSlack();
+
+    std::string pm_qos_path_ = "/dev/cpu_dma_latency";
+    int pm_qos_fd_ = -1;
+    std::atomic<int> pm_qos_applied_us_{-1};
+
+    // prctl(PR_SET_TIMERSLACK) only affects the calling thread, so changes
+    // requested from other threads are applied by ThreadProc.
+    std::atomic<bool> timer_slack_pending_{false};
+    bool original_slack_saved_ = false;
+    unsigned long original_slack_ns_ = 0;
+    std::atomic<unsigned long> applied_slack_ns_{0};
+
+    std::vector<std::pair<int, int>> original_task_nice_; // tid, nice
+    std::atomic<int> process_nice_applied_{0};
+    std::atomic<int> process_nice_threads_{0};
+
+    std::atomic<bool> busy_poll_{false};
+    BusyPoller busy_poller_;
+#endif
 
     std::atomic<bool> running_{false};
     std::atomic<bool> should_exit_{false};
     std::atomic<bool> desired_running_{false};
+    std::atomic<bool> batched_reads_{true};
 
     mutable std::mutex config_mutex_;
     Config config_{};
+    std::mutex settings_mutex_; // state saved and applied by Apply*() / RestoreSystemSettings()
     LatencyMeasurer measurer_{};
+    DeviceStatsTable device_stats_;
+    EventRecorder recorder_;
 
-    HANDLE hMmcss_ = nullptr;
-    DWORD mmcss_task_index_ = 0;
-
-    HINSTANCE h_instance_ = nullptr;
-    HWND hwnd_ = nullptr;
+    std::unique_ptr<InputSource> source_;
 
     DWORD original_process_priority_ = NORMAL_PRIORITY_CLASS;
     UINT applied_timer_resolution_ms_ = 0;
 
-    DWORD_PTR original_affinity_mask_ = 0;
-    DWORD_PTR applied_affinity_mask_ = 0;
+    CpuSet original_affinity_; // empty until the first pin
+    CpuSet applied_affinity_;
 };
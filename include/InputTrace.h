@@ -0,0 +1,84 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include "InputSource.h"
+
+// Recorded input event trace (.ilotrace): a 32-byte header followed by
+// fixed-size little-endian records, so a mapped file can be indexed directly.
+//
+//   header: "ILOTRACE" | u32 version | u32 record size | u64 count | u64 reserved
+//   record: u64 timestamp ns | u64 device | u16 type | u16 code | i32 value
+//
+// Timestamps only need to be monotonic within a trace; replay uses the
+// differences from the first record.
+struct InputTraceHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+    uint64_t count;
+    uint64_t reserved;
+};
+
+struct InputTraceRecord {
+    uint64_t timestampNs;
+    uint64_t device;
+    uint16_t type;
+    uint16_t code;
+    int32_t value;
+};
+
+static_assert(sizeof(InputTraceHeader) == 32, "trace header layout");
+static_assert(sizeof(InputTraceRecord) == 24, "trace record layout");
+
+constexpr uint32_t kInputTraceVersion = 1;
+
+// Appends events to a trace file through stdio buffering. The record count in
+// the header is filled in by Close(), so an unclosed trace reads as empty.
+class InputTraceWriter {
+public:
+    InputTraceWriter() = default;
+    ~InputTraceWriter();
+
+    InputTraceWriter(const InputTraceWriter&) = delete;
+    InputTraceWriter& operator=(const InputTraceWriter&) = delete;
+
+    bool Open(const std::string& path);
+    bool Append(const InputEvent* events, size_t n);
+    bool Close();
+
+    uint64_t Count() const { return count_; }
+
+private:
+    FILE* file_ = nullptr;
+    uint64_t count_ = 0;
+};
+
+// Read-only memory mapping of a trace file.
+class MappedInputTrace {
+public:
+    MappedInputTrace() = default;
+    ~MappedInputTrace();
+
+    MappedInputTrace(const MappedInputTrace&) = delete;
+    MappedInputTrace& operator=(const MappedInputTrace&) = delete;
+
+    // Fails on a missing file, a bad header or a truncated record array.
+    bool Open(const std::string& path);
+    void Close();
+
+    const InputTraceRecord* Records() const { return records_; }
+    uint64_t Count() const { return count_; }
+
+private:
+    const void* base_ = nullptr;
+    size_t size_ = 0;
+#ifdef _WIN32
+    void* file_ = nullptr;    // HANDLE
+    void* mapping_ = nullptr; // HANDLE
+#endif
+
+    const InputTraceRecord* records_ = nullptr;
+    uint64_t count_ = 0;
+};
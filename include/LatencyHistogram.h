@@ -0,0 +1,220 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+
+// Avoid Windows.h min/max macro collisions
+#ifdef min
+#undef min
+#endif
+#ifdef max
+#undef max
+#endif
+
+
+// HDR-style log-linear histogram over non-negative integer values.
+// Every power-of-two range is split into linear sub-buckets, sized so that any
+// recorded value keeps `significantDigits` decimal digits of precision.
+// Memory is allocated once in the constructor; record() is O(1) and quantile
+// reads are a single scan over the bucket counts (no copy, no sort).
+class LatencyHistogram {
+public:
+    LatencyHistogram(uint64_t lowestDiscernible, uint64_t highestTrackable, int significantDigits) {
+        if (lowestDiscernible < 1) lowestDiscernible = 1;
+        if (highestTrackable < 2 * lowestDiscernible) highestTrackable = 2 * lowestDiscernible;
+        significantDigits = std::min(std::max(significantDigits, 1), 5);
+
+        highest_trackable_ = highestTrackable;
+        unit_magnitude_ = Log2Floor(lowestDiscernible);
+
+        uint64_t largestSingleUnit = 2;
+        for (int i = 0; i < significantDigits; i++) largestSingleUnit *= 10;
+
+        const int subBucketCountMagnitude = Log2Floor(largestSingleUnit - 1) + 1;
+        sub_bucket_half_count_magnitude_ = std::max(subBucketCountMagnitude, 1) - 1;
+        sub_bucket_count_ = int64_t(1) << (sub_bucket_half_count_magnitude_ + 1);
+        sub_bucket_half_count_ = sub_bucket_count_ / 2;
+        sub_bucket_mask_ = (uint64_t(sub_bucket_count_) - 1) << unit_magnitude_;
+
+        uint64_t smallestUntrackable = uint64_t(sub_bucket_count_) << unit_magnitude_;
+        int buckets = 1;
+        while (smallestUntrackable <= highestTrackable) {
+            if (smallestUntrackable > (UINT64_MAX >> 1)) {
+                buckets++;
+                break;
+            }
+            smallestUntrackable <<= 1;
+            buckets++;
+        }
+
+        counts_.assign(static_cast<size_t>(buckets + 1) * static_cast<size_t>(sub_bucket_half_count_), 0);
+        clear();
+    }
+
+    void record(uint64_t value) {
+        if (value > highest_trackable_) value = highest_trackable_;
+
+        counts_[IndexOf(value)]++;
+        total_++;
+        sum_ += value;
+        if (value < min_) min_ = value;
+        if (value > max_) max_ = value;
+    }
+
+    // Adds another histogram's samples. Both must be built with the same
+    // range and precision (same bucket layout).
+    void merge(const LatencyHistogram& other) {
+        if (other.empty()) return;
+        const size_t n = std::min(counts_.size(), other.counts_.size());
+        for (size_t i = 0; i < n; i++) counts_[i] += other.counts_[i];
+        total_ += other.total_;
+        sum_ += other.sum_;
+        min_ = std::min(min_, other.min_);
+        max_ = std::max(max_, other.max_);
+    }
+
+    void clear() {
+        std::fill(counts_.begin(), counts_.end(), 0);
+        total_ = 0;
+        sum_ = 0;
+        min_ = UINT64_MAX;
+        max_ = 0;
+    }
+
+    uint64_t count() const { return total_; }
+    bool empty() const { return total_ == 0; }
+
+    uint64_t min() const { return empty() ? 0 : min_; }
+    uint64_t max() const { return max_; }
+
+    double average() const {
+        if (empty()) return 0.0;
+        return static_cast<double>(sum_) / static_cast<double>(total_);
+    }
+
+    // Computed from bucket midpoints at read time, so record() stays integer-only.
+    double stddev() const {
+        if (total_ < 2) return 0.0;
+        const double mean = average();
+        double m2 = 0.0;
+        for (size_t i = 0; i < counts_.size(); i++) {
+            if (!counts_[i]) continue;
+            const uint64_t lo = ValueFromIndex(i);
+            const double mid = (static_cast<double>(lo) + static_cast<double>(HighestEquivalent(lo))) / 2.0;
+            const double d = mid - mean;
+            m2 += d * d * static_cast<double>(counts_[i]);
+        }
+        return std::sqrt(m2 / static_cast<double>(total_));
+    }
+
+    // Same convention as RingBuffer::percentile: p in [0, 1], nearest-rank.
+    // Returns the highest value equivalent to the selected bucket (clamped to
+    // the exact recorded max), so p99 never under-reports.
+    uint64_t percentile(double p) const {
+        if (empty()) return 0;
+        if (p <= 0.0) return min();
+        if (p >= 1.0) return max();
+
+        uint64_t rank = static_cast<uint64_t>(std::ceil(p * static_cast<double>(total_)));
+        if (rank == 0) rank = 1;
+
+        uint64_t seen = 0;
+        for (size_t i = 0; i < counts_.size(); i++) {
+            seen += counts_[i];
+            if (seen >= rank) {
+                return std::min(HighestEquivalent(ValueFromIndex(i)), max_);
+            }
+        }
+        return max_;
+    }
+
+    // Several quantiles in one scan. `ps` must be sorted ascending.
+    void percentiles(const double* ps, uint64_t* out, size_t n) const {
+        size_t k = 0;
+        for (; k < n && (empty() || ps[k] <= 0.0); k++) out[k] = min();
+
+        uint64_t seen = 0;
+        for (size_t i = 0; i < counts_.size() && k < n; i++) {
+            seen += counts_[i];
+            while (k < n && ps[k] < 1.0) {
+                uint64_t rank = static_cast<uint64_t>(std::ceil(ps[k] * static_cast<double>(total_)));
+                if (rank == 0) rank = 1;
+                if (seen < rank) break;
+                out[k++] = std::min(HighestEquivalent(ValueFromIndex(i)), max_);
+            }
+        }
+
+        for (; k < n; k++) out[k] = max_;
+    }
+
+    size_t bucketCount() const { return counts_.size(); }
+    size_t memoryBytes() const { return counts_.size() * sizeof(uint64_t); }
+
+private:
+    static int Log2Floor(uint64_t v) {
+        return 63 - CountLeadingZeros(v | 1);
+    }
+
+    static int CountLeadingZeros(uint64_t v) {
+#if defined(_MSC_VER)
+        unsigned long idx = 0;
+        _BitScanReverse64(&idx, v);
+        return 63 - static_cast<int>(idx);
+#else
+        return __builtin_clzll(v);
+#endif
+    }
+
+    int BucketIndexOf(uint64_t value) const {
+        const int pow2Ceiling = 64 - CountLeadingZeros(value | sub_bucket_mask_);
+        return pow2Ceiling - unit_magnitude_ - (sub_bucket_half_count_magnitude_ + 1);
+    }
+
+    int64_t SubBucketIndexOf(uint64_t value, int bucketIndex) const {
+        return static_cast<int64_t>(value >> (bucketIndex + unit_magnitude_));
+    }
+
+    size_t IndexOf(uint64_t value) const {
+        const int bucketIndex = BucketIndexOf(value);
+        const int64_t subBucketIndex = SubBucketIndexOf(value, bucketIndex);
+        const int64_t bucketBase = int64_t(bucketIndex + 1) << sub_bucket_half_count_magnitude_;
+        return static_cast<size_t>(bucketBase + (subBucketIndex - sub_bucket_half_count_));
+    }
+
+    uint64_t ValueFromIndex(size_t index) const {
+        int bucketIndex = static_cast<int>(index >> sub_bucket_half_count_magnitude_) - 1;
+        int64_t subBucketIndex = static_cast<int64_t>(index & size_t(sub_bucket_half_count_ - 1)) + sub_bucket_half_count_;
+        if (bucketIndex < 0) {
+            subBucketIndex -= sub_bucket_half_count_;
+            bucketIndex = 0;
+        }
+        return uint64_t(subBucketIndex) << (bucketIndex + unit_magnitude_);
+    }
+
+    uint64_t HighestEquivalent(uint64_t value) const {
+        const int bucketIndex = BucketIndexOf(value);
+        const int64_t subBucketIndex = SubBucketIndexOf(value, bucketIndex);
+        const int adjustedBucket = (subBucketIndex >= sub_bucket_count_) ? bucketIndex + 1 : bucketIndex;
+        const uint64_t lowest = uint64_t(subBucketIndex) << (bucketIndex + unit_magnitude_);
+        const uint64_t range = uint64_t(1) << (unit_magnitude_ + adjustedBucket);
+        return lowest + range - 1;
+    }
+
+    std::vector<uint64_t> counts_;
+    uint64_t highest_trackable_ = 0;
+    int unit_magnitude_ = 0;
+    int sub_bucket_half_count_magnitude_ = 0;
+    int64_t sub_bucket_count_ = 0;
+    int64_t sub_bucket_half_count_ = 0;
+    uint64_t sub_bucket_mask_ = 0;
+
+    uint64_t total_ = 0;
+    uint64_t sum_ = 0;
+    uint64_t min_ = UINT64_MAX;
+    uint64_t max_ = 0;
+};
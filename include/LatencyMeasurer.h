@@ -1,31 +1,240 @@
 #pragma once
-#ifndef NOMINMAX
-#define NOMINMAX
-#endif
-#include <windows.h>
+#include <atomic>
 #include <cstdint>
+#include <memory>
+#include <mutex>
 #include "RingBuffer.h"
+#include "LatencyHistogram.h"
+#include "QuantileSketch.h"
+#include "SeqLock.h"
 
-class LatencyMeasurer {
+// Summary of one latency metric, in microseconds.
+struct LatencyStats {
+    uint64_t count = 0;
+    double minUs = 0.0;
+    double avgUs = 0.0;
+    double jitterUs = 0.0;
+    double p50Us = 0.0;
+    double p95Us = 0.0;
+    double p99Us = 0.0;
+    double p999Us = 0.0;
+    double maxUs = 0.0;
+};
+
+// Events returned per InputSource::Read() call. Totals are cumulative since
+// the last reset; avg/max cover the last 1000 reads.
+struct ReadBatchStats {
+    uint64_t reads = 0;
+    uint64_t events = 0;
+    double avgBatch = 0.0;
+    uint32_t maxBatch = 0;
+};
+
+// Immutable view of the measurer's statistics, built by Snapshot() on the
+// reading thread from the samples the measuring thread has handed off.
+struct LatencySnapshot {
+    LatencyStats processing; // time spent reading the event (Start/EndMeasurement)
+    LatencyStats delivery;   // source timestamp -> consumed (sources that stamp events)
+    ReadBatchStats reads;
+};
+
+// Sample storage policies for BasicLatencyMeasurer.
+//
+// MicrosecondSamples: every sample is converted to double microseconds when it
+// is recorded (the original behaviour).
+// TickSamples: raw clock deltas (QPC ticks on Windows, CLOCK_MONOTONIC ns on
+// Linux) are stored as uint32_t ticks and only converted
+// to microseconds when statistics are read. Halves the ring's sample storage and keeps
+// floating-point work off the input thread for the Ring and Histogram backends.
+struct MicrosecondSamples {
+    using value_type = double;
+
+    static value_type FromTicks(int64_t ticks, int64_t freq) {
+        return (ticks * 1000000.0) / static_cast<double>(freq);
+    }
+
+    // Histogram records integer nanoseconds.
+    static uint64_t HistogramValue(int64_t ticks, int64_t freq) {
+        const double ns = (ticks * 1000000000.0) / static_cast<double>(freq);
+        return ns > 0 ? static_cast<uint64_t>(ns + 0.5) : 0;
+    }
+
+    static uint64_t HistogramUnitsPerSecond(int64_t) { return 1000000000ull; }
+    static double HistogramUnitUs(int64_t) { return 0.001; }
+    static double ValueUs(double v, int64_t) { return v; }
+};
+
+struct TickSamples {
+    using value_type = uint32_t;
+
+    static value_type FromTicks(int64_t ticks, int64_t) {
+        if (ticks <= 0) return 0;
+        if (ticks > static_cast<int64_t>(UINT32_MAX)) return UINT32_MAX;
+        return static_cast<value_type>(ticks);
+    }
+
+    static uint64_t HistogramValue(int64_t ticks, int64_t) {
+        return ticks > 0 ? static_cast<uint64_t>(ticks) : 0;
+    }
+
+    static uint64_t HistogramUnitsPerSecond(int64_t freq) { return static_cast<uint64_t>(freq); }
+    static double HistogramUnitUs(int64_t freq) { return 1000000.0 / static_cast<double>(freq); }
+    static double ValueUs(double v, int64_t freq) { return v * 1000000.0 / static_cast<double>(freq); }
+};
+
+template<typename SamplePolicy>
+class BasicLatencyMeasurer {
 public:
-    LatencyMeasurer();
-    ~LatencyMeasurer() = default;
+    using sample_type = typename SamplePolicy::value_type;
 
+    // Ring keeps the last 1000 samples (O(1) min/avg/jitter, sorted copy for
+    // quantiles).
+    // Histogram records in O(1) into fixed log-linear buckets.
+    // Sketch keeps a t-digest over the whole session in bounded memory.
+    enum class Backend { Ring, Histogram, Sketch };
+
+    explicit BasicLatencyMeasurer(Backend backend = Backend::Histogram);
+    ~BasicLatencyMeasurer() = default;
+
+    // Measuring thread only. EndMeasurement() hands the samples recorded so
+    // far to readers at most once per publish interval (50 ms). The hand-off
+    // is a swap of the backend storage, skipped while a reader is still busy
+    // with the previous batch; quantiles and stddev are left to Snapshot().
     void StartMeasurement();
     void EndMeasurement();
 
-    double GetMinLatency() const { return latencies_.min(); }
-    double GetAvgLatency() const { return latencies_.average(); }
-    double GetP95Latency() const { return latencies_.percentile(0.95); }
-    double GetP99Latency() const { return latencies_.percentile(0.99); }
-    size_t GetSampleCount() const { return latencies_.size(); }
+    // Measuring thread only, after EndMeasurement(): records how long an event
+    // waited between its source timestamp (ns on the measurer's clock, i.e.
+    // the evdev kernel stamp under EVIOCSCLOCKID CLOCK_MONOTONIC) and the end
+    // of the read that consumed it. Stamps from another clock are dropped.
+    void RecordDelivery(uint64_t eventTimestampNs);
+
+    // Measuring thread only: number of events the last read returned.
+    void RecordBatch(uint32_t events);
+
+    // Measuring thread only: the last Start/EndMeasurement pair, in ticks.
+    int64_t LastEndTicks() const { return end_time_; }
+    int64_t LastElapsedTicks() const { return end_time_ - start_time_; }
+
+    // Measuring thread only: publishes pending samples (and applies a pending
+    // RequestReset()) when events stop arriving. Call from an idle timer.
+    void PublishIfDirty();
 
-    void Reset() { latencies_.clear(); }
+    // Measuring thread only, before it exits: hands off everything recorded,
+    // merging a batch no reader has collected yet instead of skipping.
+    void Flush();
+
+    // Any thread. Merges the samples handed off since the last call and
+    // summarizes them on the caller's thread; the producer never waits on it.
+    // The next hand-off only happens once this call has emptied the slot, so
+    // a reader polling every T sees samples up to about T old (all of them
+    // once the thread has stopped).
+    LatencySnapshot Snapshot() const;
+
+    // Any thread: clears the statistics on the measuring thread's next
+    // EndMeasurement() or PublishIfDirty().
+    void RequestReset() { reset_requested_.store(true, std::memory_order_release); }
+
+    // Processing-time statistics of the samples handed off so far, as in
+    // Snapshot(); any thread. All results are in microseconds regardless of
+    // the storage policy.
+    double GetMinLatency() const { return Snapshot().processing.minUs; }
+    double GetAvgLatency() const { return Snapshot().processing.avgUs; }
+    double GetMaxLatency() const { return Snapshot().processing.maxUs; }
+    double GetJitterLatency() const { return Snapshot().processing.jitterUs; } // standard deviation
+    double GetP95Latency() const { return Snapshot().processing.p95Us; }
+    double GetP99Latency() const { return Snapshot().processing.p99Us; }
+    double GetP999Latency() const { return Snapshot().processing.p999Us; }
+    double GetPercentileLatency(double p) const;
+    size_t GetSampleCount() const { return static_cast<size_t>(Snapshot().processing.count); }
+
+    Backend GetBackend() const { return backend_; }
+
+    // While the measuring thread is stopped: drop every collected sample.
+    void SetBackend(Backend backend);
+    void Reset();
 
     static double GetCurrentTimeUs();
 
+    // The measurer's clock: QueryPerformanceCounter on Windows,
+    // CLOCK_MONOTONIC (ns) elsewhere.
+    static int64_t ReadTicks();
+    static int64_t TickFrequency();
+
 private:
-    LARGE_INTEGER frequency_{};
-    LARGE_INTEGER start_time_{};
-    RingBuffer<double, 1000> latencies_;
+    // One latency metric. Only the selected backend's storage exists; the
+    // others are released when the backend changes.
+    class Series {
+    public:
+        Series(Backend b, int64_t freq);
+
+        void Select(Backend b, int64_t freq); // drops collected samples
+        void Record(int64_t ticks, int64_t freq);
+        void Clear();
+
+        // Adds `batch` (same backend and clock) and clears it. The ring keeps
+        // its window: batch samples are pushed oldest first.
+        void Absorb(Series& batch);
+
+        double Min(int64_t freq) const;
+        double Avg(int64_t freq) const;
+        double Max(int64_t freq) const;
+        double Jitter(int64_t freq) const;
+        double Percentile(double p, int64_t freq) const;
+        size_t Count() const;
+
+        LatencyStats Summarize(int64_t freq) const;
+
+    private:
+        Backend backend_ = Backend::Histogram;
+        std::unique_ptr<StatsRingBuffer<sample_type, 1000>> latencies_;
+        std::unique_ptr<LatencyHistogram> histogram_;
+        std::unique_ptr<QuantileSketch> sketch_;
+    };
+
+    void Publish(int64_t now);
+    void ApplyPendingReset();
+    void ResetRecorded();
+    void DrainPending() const; // exchange_mutex_ held
+
+    int64_t frequency_ = 0;
+    int64_t start_time_ = 0;
+    int64_t end_time_ = 0;
+    int64_t max_delivery_ticks_ = 0;
+    int64_t publish_interval_ = 0;
+    int64_t last_publish_ = 0;
+    bool dirty_ = false;
+    std::atomic<bool> reset_requested_{false};
+
+    // Measuring thread: samples since the last hand-off, and a count of
+    // resets so readers know to drop what they merged before one.
+    Backend backend_ = Backend::Histogram;
+    Series processing_;
+    Series delivery_;
+    uint64_t epoch_ = 0;
+
+    // Hand-off slot: filled by Publish() (try_lock only) when empty, emptied
+    // into the merged series by readers.
+    mutable std::mutex exchange_mutex_;
+    mutable Series pending_processing_;
+    mutable Series pending_delivery_;
+    mutable bool pending_full_ = false;
+    mutable uint64_t pending_epoch_ = 0;
+
+    // Readers: everything handed off since the last reset.
+    mutable Series merged_processing_;
+    mutable Series merged_delivery_;
+    mutable uint64_t merged_epoch_ = 0;
+
+    SeqLock<ReadBatchStats> reads_;
+
+    StatsRingBuffer<uint32_t, 1000> batch_sizes_;
+    uint64_t batch_reads_ = 0;
+    uint64_t batch_events_ = 0;
 };
+
+using LatencyMeasurer = BasicLatencyMeasurer<MicrosecondSamples>;
+using TickLatencyMeasurer = BasicLatencyMeasurer<TickSamples>;
+
+extern template class BasicLatencyMeasurer<MicrosecondSamples>;
+extern template class BasicLatencyMeasurer<TickSamples>;
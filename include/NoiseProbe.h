@@ -0,0 +1,35 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+// OS noise seen by one CPU over a window: the calling thread spins reading
+// the measurer's clock, and every gap between two consecutive reads above
+// the threshold is time the CPU spent elsewhere (an interrupt, SMI, or
+// preemption). Same idea as the Linux osnoise/hwlat tracers, from user space.
+struct NoiseStats {
+    // Gap histogram: bucket i counts gaps in [threshold * 2^i,
+    // threshold * 2^(i+1)); the last bucket is open-ended.
+    static constexpr int kBuckets = 12;
+
+    int cpu = -1;              // -1: wherever the caller ran
+    double windowMs = 0.0;
+    double thresholdUs = 0.0;
+    uint64_t gaps = 0;
+    double gapsPerSec = 0.0;   // interrupt/preemption frequency
+    double stolenUs = 0.0;     // sum of the gaps
+    double stolenFraction = 0.0;
+    double maxGapUs = 0.0;
+    std::array<uint64_t, kBuckets> histogram{};
+};
+
+class NoiseProbe {
+public:
+    static constexpr double kDefaultThresholdUs = 10.0;
+
+    // Spins on the calling thread for `windowMs`. Pin the thread first; the
+    // result describes whichever CPU it ran on.
+    static NoiseStats Measure(double windowMs, double thresholdUs = kDefaultThresholdUs);
+
+    // Lower bound of histogram bucket `i`, in microseconds.
+    static double BucketUs(const NoiseStats& s, int i);
+};
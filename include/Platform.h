@@ -0,0 +1,28 @@
+#pragma once
+
+// Portable core (InputThread, LatencyMeasurer, input sources) builds on Windows
+// and Linux. On Windows this is just <windows.h>; elsewhere it provides the
+// handful of Win32 scalar types and priority constants that InputThread::Config
+// uses, so the config keeps one layout (and one registry format) everywhere.
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <cstdint>
+
+using BYTE = uint8_t;
+using UINT = unsigned int;
+using DWORD = uint32_t;
+using DWORD_PTR = uintptr_t;
+using LONGLONG = int64_t;
+using ULONGLONG = uint64_t;
+
+constexpr DWORD NORMAL_PRIORITY_CLASS = 0x00000020;
+constexpr DWORD HIGH_PRIORITY_CLASS = 0x00000080;
+
+constexpr int THREAD_PRIORITY_NORMAL = 0;
+constexpr int THREAD_PRIORITY_HIGHEST = 2;
+constexpr int THREAD_PRIORITY_TIME_CRITICAL = 15;
+#endif
@@ -0,0 +1,63 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+struct WaiterStats {
+    uint64_t waits = 0;
+    uint64_t missed = 0;       // the sleep alone already overshot the deadline
+    double marginUs = 0.0;     // current sleep-to-spin margin
+    double sleptUs = 0.0;
+    double spunUs = 0.0;       // CPU time burnt spinning
+    double spinFraction = 0.0; // spunUs / (sleptUs + spunUs)
+    double avgLateUs = 0.0;    // return time past the deadline
+    double maxLateUs = 0.0;
+};
+
+// Waits for an absolute deadline on the measurer's clock with microsecond
+// accuracy: sleeps until `margin` before it, then spins with a pause
+// instruction. The margin follows the sleep overshoot actually observed
+// (quick to grow, slow to shrink), so the spin stays as short as the OS timer
+// allows. Seed it with DeviceTuner's calibrated overshoot to skip the warm-up.
+// WaitUntil runs on one thread; Interrupt and Stats may be called from any.
+class PreciseWaiter {
+public:
+    static constexpr double kDefaultOvershootUs = 1000.0;
+    static constexpr double kMinMarginUs = 20.0;
+    static constexpr double kMaxMarginUs = 20000.0;
+
+    explicit PreciseWaiter(double overshootUs = kDefaultOvershootUs);
+
+    // Restarts adaptation from `overshootUs` (<= 0 keeps the current margin).
+    void SetMargin(double overshootUs);
+
+    // Blocks until ReadTicks() >= deadlineTicks. False if Interrupt()ed.
+    bool WaitUntil(int64_t deadlineTicks);
+
+    // Sleep only, at the OS timer's accuracy, for deadlines that may be late
+    // (idle timeouts). Still interruptible; not counted in Stats().
+    bool SleepUntil(int64_t deadlineTicks);
+
+    // Makes the current and every later wait return false until Reset().
+    void Interrupt();
+    void Reset();
+
+    WaiterStats Stats() const;
+    void ResetStats();
+
+    // One spin-loop hint: PAUSE on x86, YIELD on ARM.
+    static void CpuRelax();
+
+private:
+    void Adapt(double overshootUs);
+    bool SleepLocked(std::unique_lock<std::mutex>& lock, int64_t target, int64_t& now);
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::atomic<bool> interrupted_{false};
+
+    double overshootUs_ = kDefaultOvershootUs; // envelope of recent sleep overshoot
+    WaiterStats stats_{};
+    double lateSumUs_ = 0.0;
+};
@@ -0,0 +1,238 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+
+// Avoid Windows.h min/max macro collisions
+#ifdef min
+#undef min
+#endif
+#ifdef max
+#undef max
+#endif
+
+
+// Streaming quantile sketch (merging t-digest, k1 scale function).
+// Incoming values are appended to a fixed buffer; when it fills, the buffer is
+// sorted and folded into at most ~2*compression weighted centroids. Centroids
+// near q=0 and q=1 are kept small, so tail quantiles (p99, p99.9) stay accurate
+// over an unbounded stream. All storage is allocated in the constructor, so
+// push() never allocates. Sketches with equal compression can be merged.
+class QuantileSketch {
+public:
+    explicit QuantileSketch(double compression = 200.0)
+        : compression_(std::max(compression, 20.0)) {
+        const size_t centroidCap = static_cast<size_t>(2.0 * std::ceil(compression_)) + 10;
+        const size_t bufferCap = static_cast<size_t>(5.0 * std::ceil(compression_));
+
+        centroids_.reserve(centroidCap);
+        buffer_.reserve(bufferCap);
+        scratch_.reserve(centroidCap + bufferCap);
+        buffer_capacity_ = bufferCap;
+        clear();
+    }
+
+    void push(double value) {
+        if (value < min_) min_ = value;
+        if (value > max_) max_ = value;
+        sum_ += value;
+        count_++;
+
+        const double d = value - mean_;
+        mean_ += d / static_cast<double>(count_);
+        m2_ += d * (value - mean_);
+
+        buffer_.push_back(Centroid{ value, 1.0 });
+        if (buffer_.size() >= buffer_capacity_) Flush();
+    }
+
+    // Folds another sketch's centroids (and pending values) into this one.
+    void merge(const QuantileSketch& other) {
+        if (other.count_ == 0) return;
+
+        other.Flush();
+        for (const Centroid& c : other.centroids_) {
+            buffer_.push_back(c);
+            if (buffer_.size() >= buffer_capacity_) Flush();
+        }
+
+        // Chan et al. pairwise combination of the running moments.
+        const double n1 = static_cast<double>(count_);
+        const double n2 = static_cast<double>(other.count_);
+        const double d = other.mean_ - mean_;
+        mean_ += d * n2 / (n1 + n2);
+        m2_ += other.m2_ + d * d * n1 * n2 / (n1 + n2);
+
+        count_ += other.count_;
+        sum_ += other.sum_;
+        min_ = std::min(min_, other.min_);
+        max_ = std::max(max_, other.max_);
+    }
+
+    void clear() {
+        centroids_.clear();
+        buffer_.clear();
+        total_weight_ = 0.0;
+        count_ = 0;
+        sum_ = 0.0;
+        mean_ = 0.0;
+        m2_ = 0.0;
+        min_ = INFINITY;
+        max_ = -INFINITY;
+    }
+
+    uint64_t count() const { return count_; }
+    bool empty() const { return count_ == 0; }
+
+    double min() const { return empty() ? 0.0 : min_; }
+    double max() const { return empty() ? 0.0 : max_; }
+
+    double average() const {
+        if (empty()) return 0.0;
+        return sum_ / static_cast<double>(count_);
+    }
+
+    double stddev() const {
+        if (count_ < 2) return 0.0;
+        return std::sqrt(std::max(m2_, 0.0) / static_cast<double>(count_));
+    }
+
+    // p in [0, 1]; interpolates between centroid means, exact at 0 and 1.
+    double percentile(double p) const {
+        if (empty()) return 0.0;
+        if (p <= 0.0) return min_;
+        if (p >= 1.0) return max_;
+
+        Flush();
+
+        const size_t n = centroids_.size();
+        if (n == 1) return centroids_[0].mean;
+
+        const double index = p * total_weight_;
+        if (index < 1.0) return min_;
+
+        const Centroid& first = centroids_.front();
+        if (first.weight > 1.0 && index < first.weight / 2.0) {
+            return min_ + (index - 1.0) / (first.weight / 2.0 - 1.0) * (first.mean - min_);
+        }
+
+        if (index > total_weight_ - 1.0) return max_;
+
+        const Centroid& last = centroids_.back();
+        if (last.weight > 1.0 && total_weight_ - index <= last.weight / 2.0) {
+            return max_ - (total_weight_ - index - 1.0) / (last.weight / 2.0 - 1.0) * (max_ - last.mean);
+        }
+
+        double weightSoFar = first.weight / 2.0;
+        for (size_t i = 0; i + 1 < n; i++) {
+            const Centroid& a = centroids_[i];
+            const Centroid& b = centroids_[i + 1];
+            const double dw = (a.weight + b.weight) / 2.0;
+
+            if (weightSoFar + dw > index) {
+                double leftUnit = 0.0;
+                if (a.weight == 1.0) {
+                    if (index - weightSoFar < 0.5) return a.mean;
+                    leftUnit = 0.5;
+                }
+                double rightUnit = 0.0;
+                if (b.weight == 1.0) {
+                    if (weightSoFar + dw - index <= 0.5) return b.mean;
+                    rightUnit = 0.5;
+                }
+
+                const double z1 = index - weightSoFar - leftUnit;
+                const double z2 = weightSoFar + dw - index - rightUnit;
+                return WeightedAverage(a.mean, z2, b.mean, z1);
+            }
+            weightSoFar += dw;
+        }
+
+        return last.mean;
+    }
+
+    size_t centroidCount() const {
+        Flush();
+        return centroids_.size();
+    }
+
+    size_t memoryBytes() const {
+        return (centroids_.capacity() + buffer_.capacity() + scratch_.capacity()) * sizeof(Centroid);
+    }
+
+private:
+    struct Centroid {
+        double mean;
+        double weight;
+    };
+
+    static double WeightedAverage(double x1, double w1, double x2, double w2) {
+        if (w1 + w2 <= 0.0) return (x1 + x2) / 2.0;
+        const double v = (x1 * w1 + x2 * w2) / (w1 + w2);
+        return std::max(std::min(x1, x2), std::min(v, std::max(x1, x2)));
+    }
+
+    // k1 scale: k(q) = d / (2*pi) * asin(2q - 1)
+    double QLimitAfter(double q) const {
+        static const double kPi = 3.14159265358979323846;
+        const double k = compression_ / (2.0 * kPi) * std::asin(2.0 * q - 1.0) + 1.0;
+        if (k >= compression_ / 4.0) return 1.0;
+        return (std::sin(k * 2.0 * kPi / compression_) + 1.0) / 2.0;
+    }
+
+    // Logically const: folds pending values into centroids without changing
+    // the distribution the sketch represents.
+    void Flush() const {
+        if (buffer_.empty()) return;
+
+        scratch_.clear();
+        scratch_.insert(scratch_.end(), centroids_.begin(), centroids_.end());
+        scratch_.insert(scratch_.end(), buffer_.begin(), buffer_.end());
+        buffer_.clear();
+
+        std::sort(scratch_.begin(), scratch_.end(),
+            [](const Centroid& a, const Centroid& b) { return a.mean < b.mean; });
+
+        double total = 0.0;
+        for (const Centroid& c : scratch_) total += c.weight;
+
+        centroids_.clear();
+        Centroid cur = scratch_[0];
+        double weightSoFar = 0.0;
+        double qLimit = QLimitAfter(0.0);
+
+        for (size_t i = 1; i < scratch_.size(); i++) {
+            const Centroid& next = scratch_[i];
+            const double proposed = cur.weight + next.weight;
+
+            if ((weightSoFar + proposed) / total <= qLimit) {
+                cur.mean += (next.mean - cur.mean) * next.weight / proposed;
+                cur.weight = proposed;
+            } else {
+                centroids_.push_back(cur);
+                weightSoFar += cur.weight;
+                qLimit = QLimitAfter(weightSoFar / total);
+                cur = next;
+            }
+        }
+        centroids_.push_back(cur);
+        total_weight_ = total;
+    }
+
+    double compression_;
+    size_t buffer_capacity_ = 0;
+
+    mutable std::vector<Centroid> centroids_;
+    mutable std::vector<Centroid> buffer_;
+    mutable std::vector<Centroid> scratch_;
+    mutable double total_weight_ = 0.0;
+
+    uint64_t count_ = 0;
+    double sum_ = 0.0;
+    double mean_ = 0.0;
+    double m2_ = 0.0;
+    double min_ = INFINITY;
+    double max_ = -INFINITY;
+};
@@ -0,0 +1,52 @@
+#pragma once
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+#include "InputSource.h"
+
+// Keyboard + mouse through Raw Input (RIDEV_INPUTSINK) on a hidden
+// HWND_MESSAGE window owned by the input thread.
+class RawInputSource : public InputSource {
+public:
+    RawInputSource();
+    ~RawInputSource() override;
+
+    const wchar_t* Name() const override { return L"Raw Input"; }
+
+    bool Open() override;
+    void Close() override;
+    WaitResult Wait(int timeoutMs) override;
+    int Read(InputEvent* out, int max) override;
+    void Wake() override;
+
+private:
+    bool CreateHiddenWindow();
+    void DestroyHiddenWindow();
+    bool InitializeRawInput(HWND hwnd);
+    void SetIdleTimer(int timeoutMs);
+
+    // Drains queued WM_INPUT records behind `pending_` with GetRawInputBuffer.
+    int ReadBuffered(InputEvent* out, int max);
+    static void ToInputEvent(const RAWINPUT* ri, InputEvent& ev);
+
+    static constexpr size_t kMaxBatch = 64;
+
+    static LRESULT CALLBACK HiddenWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
+
+    HINSTANCE h_instance_ = nullptr;
+    HWND hwnd_ = nullptr;
+
+    std::atomic<DWORD> thread_id_{0};
+    std::atomic<bool> wake_requested_{false};
+
+    UINT_PTR idle_timer_ = 0;
+    int idle_timer_ms_ = -1;
+
+    HRAWINPUT pending_ = nullptr;
+    RAWINPUT record_{}; // fits keyboard and mouse records; HID ones are read as a header
+    std::vector<uint64_t> batch_buf_;
+};
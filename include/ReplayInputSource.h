@@ -0,0 +1,49 @@
+#pragma once
+#include <atomic>
+#include <string>
+#include "InputSource.h"
+#include "InputTrace.h"
+#include "PreciseWaiter.h"
+
+// Plays back a recorded .ilotrace through the normal InputThread pipeline.
+// speed 1.0 keeps the recorded inter-event timing, N plays N times faster and
+// 0 delivers every event as fast as the reader drains them. Replayed events
+// are stamped with their scheduled time, so delivery latency measures how late
+// the input thread picked them up (unstamped when speed is 0). Due times are
+// waited for with a PreciseWaiter, so that lateness is the pipeline's and not
+// the OS timer's.
+// Without `loop`, Wait() returns Exit once the trace is exhausted.
+class ReplayInputSource : public InputSource {
+public:
+    explicit ReplayInputSource(std::string path, double speed = 1.0, bool loop = false);
+    ~ReplayInputSource() override;
+
+    const wchar_t* Name() const override { return L"replay"; }
+
+    bool Open() override;
+    void Close() override;
+    WaitResult Wait(int timeoutMs) override;
+    int Read(InputEvent* out, int max) override;
+    void Wake() override;
+    PreciseWaiter* Waiter() override { return &waiter_; }
+
+    uint64_t EventCount() const { return trace_.Count(); }
+    uint64_t Replayed() const { return replayed_.load(std::memory_order_relaxed); } // any thread
+
+private:
+    int64_t DueTicks(uint64_t index) const;
+    void Rewind(int64_t now);
+
+    std::string path_;
+    double speed_ = 1.0;
+    bool loop_ = false;
+
+    MappedInputTrace trace_;
+    uint64_t pos_ = 0;
+    std::atomic<uint64_t> replayed_{0};
+    int64_t origin_ticks_ = 0;
+    int64_t frequency_ = 0;
+
+    PreciseWaiter waiter_;
+    std::atomic<bool> wake_requested_{false};
+};
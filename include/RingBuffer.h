@@ -1,8 +1,12 @@
 #pragma once
 #include <algorithm>
+#include <array>
 #include <vector>
 #include <numeric>
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
 
 
 // Avoid Windows.h min/max macro collisions
@@ -14,7 +18,23 @@
 #endif
 
 
-template<typename T, size_t N>
+// Vectorized aggregate kernels (src/RingBuffer.cpp). The implementation is
+// picked once at runtime: AVX2, then SSE2, then a scalar loop.
+namespace RingBufferSimd {
+    double Min(const double* p, size_t n);
+    double Max(const double* p, size_t n);
+    double Sum(const double* p, size_t n);
+    const char* KernelName();
+
+    template<typename T> T Min(const T* p, size_t n) { return *std::min_element(p, p + n); }
+    template<typename T> T Max(const T* p, size_t n) { return *std::max_element(p, p + n); }
+    template<typename T> T Sum(const T* p, size_t n) { return std::accumulate(p, p + n, T(0)); }
+}
+
+constexpr bool IsPowerOfTwo(size_t n) { return n != 0 && (n & (n - 1)) == 0; }
+
+
+template<typename T, size_t N, bool Pow2 = IsPowerOfTwo(N)>
 class RingBuffer {
 public:
     RingBuffer() : head_(0), size_(0) {
@@ -79,3 +99,269 @@ private:
     size_t head_;
     size_t size_;
 };
+
+
+// Power-of-two capacity: inline cache-line-aligned storage, mask indexing and
+// SIMD min/max/sum over the contiguous window. Same interface as above, except
+// data() exposes a pointer to size() elements instead of a vector.
+template<typename T, size_t N>
+class RingBuffer<T, N, true> {
+public:
+    RingBuffer() : head_(0), size_(0) {}
+
+    void push(const T& value) {
+        buffer_[head_ & kMask] = value;
+        head_++;
+        if (size_ < N) size_++;
+    }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    bool full() const { return size_ == N; }
+
+    void clear() {
+        head_ = 0;
+        size_ = 0;
+    }
+
+    T min() const {
+        if (empty()) return T();
+        return RingBufferSimd::Min(buffer_.data(), size_);
+    }
+
+    T max() const {
+        if (empty()) return T();
+        return RingBufferSimd::Max(buffer_.data(), size_);
+    }
+
+    T average() const {
+        if (empty()) return T();
+        return RingBufferSimd::Sum(buffer_.data(), size_) / static_cast<T>(size_);
+    }
+
+    T percentile(double p) const {
+        if (empty()) return T();
+
+        std::vector<T> tmp(buffer_.begin(), buffer_.begin() + size_);
+
+        if (p <= 0.0) return *std::min_element(tmp.begin(), tmp.end());
+        if (p >= 1.0) return *std::max_element(tmp.begin(), tmp.end());
+
+        size_t idx = static_cast<size_t>(std::ceil(p * tmp.size())) - 1;
+        if (idx >= tmp.size()) idx = tmp.size() - 1;
+
+        std::nth_element(tmp.begin(), tmp.begin() + idx, tmp.end());
+        return tmp[idx];
+    }
+
+    const T* data() const { return buffer_.data(); }
+
+private:
+    static constexpr size_t kMask = N - 1;
+
+    alignas(64) std::array<T, N> buffer_;
+    size_t head_;
+    size_t size_;
+};
+
+
+// Fixed-window ring that keeps its aggregates current on every push():
+// window min/max through monotonic deques of sequence numbers, mean and
+// variance through Welford updates that are undone when a sample is evicted.
+// min()/max()/average()/stddev() are O(1). Floating-point drift from the
+// add/remove pairs is cleared by an exact re-sum once every N evictions.
+// Unsigned types up to 32 bits instead keep exact integer sum / sum of
+// squares, so push() does no floating-point work at all.
+template<typename T, size_t N>
+class StatsRingBuffer {
+public:
+    StatsRingBuffer() : values_(N), min_deque_(N), max_deque_(N) {
+        clear();
+    }
+
+    void push(const T& value) {
+        const size_t slot = static_cast<size_t>(seq_ % N);
+        bool resync = false;
+
+        if (size_ == N) {
+            const uint64_t leaving = seq_ - N;
+            if (min_deque_[min_head_ % N] == leaving) min_head_++;
+            if (max_deque_[max_head_ % N] == leaving) max_head_++;
+            MomentsRemove(values_[slot]);
+            size_--;
+
+            if (!kExactInt && ++evictions_ >= N) {
+                evictions_ = 0;
+                resync = true;
+            }
+        }
+
+        values_[slot] = value;
+        size_++;
+        PushDeques(value);
+        seq_++;
+
+        if (resync) Resync();
+        else MomentsAdd(value);
+    }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    bool full() const { return size_ == N; }
+
+    void clear() {
+        seq_ = 0;
+        size_ = 0;
+        evictions_ = 0;
+        min_head_ = min_tail_ = 0;
+        max_head_ = max_tail_ = 0;
+        mean_ = 0.0;
+        m2_ = 0.0;
+        sum_ = 0;
+        sq_lo_ = 0;
+        sq_hi_ = 0;
+    }
+
+    T min() const {
+        if (empty()) return T();
+        return values_[static_cast<size_t>(min_deque_[min_head_ % N] % N)];
+    }
+
+    T max() const {
+        if (empty()) return T();
+        return values_[static_cast<size_t>(max_deque_[max_head_ % N] % N)];
+    }
+
+    T average() const {
+        if (empty()) return T();
+        return static_cast<T>(mean());
+    }
+
+    // Unrounded window mean (average() truncates for integer T).
+    double mean() const {
+        if (empty()) return 0.0;
+        if constexpr (kExactInt) return static_cast<double>(sum_) / static_cast<double>(size_);
+        return mean_;
+    }
+
+    double variance() const {
+        if (size_ < 2) return 0.0;
+        const double n = static_cast<double>(size_);
+        if constexpr (kExactInt) {
+            const double sumSq = static_cast<double>(sq_hi_) * 18446744073709551616.0 + static_cast<double>(sq_lo_);
+            const double m = static_cast<double>(sum_) / n;
+            return std::max(sumSq / n - m * m, 0.0);
+        }
+        return std::max(m2_, 0.0) / n;
+    }
+
+    double stddev() const { return std::sqrt(variance()); }
+
+    // Visits the window oldest first.
+    template<typename F>
+    void forEach(F&& f) const {
+        for (uint64_t s = seq_ - size_; s < seq_; s++) f(values_[static_cast<size_t>(s % N)]);
+    }
+
+    // Not incremental: copies the window, same convention as RingBuffer.
+    T percentile(double p) const {
+        if (empty()) return T();
+
+        std::vector<T> sorted(values_.begin(), values_.begin() + size_);
+        std::sort(sorted.begin(), sorted.end());
+
+        if (p <= 0.0) return sorted.front();
+        if (p >= 1.0) return sorted.back();
+
+        size_t idx = static_cast<size_t>(std::ceil(p * sorted.size())) - 1;
+        if (idx >= sorted.size()) idx = sorted.size() - 1;
+
+        return sorted[idx];
+    }
+
+private:
+    void PushDeques(const T& value) {
+        while (min_tail_ != min_head_ && values_[static_cast<size_t>(min_deque_[(min_tail_ - 1) % N] % N)] >= value) min_tail_--;
+        min_deque_[min_tail_ % N] = seq_;
+        min_tail_++;
+
+        while (max_tail_ != max_head_ && values_[static_cast<size_t>(max_deque_[(max_tail_ - 1) % N] % N)] <= value) max_tail_--;
+        max_deque_[max_tail_ % N] = seq_;
+        max_tail_++;
+    }
+
+    static constexpr bool kExactInt = std::is_unsigned<T>::value && sizeof(T) <= 4;
+
+    void MomentsAdd(const T& value) {
+        if constexpr (kExactInt) {
+            const uint64_t x = static_cast<uint64_t>(value);
+            const uint64_t sq = x * x;
+            sum_ += x;
+            sq_lo_ += sq;
+            if (sq_lo_ < sq) sq_hi_++;
+        } else {
+            WelfordAdd(static_cast<double>(value));
+        }
+    }
+
+    void MomentsRemove(const T& value) {
+        if constexpr (kExactInt) {
+            const uint64_t x = static_cast<uint64_t>(value);
+            const uint64_t sq = x * x;
+            sum_ -= x;
+            if (sq_lo_ < sq) sq_hi_--;
+            sq_lo_ -= sq;
+        } else {
+            WelfordRemove(static_cast<double>(value));
+        }
+    }
+
+    void WelfordAdd(double x) {
+        const double n = static_cast<double>(size_);
+        const double d = x - mean_;
+        mean_ += d / n;
+        m2_ += d * (x - mean_);
+    }
+
+    void WelfordRemove(double x) {
+        if (size_ <= 1) {
+            mean_ = 0.0;
+            m2_ = 0.0;
+            return;
+        }
+        const double n = static_cast<double>(size_ - 1);
+        const double oldMean = mean_;
+        mean_ = oldMean - (x - oldMean) / n;
+        m2_ -= (x - oldMean) * (x - mean_);
+    }
+
+    void Resync() {
+        double sum = 0.0;
+        for (size_t i = 0; i < size_; i++) sum += static_cast<double>(values_[i]);
+        mean_ = sum / static_cast<double>(size_);
+
+        double m2 = 0.0;
+        for (size_t i = 0; i < size_; i++) {
+            const double d = static_cast<double>(values_[i]) - mean_;
+            m2 += d * d;
+        }
+        m2_ = m2;
+    }
+
+    std::vector<T> values_;
+    std::vector<uint64_t> min_deque_;
+    std::vector<uint64_t> max_deque_;
+    size_t min_head_ = 0, min_tail_ = 0;
+    size_t max_head_ = 0, max_tail_ = 0;
+
+    uint64_t seq_ = 0;
+    size_t size_ = 0;
+    size_t evictions_ = 0;
+    double mean_ = 0.0;
+    double m2_ = 0.0;
+
+    // kExactInt only: sum and 128-bit sum of squares
+    uint64_t sum_ = 0;
+    uint64_t sq_lo_ = 0;
+    uint64_t sq_hi_ = 0;
+};
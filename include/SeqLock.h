@@ -0,0 +1,63 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+
+// Single-writer sequence lock for small trivially copyable values.
+// The writer never blocks: it bumps the sequence to odd, stores the payload and
+// bumps it back to even. Readers on any thread copy the payload and retry only
+// if a store overlapped the copy. The payload lives in relaxed atomic words, so
+// concurrent access is well defined rather than a tolerated data race.
+template<typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock payload must be trivially copyable");
+
+public:
+    SeqLock() {
+        T empty{};
+        Store(empty);
+    }
+
+    // Writer thread only.
+    void Store(const T& value) {
+        uint64_t words[kWords]{};
+        std::memcpy(words, &value, sizeof(T));
+
+        const uint64_t s = seq_.load(std::memory_order_relaxed);
+        seq_.store(s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        for (size_t i = 0; i < kWords; i++) words_[i].store(words[i], std::memory_order_relaxed);
+
+        seq_.store(s + 2, std::memory_order_release);
+    }
+
+    T Load() const {
+        uint64_t words[kWords]{};
+        for (unsigned spins = 0;; spins++) {
+            const uint64_t s1 = seq_.load(std::memory_order_acquire);
+            if ((s1 & 1) == 0) {
+                for (size_t i = 0; i < kWords; i++) words[i] = words_[i].load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (seq_.load(std::memory_order_relaxed) == s1) break;
+            }
+            if (spins >= 64) std::this_thread::yield();
+        }
+
+        T out;
+        std::memcpy(&out, words, sizeof(T));
+        return out;
+    }
+
+    // Number of completed stores (starts at 1 for the initial empty value).
+    uint64_t Version() const { return seq_.load(std::memory_order_acquire) / 2; }
+
+private:
+    static constexpr size_t kWords = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    std::atomic<uint64_t> seq_{0};
+    std::atomic<uint64_t> words_[kWords];
+};
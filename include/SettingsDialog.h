@@ -6,10 +6,11 @@
 #include <string>
 #include "InputThread.h"
 #include "AutoStartManager.h"
+#include "DeviceTuner.h"
 
 class SettingsDialog {
 public:
-    enum class Mode : DWORD { Light = 0, Medium = 1, Max = 2, Recommend = 3 };
+    using Mode = TuningMode;
 
     SettingsDialog(HINSTANCE hInstance, InputThread& inputThread, AutoStartManager& autoStartManager);
     ~SettingsDialog();
@@ -0,0 +1,118 @@
+#pragma once
+#include <atomic>
+#include <string>
+#include <vector>
+#include "EvdevInputSource.h"
+#include "InputSource.h"
+
+struct io_uring_params;
+struct io_uring_sqe;
+struct io_uring_cqe;
+struct io_uring_buf;
+
+// Linux evdev through io_uring. Every device fd keeps a read posted, so one
+// io_uring_enter() waits for all of them and completions are reaped straight
+// from the mapped completion queue: a busy poll (Wait(0)) costs no syscall.
+// Kernels with multishot reads (6.7+) get one IORING_OP_READ_MULTISHOT per fd
+// filling a shared ring of provided buffers, never re-armed. Older ones get
+// one IORING_OP_READ_FIXED per fd into its own registered buffer, re-armed in
+// the same io_uring_enter() that waits for the next completion. Without a
+// usable io_uring (too old, io_uring_disabled, seccomp) Open() falls back to
+// EvdevInputSource (epoll).
+class UringInputSource : public InputSource {
+public:
+    enum class Mode { Closed, Multishot, FixedReads, Epoll };
+
+    // Same device selection as EvdevInputSource.
+    UringInputSource();
+    explicit UringInputSource(std::vector<std::string> paths);
+    explicit UringInputSource(const std::vector<int>& fds);
+    ~UringInputSource() override;
+
+    const wchar_t* Name() const override;
+
+    bool Open() override;
+    void Close() override;
+    WaitResult Wait(int timeoutMs) override;
+    int Read(InputEvent* out, int max) override;
+    void Wake() override;
+
+    Mode GetMode() const { return mode_; }
+    size_t DeviceCount() const;
+
+    // io_uring_enter() calls issued by Wait()/Read() so far (epoll_wait() +
+    // read() calls after a fallback).
+    uint64_t SyscallCount() const;
+
+private:
+    struct Device {
+        int fd = -1;
+        bool owned = false;
+    };
+
+    // One completion being handed out by Read().
+    struct Chunk {
+        size_t device = 0;
+        const unsigned char* data = nullptr;
+        int count = 0;       // input_event records
+        int pos = 0;
+        int buffer = -1;     // provided buffer id (multishot)
+        bool rearm = false;  // the read ended with this completion
+    };
+
+    bool SetupRing();
+    bool MapRing(const io_uring_params& p);
+    bool SetupBuffers(bool multishot);
+    void TeardownRing();
+
+    io_uring_sqe* NextSqe();
+    void PostRead(size_t device);
+    void PostWakePoll();
+    int Enter(unsigned minComplete, int timeoutMs);
+    bool CqReady() const;
+    bool NextChunk();
+    void FinishChunk();
+    void ReturnBuffer(int bid);
+    void DropDevice(size_t index);
+
+    std::vector<std::string> paths_;
+    std::vector<int> external_fds_;
+    bool scan_ = false;
+
+    EvdevInputSource fallback_;
+    std::atomic<Mode> mode_{Mode::Closed};
+
+    std::vector<Device> devices_;
+    int wake_fd_ = -1;
+    bool wake_seen_ = false;
+
+    int ring_fd_ = -1;
+    void* sq_map_ = nullptr;
+    size_t sq_map_size_ = 0;
+    void* cq_map_ = nullptr;
+    size_t cq_map_size_ = 0;
+    io_uring_sqe* sqes_ = nullptr;
+    size_t sqes_size_ = 0;
+
+    unsigned* sq_head_ = nullptr;
+    unsigned* sq_tail_ = nullptr;
+    unsigned* sq_array_ = nullptr;
+    unsigned sq_mask_ = 0;
+    unsigned sq_entries_ = 0;
+    unsigned sq_local_tail_ = 0;
+    unsigned sq_pending_ = 0; // queued since the last io_uring_enter()
+
+    unsigned* cq_head_ = nullptr;
+    unsigned* cq_tail_ = nullptr;
+    io_uring_cqe* cqes_ = nullptr;
+    unsigned cq_mask_ = 0;
+
+    unsigned char* buffers_ = nullptr;
+    size_t buffers_size_ = 0;
+    io_uring_buf* buf_ring_ = nullptr; // provided buffer ring (multishot)
+    size_t buf_ring_size_ = 0;
+    uint16_t buf_tail_ = 0;
+
+    Chunk chunk_{};
+    uint64_t syscalls_ = 0;
+};
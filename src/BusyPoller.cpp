@@ -0,0 +1,239 @@
+#include "../include/BusyPoller.h"
+#include "../include/DeviceTuner.h"
+#include "../include/LatencyMeasurer.h"
+#include "../include/PreciseWaiter.h"
+#include <algorithm>
+#include <chrono>
+#include <utility>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <cpuid.h>
+#include <x86intrin.h>
+#define ILO_HAVE_UMWAIT 1
+#endif
+
+static constexpr int kWindowMs = 100;
+static constexpr uint64_t kBaselineEvery = 16;    // every 16th window blocks
+static constexpr auto kPowerCheckInterval = std::chrono::seconds(10);
+static constexpr unsigned kMaxPauseShift = 6;     // up to 64 PAUSEs between polls
+static constexpr uint64_t kUmwaitCycles = 4000;   // ~1-2 us of TSC
+static constexpr uint64_t kMaxStampAgeNs = 1000000000ull;
+
+#ifdef ILO_HAVE_UMWAIT
+static bool HasWaitPkg() {
+    unsigned a = 0, b = 0, c = 0, d = 0;
+    return __get_cpuid_count(7, 0, &a, &b, &c, &d) && (c & (1u << 5));
+}
+
+// Light (C0.1) wait until `cycles` TSC ticks from now. Nothing writes the
+// monitored line, so the deadline or an interrupt ends it; the kernel caps
+// it at /sys/devices/system/cpu/umwait_control/max_time.
+__attribute__((target("waitpkg"))) static void UmwaitCycles(uint64_t cycles) {
+    alignas(64) static char line[64];
+    _umonitor(line);
+    _umwait(1, __rdtsc() + cycles);
+}
+
+static bool Umwait(uint64_t cycles) {
+    static const bool have = HasWaitPkg();
+    if (!have) return false;
+    UmwaitCycles(cycles);
+    return true;
+}
+#else
+static bool Umwait(uint64_t) { return false; }
+#endif
+
+BusyPoller::BusyPoller()
+    : polled_(1, kMaxStampAgeNs, 2), blocked_(1, kMaxStampAgeNs, 2),
+      pending_polled_(1, kMaxStampAgeNs, 2), pending_blocked_(1, kMaxStampAgeNs, 2),
+      merged_polled_(1, kMaxStampAgeNs, 2), merged_blocked_(1, kMaxStampAgeNs, 2) {
+    frequency_ = LatencyMeasurer::TickFrequency();
+    window_ticks_ = frequency_ * kWindowMs / 1000;
+}
+
+BusyPoller::~BusyPoller() {
+    StopPowerWatch();
+}
+
+void BusyPoller::StartPowerWatch() {
+    if (power_thread_.joinable()) return;
+    battery_.store(DeviceTuner::OnBattery(), std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(power_mutex_);
+        power_stop_ = false;
+    }
+    power_thread_ = std::thread(&BusyPoller::WatchPower, this);
+}
+
+void BusyPoller::StopPowerWatch() {
+    {
+        std::lock_guard<std::mutex> lock(power_mutex_);
+        power_stop_ = true;
+    }
+    power_cv_.notify_all();
+    if (power_thread_.joinable()) power_thread_.join();
+}
+
+void BusyPoller::WatchPower() {
+    std::unique_lock<std::mutex> lock(power_mutex_);
+    while (!power_cv_.wait_for(lock, kPowerCheckInterval, [this] { return power_stop_; })) {
+        lock.unlock();
+        battery_.store(DeviceTuner::OnBattery(), std::memory_order_relaxed);
+        lock.lock();
+    }
+}
+
+void BusyPoller::SetBudget(double fraction) {
+    budget_.store(std::min(std::max(fraction, 0.0), 1.0), std::memory_order_relaxed);
+}
+
+void BusyPoller::Reset() {
+    polled_.clear();
+    blocked_.clear();
+    stats_ = BusyPollStats{};
+    window_start_ = 0;
+    window_spun_ = 0;
+    window_index_ = 0;
+    empty_polls_ = 0;
+    published_.Store(stats_);
+
+    std::lock_guard<std::mutex> lock(exchange_mutex_);
+    pending_polled_.clear();
+    pending_blocked_.clear();
+    pending_full_ = false;
+    merged_polled_.clear();
+    merged_blocked_.clear();
+}
+
+void BusyPoller::Flush() {
+    std::lock_guard<std::mutex> lock(exchange_mutex_);
+    DrainPending();
+    merged_polled_.merge(polled_);
+    merged_blocked_.merge(blocked_);
+    polled_.clear();
+    blocked_.clear();
+}
+
+void BusyPoller::StartWindow(int64_t now) {
+    if (window_index_ > 0 && now > window_start_) {
+        stats_.spinFraction = static_cast<double>(window_spun_) / static_cast<double>(now - window_start_);
+    }
+
+    on_battery_ = battery_.load(std::memory_order_relaxed);
+    window_index_++;
+    window_budget_ = budget_.load(std::memory_order_relaxed);
+    window_blocking_ = on_battery_ || window_budget_ <= 0.0 || window_index_ % kBaselineEvery == 0;
+    window_start_ = now;
+    window_spun_ = 0;
+    Publish();
+}
+
+// Counters only; the histograms are swapped out (never waiting for a reader)
+// and summarized in Stats().
+void BusyPoller::Publish() {
+    stats_.polling = !window_blocking_;
+    stats_.onBattery = on_battery_;
+    stats_.budget = window_budget_;
+    published_.Store(stats_);
+
+    std::unique_lock<std::mutex> lock(exchange_mutex_, std::try_to_lock);
+    if (!lock.owns_lock() || pending_full_) return;
+    std::swap(polled_, pending_polled_);
+    std::swap(blocked_, pending_blocked_);
+    pending_full_ = true;
+}
+
+void BusyPoller::DrainPending() const {
+    if (!pending_full_) return;
+    merged_polled_.merge(pending_polled_);
+    merged_blocked_.merge(pending_blocked_);
+    pending_polled_.clear();
+    pending_blocked_.clear();
+    pending_full_ = false;
+}
+
+BusyPollStats BusyPoller::Stats() const {
+    BusyPollStats s = published_.Load();
+
+    std::lock_guard<std::mutex> lock(exchange_mutex_);
+    DrainPending();
+    s.polledWakeups = merged_polled_.count();
+    s.blockedWakeups = merged_blocked_.count();
+    s.polledAvgUs = merged_polled_.average() / 1000.0;
+    s.polledP99Us = static_cast<double>(merged_polled_.percentile(0.99)) / 1000.0;
+    s.blockedAvgUs = merged_blocked_.average() / 1000.0;
+    s.blockedP99Us = static_cast<double>(merged_blocked_.percentile(0.99)) / 1000.0;
+    s.removedUs = (merged_polled_.empty() || merged_blocked_.empty()) ? 0.0 : s.blockedAvgUs - s.polledAvgUs;
+    return s;
+}
+
+// 1, 2, 4 ... 64 PAUSEs between empty polls, then UMWAIT where available:
+// the first polls after an event stay tight, a quiet device costs less.
+void BusyPoller::Backoff() {
+    if (empty_polls_ < ~0u) empty_polls_++;
+    if (empty_polls_ > kMaxPauseShift && Umwait(kUmwaitCycles)) return;
+
+    const unsigned pauses = 1u << std::min(empty_polls_ - 1, kMaxPauseShift);
+    for (unsigned i = 0; i < pauses; i++) PreciseWaiter::CpuRelax();
+}
+
+InputSource::WaitResult BusyPoller::Wait(InputSource& source, int timeoutMs) {
+    int64_t now = LatencyMeasurer::ReadTicks();
+    if (window_index_ == 0 || now - window_start_ >= window_ticks_) StartWindow(now);
+    const int64_t deadline = timeoutMs < 0 ? INT64_MAX : now + frequency_ * timeoutMs / 1000;
+
+    int64_t last = now;
+    while (!window_blocking_) {
+        const InputSource::WaitResult r = source.Wait(0);
+        stats_.polls++;
+        now = LatencyMeasurer::ReadTicks();
+        window_spun_ += now - last;
+        last = now;
+
+        if (r != InputSource::WaitResult::Timeout) {
+            empty_polls_ = 0;
+            last_wait_polled_ = true;
+            return r;
+        }
+        if (now >= deadline) {
+            last_wait_polled_ = true;
+            return InputSource::WaitResult::Timeout;
+        }
+
+        if (now - window_start_ >= window_ticks_) {
+            StartWindow(now);
+        } else if (static_cast<double>(window_spun_) >= window_budget_ * static_cast<double>(window_ticks_)) {
+            window_blocking_ = true;
+            stats_.budgetExhausted++;
+            Publish();
+        } else {
+            Backoff();
+        }
+    }
+
+    // Blocking for the rest of the window; the caller sees an early Timeout
+    // when the window ends first, which it treats as an idle tick.
+    last_wait_polled_ = false;
+    const int64_t until = std::min(deadline, window_start_ + window_ticks_);
+    const int64_t left = std::max<int64_t>(0, until - now);
+    const int ms = static_cast<int>((left * 1000 + frequency_ - 1) / frequency_);
+    return source.Wait(ms);
+}
+
+void BusyPoller::RecordWakeup(const InputEvent* events, int n, int64_t readEndTicks) {
+    // The oldest event in the batch waited longest: that wait is the wakeup.
+    uint64_t oldest = 0;
+    for (int i = 0; i < n; i++) {
+        const uint64_t ts = events[i].timestampNs;
+        if (ts && (!oldest || ts < oldest)) oldest = ts;
+    }
+    if (!oldest) return;
+
+    const uint64_t endNs = frequency_ == 1000000000ll
+        ? static_cast<uint64_t>(readEndTicks)
+        : static_cast<uint64_t>(static_cast<double>(readEndTicks) * 1e9 / static_cast<double>(frequency_));
+    if (endNs < oldest || endNs - oldest > kMaxStampAgeNs) return; // another clock
+
+    (last_wait_polled_ ? polled_ : blocked_).record(endNs - oldest);
+}
@@ -0,0 +1,235 @@
+#include "../include/CalibrationCache.h"
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <sstream>
+
+#ifndef _WIN32
+#include <fstream>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Bumped whenever a field changes meaning; older entries are then remeasured.
+static constexpr int kCacheVersion = 1;
+
+std::string CalibrationCache::Fingerprint(const DeviceProfile& p) {
+    char buf[128];
+    std::snprintf(buf, sizeof(buf), "cpus=%u;ramMB=%llu;timer=%u-%u;",
+        p.logicalProcessors, static_cast<unsigned long long>(p.ramBytes >> 20), p.timerMinMs, p.timerMaxMs);
+    return "model=" + p.cpuModel + ";" + buf + "os=" + p.osBuild;
+}
+
+long long CalibrationCache::Now() {
+    return static_cast<long long>(std::time(nullptr));
+}
+
+static void PutGain(std::ostringstream& o, const char* key, const GainEstimate& g) {
+    char buf[160];
+    std::snprintf(buf, sizeof(buf), "%s=%d %.3f %.3f %.3f %.4f\n",
+        key, g.verdict, g.gainUs, g.lowUs, g.highUs, g.confidence);
+    o << buf;
+}
+
+static bool GetGain(const std::string& v, GainEstimate& g) {
+    return std::sscanf(v.c_str(), "%d %lf %lf %lf %lf",
+        &g.verdict, &g.gainUs, &g.lowUs, &g.highUs, &g.confidence) == 5;
+}
+
+std::string CalibrationCache::Serialize(const CachedCalibration& c) {
+    const CalibrationResult& r = c.result;
+    std::ostringstream o;
+    char buf[256];
+
+    o << "version=" << kCacheVersion << "\n";
+    o << "fingerprint=" << c.fingerprint << "\n";
+    o << "measuredAt=" << r.measuredAt << "\n";
+    o << "idleValidated=" << (c.idleValidated ? 1 : 0) << "\n";
+
+    std::snprintf(buf, sizeof(buf), "boost=%d %.3f %.3f %d\n",
+        r.timerBoostHelps ? 1 : 0, r.sleepP95OvershootUs_NoBoost, r.sleepP95OvershootUs_Boost, r.boostSamples);
+    o << buf;
+    PutGain(o, "boostGain", r.timerBoost);
+
+    std::snprintf(buf, sizeof(buf), "affinity=%d %d %.3f %.3f %d\n",
+        r.affinityHelps ? 1 : 0, r.bestCpu, r.sleepP95OvershootUs_BestCore, r.sleepP95OvershootUs_DefaultCore,
+        r.candidatesProbed);
+    o << buf;
+    PutGain(o, "affinityGain", r.affinity);
+    o << "bestAffinity=" << r.bestAffinity.ToString() << "\n";
+    o << "noiseCompared=" << r.noiseCompared << "\n";
+    o << "affinityReason=" << r.affinityReason << "\n";
+
+    std::snprintf(buf, sizeof(buf), "probe=%d %.1f\n", r.probeWaves, r.calibrationMs);
+    o << buf;
+    for (const CoreCalibration& core : r.cores) {
+        const OvershootStats& s = core.overshoot;
+        std::snprintf(buf, sizeof(buf), "core=%d %d %d %.3f %.3f %.3f %.3f\n",
+            core.cpu, core.probed ? 1 : 0, s.samples, s.p50Us, s.p95Us, s.p99Us, s.maxUs);
+        o << buf;
+        const NoiseStats& n = core.noise;
+        if (n.cpu < 0) continue;
+        std::snprintf(buf, sizeof(buf), "noise=%d %.1f %.1f %llu %.3f %.3f\n",
+            n.cpu, n.windowMs, n.thresholdUs, static_cast<unsigned long long>(n.gaps), n.stolenUs, n.maxGapUs);
+        o << buf;
+    }
+    return o.str();
+}
+
+bool CalibrationCache::Parse(const std::string& text, CachedCalibration& out) {
+    CachedCalibration c{};
+    CalibrationResult& r = c.result;
+    int version = 0;
+    bool haveBoost = false, haveAffinity = false;
+
+    std::istringstream in(text);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        const size_t eq = line.find('=');
+        if (eq == std::string::npos) continue;
+        const std::string key = line.substr(0, eq);
+        const std::string v = line.substr(eq + 1);
+        int a = 0, b = 0, n = 0;
+
+        if (key == "version") version = std::atoi(v.c_str());
+        else if (key == "fingerprint") c.fingerprint = v;
+        else if (key == "measuredAt") r.measuredAt = std::atoll(v.c_str());
+        else if (key == "idleValidated") c.idleValidated = std::atoi(v.c_str()) != 0;
+        else if (key == "boost") {
+            haveBoost = std::sscanf(v.c_str(), "%d %lf %lf %d",
+                &a, &r.sleepP95OvershootUs_NoBoost, &r.sleepP95OvershootUs_Boost, &r.boostSamples) == 4;
+            r.timerBoostHelps = (a != 0);
+        } else if (key == "boostGain") {
+            if (!GetGain(v, r.timerBoost)) return false;
+        } else if (key == "affinity") {
+            haveAffinity = std::sscanf(v.c_str(), "%d %d %lf %lf %d",
+                &a, &r.bestCpu, &r.sleepP95OvershootUs_BestCore, &r.sleepP95OvershootUs_DefaultCore,
+                &r.candidatesProbed) == 5;
+            r.affinityHelps = (a != 0);
+        } else if (key == "affinityGain") {
+            if (!GetGain(v, r.affinity)) return false;
+        } else if (key == "bestAffinity") {
+            if (!CpuSet::Parse(v, r.bestAffinity)) return false;
+        } else if (key == "noiseCompared") r.noiseCompared = std::atoi(v.c_str());
+        else if (key == "affinityReason") r.affinityReason = v;
+        else if (key == "probe") {
+            if (std::sscanf(v.c_str(), "%d %lf", &r.probeWaves, &r.calibrationMs) != 2) return false;
+        } else if (key == "core") {
+            CoreCalibration core{};
+            OvershootStats& s = core.overshoot;
+            if (std::sscanf(v.c_str(), "%d %d %d %lf %lf %lf %lf",
+                &core.cpu, &b, &n, &s.p50Us, &s.p95Us, &s.p99Us, &s.maxUs) != 7) return false;
+            core.probed = (b != 0);
+            s.samples = n;
+            r.cores.push_back(core);
+        } else if (key == "noise") {
+            // Follows the core line it belongs to.
+            NoiseStats s{};
+            unsigned long long gaps = 0;
+            if (std::sscanf(v.c_str(), "%d %lf %lf %llu %lf %lf",
+                &s.cpu, &s.windowMs, &s.thresholdUs, &gaps, &s.stolenUs, &s.maxGapUs) != 6) return false;
+            if (r.cores.empty() || r.cores.back().cpu != s.cpu || s.windowMs <= 0.0) return false;
+            s.gaps = gaps;
+            s.gapsPerSec = static_cast<double>(gaps) * 1000.0 / s.windowMs;
+            s.stolenFraction = s.stolenUs / (s.windowMs * 1000.0);
+            r.cores.back().noise = s;
+        }
+    }
+
+    if (version != kCacheVersion || c.fingerprint.empty() || r.measuredAt <= 0) return false;
+    if (!haveBoost || !haveAffinity) return false;
+
+    r.measured = true;
+    r.fromCache = true;
+    out = std::move(c);
+    return true;
+}
+
+#ifdef _WIN32
+
+// Same key as ConfigStore.
+static const wchar_t* kRegPath = L"Software\\InputLatencyOptimizer";
+static const wchar_t* kRegValue = L"Calibration";
+
+bool CalibrationCache::Load(CachedCalibration& out) {
+    HKEY hKey{};
+    if (RegOpenKeyExW(HKEY_CURRENT_USER, kRegPath, 0, KEY_READ, &hKey) != ERROR_SUCCESS) return false;
+
+    DWORD type = 0, size = 0;
+    std::wstring w;
+    bool ok = RegQueryValueExW(hKey, kRegValue, nullptr, &type, nullptr, &size) == ERROR_SUCCESS
+        && type == REG_SZ && size > 0;
+    if (ok) {
+        w.resize(size / sizeof(wchar_t) + 1);
+        ok = RegQueryValueExW(hKey, kRegValue, nullptr, &type, reinterpret_cast<LPBYTE>(&w[0]), &size) == ERROR_SUCCESS;
+    }
+    RegCloseKey(hKey);
+    if (!ok) return false;
+
+    std::string text;
+    for (const wchar_t* p = w.c_str(); *p; p++) text.push_back(static_cast<char>(*p));
+    return Parse(text, out);
+}
+
+bool CalibrationCache::Save(const CachedCalibration& c) {
+    HKEY hKey{};
+    if (RegCreateKeyExW(HKEY_CURRENT_USER, kRegPath, 0, nullptr, 0, KEY_WRITE, nullptr, &hKey, nullptr) != ERROR_SUCCESS) {
+        return false;
+    }
+
+    // CPU model and topology text are ASCII in practice; widen byte-wise.
+    const std::string text = Serialize(c);
+    const std::wstring w(text.begin(), text.end());
+    const bool ok = RegSetValueExW(hKey, kRegValue, 0, REG_SZ, reinterpret_cast<const BYTE*>(w.c_str()),
+        static_cast<DWORD>((w.size() + 1) * sizeof(wchar_t))) == ERROR_SUCCESS;
+    RegCloseKey(hKey);
+    return ok;
+}
+
+#else
+
+static std::string CacheDir() {
+    if (const char* xdg = std::getenv("XDG_CACHE_HOME")) {
+        if (*xdg) return std::string(xdg) + "/input-latency-optimizer";
+    }
+    const char* home = std::getenv("HOME");
+    if (!home || !*home) return std::string();
+    return std::string(home) + "/.cache/input-latency-optimizer";
+}
+
+bool CalibrationCache::Load(CachedCalibration& out) {
+    const std::string dir = CacheDir();
+    if (dir.empty()) return false;
+
+    std::ifstream f(dir + "/calibration");
+    if (!f) return false;
+    std::ostringstream text;
+    text << f.rdbuf();
+    return Parse(text.str(), out);
+}
+
+bool CalibrationCache::Save(const CachedCalibration& c) {
+    const std::string dir = CacheDir();
+    if (dir.empty()) return false;
+
+    // Create the directory and any missing parent (~/.cache).
+    for (size_t slash = dir.find('/', 1); ; slash = dir.find('/', slash + 1)) {
+        const std::string part = dir.substr(0, slash);
+        mkdir(part.c_str(), 0755);
+        if (slash == std::string::npos) break;
+    }
+
+    // Write then rename, so a reader never sees a half-written file.
+    const std::string path = dir + "/calibration";
+    const std::string tmp = path + ".tmp";
+    {
+        std::ofstream f(tmp, std::ios::trunc);
+        if (!f) return false;
+        f << Serialize(c);
+        if (!f.flush()) return false;
+    }
+    return std::rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+#endif
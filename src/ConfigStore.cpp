@@ -14,6 +14,17 @@ static bool ReadQWORD(HKEY hKey, const wchar_t* name, ULONGLONG& out) {
     return type == REG_QWORD;
 }
 
+static bool ReadString(HKEY hKey, const wchar_t* name, std::string& out) {
+    wchar_t buf[1024]{};
+    DWORD sz = sizeof(buf) - sizeof(wchar_t);
+    DWORD type = 0;
+    if (RegQueryValueExW(hKey, name, nullptr, &type, reinterpret_cast<LPBYTE>(buf), &sz) != ERROR_SUCCESS) return false;
+    if (type != REG_SZ) return false;
+    out.clear();
+    for (const wchar_t* p = buf; *p; p++) out.push_back(static_cast<char>(*p)); // ASCII CPU lists only
+    return true;
+}
+
 static void WriteDWORD(HKEY hKey, const wchar_t* name, DWORD v) {
     RegSetValueExW(hKey, name, 0, REG_DWORD, reinterpret_cast<const BYTE*>(&v), sizeof(v));
 }
@@ -22,6 +33,12 @@ static void WriteQWORD(HKEY hKey, const wchar_t* name, ULONGLONG v) {
     RegSetValueExW(hKey, name, 0, REG_QWORD, reinterpret_cast<const BYTE*>(&v), sizeof(v));
 }
 
+static void WriteString(HKEY hKey, const wchar_t* name, const std::string& v) {
+    const std::wstring w(v.begin(), v.end());
+    RegSetValueExW(hKey, name, 0, REG_SZ, reinterpret_cast<const BYTE*>(w.c_str()),
+        static_cast<DWORD>((w.size() + 1) * sizeof(wchar_t)));
+}
+
 bool ConfigStore::Load(StoredConfig& out) {
     HKEY hKey{};
     LONG r = RegOpenKeyExW(HKEY_CURRENT_USER, kRegPath, 0, KEY_READ, &hKey);
@@ -67,9 +84,17 @@ bool ConfigStore::Load(StoredConfig& out) {
         ReadDWORD(hKey, L"A_AffEnable", v);
         out.appliedConfig.enableAffinity = (v != 0);
 
+        // A_AffCpus (CPU list, any group) supersedes the group-0 A_AffMask
+        // written by older versions.
+        std::string cpus;
         ULONGLONG q = 0;
-        if (ReadQWORD(hKey, L"A_AffMask", q)) out.appliedConfig.affinityMask = (DWORD_PTR)q;
-        else out.appliedConfig.affinityMask = 0;
+        out.appliedConfig.affinity.Clear();
+        if (ReadString(hKey, L"A_AffCpus", cpus)) CpuSet::Parse(cpus, out.appliedConfig.affinity);
+        else if (ReadQWORD(hKey, L"A_AffMask", q)) out.appliedConfig.affinity = CpuSet::FromMask(q);
+
+        v = 1; // absent in configs saved before batched reads existed
+        ReadDWORD(hKey, L"A_BatchReads", v);
+        out.appliedConfig.enableBatchedReads = (v != 0);
     }
 
     RegCloseKey(hKey);
@@ -113,7 +138,10 @@ void ConfigStore::SaveApplied(DWORD appliedMode, const InputThread::Config& cfg,
     WriteDWORD(hKey, L"A_ThrPrio", (DWORD)cfg.threadPriority);
 
     WriteDWORD(hKey, L"A_AffEnable", cfg.enableAffinity ? 1 : 0);
-    WriteQWORD(hKey, L"A_AffMask", (ULONGLONG)cfg.affinityMask);
+    WriteQWORD(hKey, L"A_AffMask", cfg.affinity.GroupMask(0));
+    WriteString(hKey, L"A_AffCpus", cfg.affinity.ToString());
+
+    WriteDWORD(hKey, L"A_BatchReads", cfg.enableBatchedReads ? 1 : 0);
 
     RegCloseKey(hKey);
 }
@@ -0,0 +1,321 @@
+#include "../include/CpuSet.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <errno.h>
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+static int PopCount(uint64_t v) {
+    int n = 0;
+    while (v) {
+        v &= v - 1;
+        n++;
+    }
+    return n;
+}
+
+static int LowestBit(uint64_t v) {
+    int b = 0;
+    while (!(v & 1)) {
+        v >>= 1;
+        b++;
+    }
+    return b;
+}
+
+CpuSet CpuSet::Of(uint32_t cpu) {
+    CpuSet s;
+    s.Set(cpu);
+    return s;
+}
+
+CpuSet CpuSet::FromMask(uint64_t mask, uint16_t group) {
+    CpuSet s;
+    if (mask) {
+        s.words_.assign(static_cast<size_t>(group) + 1, 0);
+        s.words_[group] = mask;
+    }
+    return s;
+}
+
+bool CpuSet::Parse(const std::string& text, CpuSet& out) {
+    CpuSet s;
+    size_t i = 0;
+    while (i < text.size() && std::isspace(static_cast<unsigned char>(text[i]))) i++;
+    size_t end = text.size();
+    while (end > i && std::isspace(static_cast<unsigned char>(text[end - 1]))) end--;
+
+    if (end - i > 2 && text[i] == '0' && (text[i + 1] == 'x' || text[i + 1] == 'X')) {
+        // Hex mask: digits from the right are CPUs 0-3, 4-7, ...
+        uint32_t cpu = 0;
+        for (size_t k = end; k > i + 2; k--, cpu += 4) {
+            const char c = text[k - 1];
+            if (c == ',' || c == '_') { cpu -= 4; continue; } // grouping, as in /proc masks
+            if (!std::isxdigit(static_cast<unsigned char>(c))) return false;
+            const int v = std::isdigit(static_cast<unsigned char>(c)) ? c - '0' : (std::tolower(c) - 'a' + 10);
+            for (int b = 0; b < 4; b++) {
+                if (v & (1 << b)) s.Set(cpu + b);
+            }
+        }
+        out = s;
+        return true;
+    }
+
+    const char* p = text.c_str() + i;
+    const char* stop = text.c_str() + end;
+    while (p < stop) {
+        char* next = nullptr;
+        const unsigned long lo = std::strtoul(p, &next, 10);
+        if (next == p) return false;
+        unsigned long hi = lo;
+        p = next;
+        if (p < stop && *p == '-') {
+            hi = std::strtoul(p + 1, &next, 10);
+            if (next == p + 1 || hi < lo) return false;
+            p = next;
+        }
+        if (hi >= 65536) return false;
+        for (unsigned long c = lo; c <= hi; c++) s.Set(static_cast<uint32_t>(c));
+        if (p < stop) {
+            if (*p != ',') return false;
+            p++;
+        }
+    }
+    out = s;
+    return true;
+}
+
+std::string CpuSet::ToString() const {
+    std::string out;
+    for (int c = First(); c >= 0;) {
+        int last = c;
+        int n = Next(c);
+        while (n == last + 1) {
+            last = n;
+            n = Next(n);
+        }
+        if (!out.empty()) out += ',';
+        out += std::to_string(c);
+        if (last != c) out += '-' + std::to_string(last);
+        c = n;
+    }
+    return out;
+}
+
+void CpuSet::Set(uint32_t cpu) {
+    const size_t w = cpu / 64;
+    if (w >= words_.size()) words_.resize(w + 1, 0);
+    words_[w] |= uint64_t(1) << (cpu % 64);
+}
+
+void CpuSet::Reset(uint32_t cpu) {
+    const size_t w = cpu / 64;
+    if (w >= words_.size()) return;
+    words_[w] &= ~(uint64_t(1) << (cpu % 64));
+    Trim();
+}
+
+bool CpuSet::Test(uint32_t cpu) const {
+    const size_t w = cpu / 64;
+    return w < words_.size() && ((words_[w] >> (cpu % 64)) & 1);
+}
+
+bool CpuSet::Empty() const {
+    return words_.empty();
+}
+
+size_t CpuSet::Count() const {
+    size_t n = 0;
+    for (uint64_t w : words_) n += static_cast<size_t>(PopCount(w));
+    return n;
+}
+
+int CpuSet::First() const {
+    return Next(-1);
+}
+
+int CpuSet::Next(int after) const {
+    uint32_t cpu = static_cast<uint32_t>(after + 1);
+    for (size_t w = cpu / 64; w < words_.size(); w++, cpu = static_cast<uint32_t>(w * 64)) {
+        const uint64_t bits = words_[w] & (~uint64_t(0) << (cpu % 64));
+        if (bits) return static_cast<int>(w * 64 + LowestBit(bits));
+    }
+    return -1;
+}
+
+uint64_t CpuSet::GroupMask(uint16_t group) const {
+    return group < words_.size() ? words_[group] : 0;
+}
+
+uint16_t CpuSet::GroupCount() const {
+    return static_cast<uint16_t>(words_.size());
+}
+
+bool CpuSet::Intersects(const CpuSet& other) const {
+    const size_t n = std::min(words_.size(), other.words_.size());
+    for (size_t i = 0; i < n; i++) {
+        if (words_[i] & other.words_[i]) return true;
+    }
+    return false;
+}
+
+bool CpuSet::IsSubsetOf(const CpuSet& other) const {
+    for (size_t i = 0; i < words_.size(); i++) {
+        if (words_[i] & ~other.GroupMask(static_cast<uint16_t>(i))) return false;
+    }
+    return true;
+}
+
+CpuSet& CpuSet::operator|=(const CpuSet& other) {
+    if (other.words_.size() > words_.size()) words_.resize(other.words_.size(), 0);
+    for (size_t i = 0; i < other.words_.size(); i++) words_[i] |= other.words_[i];
+    return *this;
+}
+
+CpuSet& CpuSet::operator&=(const CpuSet& other) {
+    if (words_.size() > other.words_.size()) words_.resize(other.words_.size());
+    for (size_t i = 0; i < words_.size(); i++) words_[i] &= other.words_[i];
+    Trim();
+    return *this;
+}
+
+CpuSet& CpuSet::operator-=(const CpuSet& other) {
+    const size_t n = std::min(words_.size(), other.words_.size());
+    for (size_t i = 0; i < n; i++) words_[i] &= ~other.words_[i];
+    Trim();
+    return *this;
+}
+
+bool CpuSet::operator==(const CpuSet& other) const {
+    return words_ == other.words_;
+}
+
+void CpuSet::Trim() {
+    while (!words_.empty() && words_.back() == 0) words_.pop_back();
+}
+
+#ifdef _WIN32
+
+CpuSet CpuSet::Online() {
+    CpuSet s;
+    const WORD groups = GetActiveProcessorGroupCount();
+    for (WORD g = 0; g < groups; g++) {
+        const DWORD n = GetActiveProcessorCount(g);
+        s |= FromMask(n >= 64 ? ~uint64_t(0) : (uint64_t(1) << n) - 1, g);
+    }
+    return s;
+}
+
+CpuSet CpuSet::Process() {
+    // A process confined to one group honours its affinity mask; one that
+    // spans groups may use every processor of the groups it was given.
+    USHORT groups[64]{};
+    USHORT count = 64;
+    if (!GetProcessGroupAffinity(GetCurrentProcess(), &count, groups) || count == 0) return Online();
+
+    if (count == 1) {
+        DWORD_PTR procMask = 0, sysMask = 0;
+        if (GetProcessAffinityMask(GetCurrentProcess(), &procMask, &sysMask) && procMask) {
+            return FromMask(procMask, groups[0]);
+        }
+    }
+
+    const CpuSet online = Online();
+    CpuSet s;
+    for (USHORT i = 0; i < count; i++) s |= FromMask(online.GroupMask(groups[i]), groups[i]);
+    return s;
+}
+
+bool CpuSet::OfThread(void* thread, CpuSet& out) {
+    GROUP_AFFINITY ga{};
+    if (!GetThreadGroupAffinity(static_cast<HANDLE>(thread), &ga)) return false;
+    out = FromMask(ga.Mask, ga.Group);
+    return true;
+}
+
+bool CpuSet::ApplyTo(void* thread) const {
+    for (WORD g = 0; g < words_.size(); g++) {
+        if (!words_[g]) continue;
+        GROUP_AFFINITY ga{};
+        ga.Group = g;
+        ga.Mask = static_cast<KAFFINITY>(words_[g]);
+        return SetThreadGroupAffinity(static_cast<HANDLE>(thread), &ga, nullptr) != FALSE;
+    }
+    return false;
+}
+
+#else
+
+// sched_getaffinity fails with EINVAL while the buffer is smaller than the
+// kernel's CPU mask, so grow until it fits.
+static bool ReadAffinity(pid_t tid, CpuSet& out) {
+    for (size_t cpus = CPU_SETSIZE; cpus <= (size_t(1) << 20); cpus *= 2) {
+        cpu_set_t* set = CPU_ALLOC(cpus);
+        if (!set) return false;
+        const size_t size = CPU_ALLOC_SIZE(cpus);
+        CPU_ZERO_S(size, set);
+        if (sched_getaffinity(tid, size, set) == 0) {
+            CpuSet s;
+            for (size_t c = 0; c < cpus; c++) {
+                if (CPU_ISSET_S(c, size, set)) s.Set(static_cast<uint32_t>(c));
+            }
+            CPU_FREE(set);
+            out = s;
+            return true;
+        }
+        CPU_FREE(set);
+        if (errno != EINVAL) return false;
+    }
+    return false;
+}
+
+CpuSet CpuSet::Online() {
+    CpuSet s;
+    const long n = sysconf(_SC_NPROCESSORS_CONF);
+    for (long c = 0; c < n; c++) s.Set(static_cast<uint32_t>(c));
+
+    // Prefer the real online list; CPUs may be offline or sparse.
+    CpuSet online;
+    if (FILE* f = std::fopen("/sys/devices/system/cpu/online", "r")) {
+        char line[4096]{};
+        const bool ok = std::fgets(line, sizeof(line), f) != nullptr;
+        std::fclose(f);
+        if (ok && Parse(line, online) && !online.Empty()) return online;
+    }
+    return s;
+}
+
+CpuSet CpuSet::Process() {
+    CpuSet s;
+    if (!ReadAffinity(getpid(), s)) s = Online();
+    return s;
+}
+
+bool CpuSet::OfThread(int tid, CpuSet& out) {
+    return ReadAffinity(tid, out);
+}
+
+bool CpuSet::ApplyTo(int tid) const {
+    if (Empty()) return false;
+    const size_t cpus = std::max<size_t>(words_.size() * 64, CPU_SETSIZE);
+    cpu_set_t* set = CPU_ALLOC(cpus);
+    if (!set) return false;
+    const size_t size = CPU_ALLOC_SIZE(cpus);
+    CPU_ZERO_S(size, set);
+    for (int c = First(); c >= 0; c = Next(c)) CPU_SET_S(static_cast<size_t>(c), size, set);
+    const bool ok = sched_setaffinity(tid, size, set) == 0;
+    CPU_FREE(set);
+    return ok;
+}
+
+#endif
@@ -0,0 +1,440 @@
+#include "../include/CpuTopology.h"
+#include "../include/CpuSet.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <set>
+#include <tuple>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <cstdlib>
+#include <fstream>
+#include <unistd.h>
+#endif
+
+// Capacity below 95% of the fastest CPU counts as a slower (E-)core class;
+// favored-core turbo differences stay inside one class.
+static bool SlowerClass(uint32_t capacity, uint32_t maxCapacity) {
+    return static_cast<uint64_t>(capacity) * 100 < static_cast<uint64_t>(maxCapacity) * 95;
+}
+
+static std::string JoinIndices(const std::vector<uint32_t>& v) {
+    std::string s;
+    for (size_t i = 0; i < v.size(); i++) {
+        if (i) s += ',';
+        s += std::to_string(v[i]);
+    }
+    return s;
+}
+
+#ifndef _WIN32
+
+static std::string ReadLine(const std::string& path) {
+    std::ifstream f(path);
+    std::string line;
+    if (!f || !std::getline(f, line)) return std::string();
+    while (!line.empty() && (line.back() == '\n' || line.back() == ' ' || line.back() == '\r')) line.pop_back();
+    return line;
+}
+
+static bool ReadUnsigned(const std::string& path, unsigned long long& v) {
+    const std::string s = ReadLine(path);
+    if (s.empty()) return false;
+    char* end = nullptr;
+    v = std::strtoull(s.c_str(), &end, 10);
+    return end != s.c_str();
+}
+
+// Kernel CPU list format: "0-3,8,10-11".
+static std::vector<uint32_t> ParseCpuList(const std::string& s) {
+    std::vector<uint32_t> out;
+    const char* p = s.c_str();
+    while (*p) {
+        char* end = nullptr;
+        const unsigned long lo = std::strtoul(p, &end, 10);
+        if (end == p) break;
+        unsigned long hi = lo;
+        p = end;
+        if (*p == '-') {
+            hi = std::strtoul(p + 1, &end, 10);
+            p = end;
+        }
+        for (unsigned long c = lo; c <= hi && c < 65536; c++) out.push_back(static_cast<uint32_t>(c));
+        if (*p != ',') break;
+        p++;
+    }
+    return out;
+}
+
+static bool Contains(const std::vector<uint32_t>& v, uint32_t x) {
+    return std::find(v.begin(), v.end(), x) != v.end();
+}
+
+static int32_t Lowest(const std::vector<uint32_t>& v) {
+    return v.empty() ? -1 : static_cast<int32_t>(*std::min_element(v.begin(), v.end()));
+}
+
+static int32_t NumaNodeOf(const std::string& cpuDir) {
+    DIR* d = opendir(cpuDir.c_str());
+    if (!d) return -1;
+    int32_t node = -1;
+    while (dirent* e = readdir(d)) {
+        if (std::strncmp(e->d_name, "node", 4) == 0 && e->d_name[4] >= '0' && e->d_name[4] <= '9') {
+            node = std::atoi(e->d_name + 4);
+            break;
+        }
+    }
+    closedir(d);
+    return node;
+}
+
+CpuTopology CpuTopology::FromSysfs(const std::string& root) {
+    CpuTopology t;
+
+    std::vector<uint32_t> present = ParseCpuList(ReadLine(root + "/present"));
+    if (present.empty()) present = ParseCpuList(ReadLine(root + "/possible"));
+    const std::string onlineText = ReadLine(root + "/online");
+    const std::vector<uint32_t> online = ParseCpuList(onlineText);
+    const std::vector<uint32_t> isolated = ParseCpuList(ReadLine(root + "/isolated"));
+    const std::vector<uint32_t> nohz = ParseCpuList(ReadLine(root + "/nohz_full"));
+
+    // Intel hybrid parts list their core types under the PMU devices.
+    const std::vector<uint32_t> atom = ParseCpuList(ReadLine(root + "/../../cpu_atom/cpus"));
+
+    std::vector<unsigned long long> maxFreq;
+    bool haveCapacity = true;
+
+    for (uint32_t c : present) {
+        const std::string dir = root + "/cpu" + std::to_string(c);
+
+        LogicalCpu cpu{};
+        cpu.index = c;
+        cpu.number = static_cast<uint8_t>(c & 63);
+        cpu.online = onlineText.empty() || Contains(online, c);
+        cpu.isolated = Contains(isolated, c);
+        cpu.nohzFull = Contains(nohz, c);
+
+        std::vector<uint32_t> siblings = ParseCpuList(ReadLine(dir + "/topology/thread_siblings_list"));
+        if (siblings.empty()) siblings.push_back(c);
+        cpu.core = Lowest(siblings);
+        cpu.smtThreads = static_cast<uint8_t>(std::min<size_t>(siblings.size(), 255));
+
+        unsigned long long v = 0;
+        if (ReadUnsigned(dir + "/topology/physical_package_id", v)) cpu.package = static_cast<int32_t>(v);
+        cpu.numaNode = NumaNodeOf(dir);
+
+        for (int i = 0; i < 10; i++) {
+            const std::string idx = dir + "/cache/index" + std::to_string(i);
+            unsigned long long level = 0;
+            if (!ReadUnsigned(idx + "/level", level)) {
+                if (i >= 4) break;
+                continue;
+            }
+            if (ReadLine(idx + "/type") == "Instruction") continue;
+            const int32_t domain = Lowest(ParseCpuList(ReadLine(idx + "/shared_cpu_list")));
+            if (level == 2) cpu.l2 = domain;
+            else if (level == 3) cpu.l3 = domain;
+        }
+
+        if (ReadUnsigned(dir + "/cpu_capacity", v) && v > 0) cpu.capacity = static_cast<uint32_t>(v);
+        else haveCapacity = false;
+
+        unsigned long long freq = 0;
+        ReadUnsigned(dir + "/cpufreq/cpuinfo_max_freq", freq);
+        maxFreq.push_back(freq);
+
+        t.cpus_.push_back(cpu);
+    }
+
+    // Without cpu_capacity (most x86 kernels), rank by maximum frequency, and
+    // failing that by the hybrid PMU's core-type list.
+    if (!haveCapacity) {
+        const unsigned long long top = maxFreq.empty() ? 0 : *std::max_element(maxFreq.begin(), maxFreq.end());
+        for (size_t i = 0; i < t.cpus_.size(); i++) {
+            LogicalCpu& cpu = t.cpus_[i];
+            cpu.capacity = 1024;
+            if (top > 0 && maxFreq[i] > 0) cpu.capacity = static_cast<uint32_t>(maxFreq[i] * 1024 / top);
+            if (!atom.empty() && Contains(atom, cpu.index) && !SlowerClass(cpu.capacity, 1024)) cpu.capacity = 512;
+        }
+    }
+
+    t.Finish();
+    return t;
+}
+
+CpuTopology CpuTopology::Detect() {
+    CpuTopology t = FromSysfs("/sys/devices/system/cpu");
+
+    if (t.cpus_.empty()) {
+        const long n = sysconf(_SC_NPROCESSORS_ONLN);
+        for (long c = 0; c < n; c++) {
+            LogicalCpu cpu{};
+            cpu.index = static_cast<uint32_t>(c);
+            cpu.number = static_cast<uint8_t>(c & 63);
+            cpu.core = static_cast<int32_t>(c);
+            t.cpus_.push_back(cpu);
+        }
+    }
+
+    // Isolated CPUs are outside the inherited affinity by design but may
+    // still be targeted explicitly, so they stay eligible.
+    const CpuSet process = CpuSet::Process();
+    for (LogicalCpu& cpu : t.cpus_) cpu.allowed = cpu.online && (process.Test(cpu.index) || cpu.isolated);
+
+    t.Finish();
+    return t;
+}
+
+#else
+
+CpuTopology CpuTopology::Detect() {
+    CpuTopology t;
+
+    DWORD len = 0;
+    GetLogicalProcessorInformationEx(RelationAll, nullptr, &len);
+    std::vector<uint8_t> buf(len);
+    if (len == 0 || !GetLogicalProcessorInformationEx(RelationAll,
+            reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(buf.data()), &len)) {
+        const DWORD n = GetActiveProcessorCount(ALL_PROCESSOR_GROUPS);
+        for (DWORD c = 0; c < n && c < 64; c++) {
+            LogicalCpu cpu{};
+            cpu.index = c;
+            cpu.number = static_cast<uint8_t>(c);
+            cpu.core = static_cast<int32_t>(c);
+            t.cpus_.push_back(cpu);
+        }
+        t.Finish();
+        return t;
+    }
+
+    const auto forEach = [&](LOGICAL_PROCESSOR_RELATIONSHIP rel, auto&& fn) {
+        for (DWORD off = 0; off < len;) {
+            auto* info = reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(buf.data() + off);
+            if (info->Relationship == rel) fn(*info);
+            off += info->Size;
+        }
+    };
+    const auto indicesOf = [](const GROUP_AFFINITY& ga) {
+        std::vector<uint32_t> v;
+        for (uint32_t b = 0; b < 64; b++) {
+            if (ga.Mask & (KAFFINITY(1) << b)) v.push_back(static_cast<uint32_t>(ga.Group) * 64 + b);
+        }
+        return v;
+    };
+    const auto find = [&](uint32_t index) -> LogicalCpu* {
+        for (LogicalCpu& c : t.cpus_) {
+            if (c.index == index) return &c;
+        }
+        return nullptr;
+    };
+
+    // Cores first: they enumerate every logical processor.
+    BYTE maxClass = 0;
+    forEach(RelationProcessorCore, [&](const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX& info) {
+        const std::vector<uint32_t> members = indicesOf(info.Processor.GroupMask[0]);
+        if (members.empty()) return;
+        maxClass = std::max(maxClass, info.Processor.EfficiencyClass);
+        for (uint32_t idx : members) {
+            LogicalCpu cpu{};
+            cpu.index = idx;
+            cpu.group = static_cast<uint16_t>(idx / 64);
+            cpu.number = static_cast<uint8_t>(idx % 64);
+            cpu.core = static_cast<int32_t>(members.front());
+            cpu.smtThreads = static_cast<uint8_t>(members.size());
+            cpu.capacity = info.Processor.EfficiencyClass; // scaled below
+            t.cpus_.push_back(cpu);
+        }
+    });
+
+    // Higher EfficiencyClass means faster; all zero on non-hybrid parts.
+    for (LogicalCpu& c : t.cpus_) c.capacity = (c.capacity + 1) * 1024 / (maxClass + 1u);
+
+    int32_t package = 0;
+    forEach(RelationProcessorPackage, [&](const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX& info) {
+        for (WORD g = 0; g < info.Processor.GroupCount; g++) {
+            for (uint32_t idx : indicesOf(info.Processor.GroupMask[g])) {
+                if (LogicalCpu* c = find(idx)) c->package = package;
+            }
+        }
+        package++;
+    });
+
+    forEach(RelationCache, [&](const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX& info) {
+        if (info.Cache.Type == CacheInstruction || (info.Cache.Level != 2 && info.Cache.Level != 3)) return;
+        const std::vector<uint32_t> members = indicesOf(info.Cache.GroupMask);
+        if (members.empty()) return;
+        for (uint32_t idx : members) {
+            if (LogicalCpu* c = find(idx)) (info.Cache.Level == 2 ? c->l2 : c->l3) = static_cast<int32_t>(members.front());
+        }
+    });
+
+    forEach(RelationNumaNode, [&](const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX& info) {
+        for (uint32_t idx : indicesOf(info.NumaNode.GroupMask)) {
+            if (LogicalCpu* c = find(idx)) c->numaNode = static_cast<int32_t>(info.NumaNode.NodeNumber);
+        }
+    });
+
+    std::sort(t.cpus_.begin(), t.cpus_.end(),
+        [](const LogicalCpu& a, const LogicalCpu& b) { return a.index < b.index; });
+
+    const CpuSet process = CpuSet::Process();
+    for (LogicalCpu& c : t.cpus_) c.allowed = process.Test(c.index);
+
+    t.Finish();
+    return t;
+}
+
+#endif
+
+void CpuTopology::Finish() {
+    max_capacity_ = 0;
+    for (const LogicalCpu& c : cpus_) {
+        if (c.online) max_capacity_ = std::max(max_capacity_, c.capacity);
+    }
+    // Normalize so the fastest class reads 1024 whatever the source scale was.
+    if (max_capacity_ > 0 && max_capacity_ != 1024) {
+        for (LogicalCpu& c : cpus_) c.capacity = static_cast<uint32_t>(static_cast<uint64_t>(c.capacity) * 1024 / max_capacity_);
+        max_capacity_ = 1024;
+    }
+}
+
+const LogicalCpu* CpuTopology::Find(uint32_t index) const {
+    for (const LogicalCpu& c : cpus_) {
+        if (c.index == index) return &c;
+    }
+    return nullptr;
+}
+
+size_t CpuTopology::AllowedCount() const {
+    return static_cast<size_t>(std::count_if(cpus_.begin(), cpus_.end(),
+        [](const LogicalCpu& c) { return c.online && c.allowed; }));
+}
+
+bool CpuTopology::IsHybrid() const {
+    return std::any_of(cpus_.begin(), cpus_.end(),
+        [this](const LogicalCpu& c) { return c.online && SlowerClass(c.capacity, max_capacity_); });
+}
+
+bool CpuTopology::HasSmt() const {
+    return std::any_of(cpus_.begin(), cpus_.end(), [](const LogicalCpu& c) { return c.smtThreads > 1; });
+}
+
+std::vector<uint32_t> CpuTopology::Candidates(size_t max) const {
+    // CPU 0 (and its SMT sibling) takes unrouted interrupts and most
+    // housekeeping work.
+    const LogicalCpu* cpu0 = Find(0);
+    const int32_t housekeepingCore = cpu0 ? cpu0->core : 0;
+
+    std::vector<const LogicalCpu*> pool;
+    for (const LogicalCpu& c : cpus_) {
+        if (c.online && c.allowed) pool.push_back(&c);
+    }
+
+    const auto rankKey = [&](const LogicalCpu* c) {
+        return std::make_tuple(
+            c->isolated ? 0 : (c->nohzFull ? 1 : 2),
+            SlowerClass(c->capacity, max_capacity_) ? 1 : 0,
+            0u - c->capacity,
+            c->core == housekeepingCore ? 1 : 0,
+            static_cast<int32_t>(c->index) == c->core ? 0 : 1,
+            c->index);
+    };
+    std::stable_sort(pool.begin(), pool.end(),
+        [&](const LogicalCpu* a, const LogicalCpu* b) { return rankKey(a) < rankKey(b); });
+
+    // Spread the probes: each pass relaxes one diversity requirement, so the
+    // first picks land on different L3s, then different L2s, then different
+    // physical cores, and SMT siblings only fill what is left.
+    std::vector<uint32_t> out;
+    std::set<int32_t> cores, l2s, l3s;
+    for (int pass = 0; pass < 4 && out.size() < max; pass++) {
+        for (const LogicalCpu* c : pool) {
+            if (out.size() >= max) break;
+            if (std::find(out.begin(), out.end(), c->index) != out.end()) continue;
+            if (pass <= 2 && cores.count(c->core)) continue;
+            if (pass <= 1 && c->l2 >= 0 && l2s.count(c->l2)) continue;
+            if (pass == 0 && c->l3 >= 0 && l3s.count(c->l3)) continue;
+            out.push_back(c->index);
+            cores.insert(c->core);
+            l2s.insert(c->l2);
+            l3s.insert(c->l3);
+        }
+    }
+    return out;
+}
+
+std::string CpuTopology::Describe(uint32_t index) const {
+    const LogicalCpu* c = Find(index);
+    if (!c) return "cpu " + std::to_string(index) + ": unknown";
+
+    std::set<int32_t> nodes, l3s;
+    for (const LogicalCpu& o : cpus_) {
+        nodes.insert(o.numaNode);
+        l3s.insert(o.l3);
+    }
+
+    std::vector<std::string> parts;
+    if (IsHybrid()) {
+        parts.push_back(std::string(SlowerClass(c->capacity, max_capacity_) ? "E-core" : "P-core") +
+            " (capacity " + std::to_string(c->capacity) + ")");
+    }
+    if (c->isolated) parts.push_back("isolated (isolcpus)");
+    if (c->nohzFull) parts.push_back("nohz_full");
+
+    std::vector<uint32_t> siblings, l2Sharers;
+    for (const LogicalCpu& o : cpus_) {
+        if (o.index == c->index) continue;
+        if (o.core == c->core) siblings.push_back(o.index);
+        if (c->l2 >= 0 && o.l2 == c->l2) l2Sharers.push_back(o.index);
+    }
+    if (!siblings.empty()) parts.push_back("SMT with cpu " + JoinIndices(siblings));
+    else if (HasSmt()) parts.push_back("own physical core");
+
+    if (c->l2 >= 0) {
+        if (l2Sharers.size() > siblings.size()) parts.push_back("L2 shared with " + std::to_string(l2Sharers.size()) + " CPUs");
+        else parts.push_back("private L2");
+    }
+    if (c->l3 >= 0 && l3s.size() > 1) parts.push_back("L3 of cpu " + std::to_string(c->l3));
+    if (nodes.size() > 1 && c->numaNode >= 0) parts.push_back("NUMA node " + std::to_string(c->numaNode));
+
+    const LogicalCpu* cpu0 = Find(0);
+    if (cpu0 && c->core == cpu0->core && cpus_.size() > 1) parts.push_back("housekeeping core");
+
+    std::string s = "cpu " + std::to_string(c->index);
+    if (c->group) s += " (group " + std::to_string(c->group) + ")";
+    for (size_t i = 0; i < parts.size(); i++) s += (i ? ", " : ": ") + parts[i];
+    return s;
+}
+
+std::string CpuTopology::Summary() const {
+    std::set<int32_t> cores, packages, nodes;
+    std::vector<uint32_t> isolated, nohz;
+    size_t fast = 0, slow = 0;
+    for (const LogicalCpu& c : cpus_) {
+        if (!c.online) continue;
+        cores.insert(c.core);
+        packages.insert(c.package);
+        if (c.numaNode >= 0) nodes.insert(c.numaNode);
+        if (c.isolated) isolated.push_back(c.index);
+        if (c.nohzFull) nohz.push_back(c.index);
+        (SlowerClass(c.capacity, max_capacity_) ? slow : fast)++;
+    }
+
+    char buf[160];
+    std::snprintf(buf, sizeof(buf), "%zu CPUs (%zu allowed) on %zu cores%s, %zu package%s",
+        fast + slow, AllowedCount(), cores.size(), HasSmt() ? " (SMT)" : "",
+        packages.size(), packages.size() == 1 ? "" : "s");
+    std::string s = buf;
+
+    if (slow) s += ", hybrid " + std::to_string(fast) + "P+" + std::to_string(slow) + "E";
+    if (nodes.size() > 1) s += ", " + std::to_string(nodes.size()) + " NUMA nodes";
+    if (!isolated.empty()) s += ", isolated " + JoinIndices(isolated);
+    if (!nohz.empty()) s += ", nohz_full " + JoinIndices(nohz);
+    return s;
+}
@@ -0,0 +1,192 @@
+#include "../include/DeviceStats.h"
+#include "../include/LatencyMeasurer.h"
+#include <algorithm>
+#include <cmath>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+static constexpr int64_t kPublishPerSecond = 10;
+static constexpr int64_t kWindowNs = 1000000000ll;    // report interval window
+static constexpr uint64_t kIdleGapNs = 100000000ull;  // longer gaps: the device was idle
+static constexpr uint64_t kMinWindowGaps = 8;
+static constexpr uint64_t kMaxLatencyNs = (1ull << 30) - 1; // ~1.07 s, top bucket
+
+static int Log2Floor(uint64_t v) {
+#if defined(_MSC_VER)
+    unsigned long idx = 0;
+    _BitScanReverse64(&idx, v | 1);
+    return static_cast<int>(idx);
+#else
+    return 63 - __builtin_clzll(v | 1);
+#endif
+}
+
+DeviceStatsTable::DeviceStatsTable() {
+    frequency_ = LatencyMeasurer::TickFrequency();
+    publish_interval_ = frequency_ / kPublishPerSecond;
+    Reset();
+}
+
+int DeviceStatsTable::Bucket(uint64_t ns) {
+    if (ns < kSubBuckets) return static_cast<int>(ns);
+    ns = std::min(ns, kMaxLatencyNs);
+    const int shift = Log2Floor(ns) - 3;
+    return (shift + 1) * kSubBuckets + static_cast<int>((ns >> shift) & (kSubBuckets - 1));
+}
+
+// Midpoint of the bucket, in ns.
+double DeviceStatsTable::BucketValue(int index) {
+    if (index < kSubBuckets) return index;
+    const int shift = index / kSubBuckets - 1;
+    const double low = static_cast<double>(static_cast<uint64_t>(kSubBuckets + index % kSubBuckets) << shift);
+    return low + static_cast<double>((1ull << shift) - 1) / 2.0;
+}
+
+void DeviceStatsTable::Reset() {
+    count_ = 0;
+    last_ = 0;
+    untracked_ = 0;
+    std::fill(std::begin(keys_), std::end(keys_), 0);
+    for (Entry& e : entries_) e = Entry{};
+    dirty_ = false;
+    published_.Store(DeviceStatsSnapshot{});
+}
+
+DeviceStatsTable::Entry* DeviceStatsTable::Find(uint64_t device) {
+    if (last_ < count_ && keys_[last_] == device) return &entries_[last_];
+
+    for (int i = 0; i < count_; i++) {
+        if (keys_[i] == device) {
+            last_ = i;
+            return &entries_[i];
+        }
+    }
+    if (count_ == kMaxDevices) return nullptr;
+
+    keys_[count_] = device;
+    last_ = count_++;
+    return &entries_[last_];
+}
+
+void DeviceStatsTable::RecordReport(Entry& e, uint64_t arrivalNs) {
+    if (e.reports++ == 0) {
+        e.windowStartNs = static_cast<int64_t>(arrivalNs);
+    } else if (arrivalNs > e.lastStampNs && arrivalNs - e.lastStampNs <= kIdleGapNs) {
+        const double gap = static_cast<double>(arrivalNs - e.lastStampNs);
+        e.windowGaps++;
+        e.windowSum += gap;
+        e.windowSumSq += gap * gap;
+    }
+    e.lastStampNs = arrivalNs;
+
+    if (static_cast<int64_t>(arrivalNs) - e.windowStartNs < kWindowNs) return;
+
+    // A window with too few intervals (a key press or two) keeps the last one.
+    if (e.windowGaps >= kMinWindowGaps) {
+        const double n = static_cast<double>(e.windowGaps);
+        e.intervalNs = e.windowSum / n;
+        e.jitterNs = std::sqrt(std::max(0.0, e.windowSumSq / n - e.intervalNs * e.intervalNs));
+    }
+    e.windowStartNs = static_cast<int64_t>(arrivalNs);
+    e.windowGaps = 0;
+    e.windowSum = 0.0;
+    e.windowSumSq = 0.0;
+}
+
+void DeviceStatsTable::Record(const InputEvent& ev, int64_t readEndTicks, int64_t readElapsedTicks) {
+    Entry* e = Find(ev.device);
+    if (!e) {
+        untracked_++;
+        return;
+    }
+
+    const bool ns = frequency_ == 1000000000ll;
+    const uint64_t endNs = ns
+        ? static_cast<uint64_t>(readEndTicks)
+        : static_cast<uint64_t>(static_cast<double>(readEndTicks) * 1e9 / static_cast<double>(frequency_));
+
+    uint64_t latencyNs = 0;
+    bool haveLatency = true;
+    if (ev.timestampNs) {
+        // Several events per report (evdev: axes, buttons, SYN_REPORT) share its stamp.
+        if (e->reports == 0 || ev.timestampNs != e->lastStampNs) RecordReport(*e, ev.timestampNs);
+        e->stamped = true;
+        haveLatency = endNs >= ev.timestampNs && endNs - ev.timestampNs <= kMaxLatencyNs; // else another clock
+        if (haveLatency) latencyNs = endNs - ev.timestampNs;
+    } else {
+        RecordReport(*e, endNs);
+        latencyNs = ns
+            ? static_cast<uint64_t>(std::max<int64_t>(0, readElapsedTicks))
+            : static_cast<uint64_t>(std::max(0.0, static_cast<double>(readElapsedTicks) * 1e9 / static_cast<double>(frequency_)));
+    }
+    e->events++;
+
+    if (haveLatency) {
+        e->buckets[Bucket(latencyNs)]++;
+        e->samples++;
+        e->maxNs = std::max(e->maxNs, latencyNs);
+    }
+    dirty_ = true;
+}
+
+void DeviceStatsTable::PublishIfDue(int64_t nowTicks) {
+    ApplyPendingReset();
+    if (dirty_ && nowTicks - last_publish_ >= publish_interval_) Publish(nowTicks);
+}
+
+void DeviceStatsTable::PublishIfDirty() {
+    ApplyPendingReset();
+    if (dirty_) Publish(LatencyMeasurer::ReadTicks());
+}
+
+void DeviceStatsTable::ApplyPendingReset() {
+    if (!reset_requested_.load(std::memory_order_relaxed)) return;
+    if (!reset_requested_.exchange(false, std::memory_order_acquire)) return;
+    Reset();
+}
+
+void DeviceStatsTable::Publish(int64_t now) {
+    DeviceStatsSnapshot snap{};
+    snap.count = count_;
+    snap.untracked = untracked_;
+
+    for (int i = 0; i < count_; i++) {
+        const Entry& e = entries_[i];
+        DeviceStats& d = snap.devices[i];
+        d.device = keys_[i];
+        d.events = e.events;
+        d.reports = e.reports;
+        d.stamped = e.stamped;
+
+        // Until the first full window, the open one.
+        double interval = e.intervalNs, jitter = e.jitterNs;
+        if (interval <= 0.0 && e.windowGaps >= 2) {
+            const double n = static_cast<double>(e.windowGaps);
+            interval = e.windowSum / n;
+            jitter = std::sqrt(std::max(0.0, e.windowSumSq / n - interval * interval));
+        }
+        d.intervalUs = interval / 1000.0;
+        d.jitterUs = jitter / 1000.0;
+        d.rateHz = interval > 0.0 ? 1e9 / interval : 0.0;
+
+        d.samples = e.samples;
+        d.maxUs = static_cast<double>(e.maxNs) / 1000.0;
+        if (!e.samples) continue;
+
+        const double quantiles[] = { 0.50, 0.95, 0.99 };
+        double* out[] = { &d.p50Us, &d.p95Us, &d.p99Us };
+        uint64_t seen = 0;
+        int q = 0;
+        for (int b = 0; b < kBuckets && q < 3; b++) {
+            seen += e.buckets[b];
+            while (q < 3 && static_cast<double>(seen) >= quantiles[q] * static_cast<double>(e.samples)) {
+                *out[q++] = std::min(BucketValue(b), static_cast<double>(e.maxNs)) / 1000.0;
+            }
+        }
+    }
+
+    published_.Store(snap);
+    last_publish_ = now;
+    dirty_ = false;
+}
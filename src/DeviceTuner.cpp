@@ -1,11 +1,77 @@
 #include "../include/DeviceTuner.h"
-#include <mmsystem.h>
+#include "../include/CpuTopology.h"
+#include "../include/CalibrationCache.h"
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <memory>
 #include <vector>
 #include <mutex>
+#include <thread>
 
+#ifdef _WIN32
+#include <mmsystem.h>
 #pragma comment(lib, "winmm.lib")
+#else
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/prctl.h>
+#include <sys/utsname.h>
+#include <time.h>
+#include <unistd.h>
+#include <fstream>
+#include <string>
+#endif
+
+// Topology-ranked cores probed by Calibrate, besides the unpinned baseline,
+// and how many probe threads run at once.
+static constexpr size_t kMaxAffinityCandidates = 16;
+static constexpr size_t kMaxParallelProbes = 16;
+
+// Sequential calibration: minimum p95 gain (us) worth acting on, samples per
+// side before the first test, the per-side cap, and the time budgets after
+// which an open test counts as "no gain".
+static constexpr double kTimerGainUs = 500.0;
+static constexpr double kAffinityGainUs = 300.0;
+static constexpr size_t kMinSamples = 24;
+static constexpr size_t kMaxSamples = 2000;
+static constexpr size_t kBoostBlock = 8;
+static constexpr double kBoostBudgetMs = 1500.0;
+static constexpr double kWaveBudgetMs = 1500.0;
+static constexpr auto kCheckInterval = std::chrono::milliseconds(25);
+
+// Most tests a sequential calibration can run, each a chance of a false
+// verdict. A core is looked at every kCheckInterval of its wave and once more
+// when the best core is chosen; the boost is looked at after every block
+// pair, at least 2 * kBoostBlock 1 ms sleeps apart.
+static constexpr int kWaveLooks = static_cast<int>(kWaveBudgetMs / kCheckInterval.count()) + 2;
+static constexpr int kBoostLooks = std::min(static_cast<int>(kMaxSamples / kBoostBlock),
+                                            static_cast<int>(kBoostBudgetMs / (2 * kBoostBlock)) + 1);
+
+// Noise probe tie-break: cores within kNoiseTieUs of the best p95 overshoot
+// are compared by time stolen during a kNoiseWindowMs spin.
+static constexpr double kNoiseTieUs = 100.0;
+static constexpr double kNoiseWindowMs = 200.0;
 
+// Calibration cache: stored results are reused for a week, and re-measured
+// on idle when they were taken at startup or are over a day old. Idle means
+// under 10% CPU for a whole poll interval (and, on Windows, no user input
+// for a minute).
+static constexpr long long kCacheMaxAgeSec = 7 * 24 * 3600;
+static constexpr long long kRevalidateAfterSec = 24 * 3600;
+static constexpr auto kIdlePollInterval = std::chrono::seconds(30);
+static constexpr double kIdleBusyFraction = 0.10;
+#ifdef _WIN32
+static constexpr DWORD kIdleInputMs = 60000;
+#endif
+
+#ifdef _WIN32
 static double QpcUs() {
     static LARGE_INTEGER freq{};
     if (freq.QuadPart == 0) QueryPerformanceFrequency(&freq);
@@ -14,47 +80,311 @@ static double QpcUs() {
     return (c.QuadPart * 1000000.0) / static_cast<double>(freq.QuadPart);
 }
 
+static void SleepOneMs() { Sleep(1); }
+#else
+static double QpcUs() {
+    timespec ts{};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000.0 + ts.tv_nsec / 1000.0;
+}
+
+static void SleepOneMs() {
+    const timespec ts{ 0, 1000000 };
+    nanosleep(&ts, nullptr);
+}
+
+static std::string ReadSysLine(const std::string& path) {
+    std::ifstream f(path);
+    std::string line;
+    std::getline(f, line);
+    return line;
+}
+#endif
+
+// Pins the calling thread to one logical CPU for the lifetime of the object.
+class ScopedCpuPin {
+public:
+    explicit ScopedCpuPin(const LogicalCpu& cpu) {
+        pinned_ = CpuSet::OfThread(Self(), previous_) && CpuSet::Of(cpu.index).ApplyTo(Self());
+    }
+
+    ~ScopedCpuPin() {
+        if (pinned_) previous_.ApplyTo(Self());
+    }
+
+    ScopedCpuPin(const ScopedCpuPin&) = delete;
+    ScopedCpuPin& operator=(const ScopedCpuPin&) = delete;
+
+    bool Pinned() const { return pinned_; }
+
+private:
+#ifdef _WIN32
+    static void* Self() { return GetCurrentThread(); }
+#else
+    static int Self() { return 0; }
+#endif
+
+    bool pinned_ = false;
+    CpuSet previous_;
+};
+
+// Current profile and calibration. g_calib starts profile-only (nothing
+// measured) unless a cached result is fresh, then follows Publish().
 static std::mutex g_cacheMutex;
-static bool g_cached = false;
+static std::condition_variable g_completeCv;
+static bool g_started = false;
+static bool g_complete = false;
 static DeviceProfile g_profile{};
 static CalibrationResult g_calib{};
 
-DWORD_PTR DeviceTuner::LowestBit(DWORD_PTR mask) { return mask & (~mask + 1); }
+static std::mutex g_listenerMutex;
+static CalibrationListener g_listener;
+
+// Busy fraction of all CPUs between successive Sample() calls (-1 on the
+// first call), for deciding when the machine is idle.
+class CpuLoadSampler {
+public:
+    double Sample() {
+        unsigned long long busy = 0, total = 0;
+        if (!Read(busy, total)) return -1.0;
+        const bool primed = total_ != 0;
+        const double frac = (primed && total > total_)
+            ? static_cast<double>(busy - busy_) / static_cast<double>(total - total_)
+            : -1.0;
+        busy_ = busy;
+        total_ = total;
+        return frac;
+    }
+
+private:
+    static bool Read(unsigned long long& busy, unsigned long long& total) {
+#ifdef _WIN32
+        FILETIME idle{}, kernel{}, user{};
+        if (!GetSystemTimes(&idle, &kernel, &user)) return false;
+        const auto u64 = [](const FILETIME& f) {
+            return (static_cast<unsigned long long>(f.dwHighDateTime) << 32) | f.dwLowDateTime;
+        };
+        total = u64(kernel) + u64(user); // kernel time includes idle time
+        busy = total - u64(idle);
+        return true;
+#else
+        std::ifstream f("/proc/stat");
+        std::string cpu;
+        unsigned long long v[8]{};
+        if (!(f >> cpu >> v[0] >> v[1] >> v[2] >> v[3] >> v[4] >> v[5] >> v[6] >> v[7]) || cpu != "cpu") return false;
+        total = 0;
+        for (unsigned long long x : v) total += x;
+        busy = total - v[3] - v[4]; // idle + iowait
+        return true;
+#endif
+    }
+
+    unsigned long long busy_ = 0;
+    unsigned long long total_ = 0;
+};
 
-DWORD_PTR DeviceTuner::HighestBit(DWORD_PTR mask) {
-    if (!mask) return 0;
-    DWORD_PTR hb = 1;
-    while (mask >>= 1) hb <<= 1;
-    return hb;
+// Makes `r` the current calibration and tells the listener. Results only
+// move forward: a partial result never replaces a complete one.
+static void Publish(const CalibrationResult& r) {
+    {
+        std::lock_guard<std::mutex> lock(g_cacheMutex);
+        if (g_complete && !r.measured) return;
+        g_calib = r;
+        if (r.measured) g_complete = true;
+    }
+    g_completeCv.notify_all();
+
+    CalibrationListener listener;
+    {
+        std::lock_guard<std::mutex> lock(g_listenerMutex);
+        listener = g_listener;
+    }
+    if (listener) listener(r);
 }
 
+// Runs calibration off the caller's thread: first the startup calibration
+// when there is no usable cached result, then one re-measurement once the
+// machine has been idle for a whole poll interval. Startup measurements are
+// taken under whatever load launched us (the login storm, under autostart).
+// Every result is stored for the next launch and published.
+class CalibrationWorker {
+public:
+    ~CalibrationWorker() { Stop(); }
+
+    void Stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cancel_ = true;
+        cv_.notify_all();
+        if (thread_.joinable()) thread_.join();
+    }
+
+    void Start(bool calibrateNow, bool revalidate) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (thread_.joinable() || stop_) return;
+        thread_ = std::thread(&CalibrationWorker::Run, this, calibrateNow, revalidate);
+    }
+
+private:
+    void Run(bool calibrateNow, bool revalidate) {
+        if (calibrateNow) Measure(false);
+        if (!revalidate) return;
+
+        CpuLoadSampler load;
+        load.Sample();
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                if (cv_.wait_for(lock, kIdlePollInterval, [this] { return stop_; })) return;
+            }
+
+            const double busy = load.Sample();
+            if (busy < 0.0 || busy > kIdleBusyFraction) continue;
+#ifdef _WIN32
+            LASTINPUTINFO li{ sizeof(li) };
+            if (GetLastInputInfo(&li) && GetTickCount() - li.dwTime < kIdleInputMs) continue;
+#endif
+            if (Measure(true)) return;
+        }
+    }
+
+    // False when on battery or cancelled: nothing was measured or stored.
+    bool Measure(bool idle) {
+        const DeviceProfile p = DeviceTuner::CollectProfile();
+        if (p.onBattery && idle) return false;
+
+        CachedCalibration c{};
+        c.fingerprint = CalibrationCache::Fingerprint(p);
+        c.idleValidated = idle;
+        c.result = DeviceTuner::Calibrate(p, Publish, &cancel_);
+        if (!c.result.measured) return false;
+        if (!p.onBattery) CalibrationCache::Save(c);
+        Publish(c.result);
+        return !p.onBattery;
+    }
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stop_ = false;
+    std::atomic<bool> cancel_{false}; // read by Calibrate() without the mutex
+    std::thread thread_;
+};
+
+static CalibrationWorker g_worker;
+
 void DeviceTuner::EnsureCached() {
     std::lock_guard<std::mutex> lock(g_cacheMutex);
-    if (g_cached) return;
+    if (g_started) return;
+    g_started = true;
     g_profile = CollectProfile();
-    g_calib = Calibrate(g_profile);
-    g_cached = true;
+
+    // A fresh result stored for this exact machine is used as is. Otherwise
+    // callers get profile-only configs until the worker publishes.
+    const std::string fingerprint = CalibrationCache::Fingerprint(g_profile);
+    CachedCalibration stored;
+    const bool loaded = CalibrationCache::Load(stored) && stored.fingerprint == fingerprint;
+    const long long age = loaded ? CalibrationCache::Now() - stored.result.measuredAt : 0;
+    const bool fresh = loaded && age >= 0 && age < kCacheMaxAgeSec;
+
+    if (fresh) {
+        g_calib = stored.result;
+        g_complete = true;
+    }
+
+    g_worker.Start(!fresh, !fresh || !stored.idleValidated || age >= kRevalidateAfterSec);
 }
 
-const DeviceProfile& DeviceTuner::Profile() {
+void DeviceTuner::Recalibrate() {
+    const DeviceProfile p = CollectProfile();
+    CalibrationResult r = Calibrate(p);
+    {
+        std::lock_guard<std::mutex> lock(g_cacheMutex);
+        g_started = true;
+        g_profile = p;
+    }
+    Publish(r);
+
+    if (p.onBattery) return;
+    CachedCalibration c{};
+    c.fingerprint = CalibrationCache::Fingerprint(p);
+    c.result = r;
+    CalibrationCache::Save(c);
+}
+
+void DeviceTuner::StopCalibration() {
+    g_worker.Stop();
+}
+
+void DeviceTuner::SetCalibrationListener(CalibrationListener listener) {
+    std::lock_guard<std::mutex> lock(g_listenerMutex);
+    g_listener = std::move(listener);
+}
+
+DeviceProfile DeviceTuner::Profile() {
     EnsureCached();
+    std::lock_guard<std::mutex> lock(g_cacheMutex);
     return g_profile;
 }
 
-const CalibrationResult& DeviceTuner::Calibration() {
+CalibrationResult DeviceTuner::Calibration() {
     EnsureCached();
+    std::lock_guard<std::mutex> lock(g_cacheMutex);
     return g_calib;
 }
 
-DeviceProfile DeviceTuner::CollectProfile() {
-    DeviceProfile p{};
+CalibrationResult DeviceTuner::WaitForCalibration() {
+    EnsureCached();
+    std::unique_lock<std::mutex> lock(g_cacheMutex);
+    g_completeCv.wait(lock, [] { return g_complete; });
+    return g_calib;
+}
 
+static void ReadPowerState(bool& hasBattery, bool& onBattery) {
+    hasBattery = false;
+    onBattery = false;
+#ifdef _WIN32
     SYSTEM_POWER_STATUS ps{};
     if (GetSystemPowerStatus(&ps)) {
-        p.hasBattery = (ps.BatteryFlag != 128);
-        p.onBattery = (ps.ACLineStatus == 0);
+        hasBattery = (ps.BatteryFlag != 128);
+        onBattery = (ps.ACLineStatus == 0);
+    }
+#else
+    // A battery is present if any supply reports type Battery; we are on it
+    // when no mains/USB supply is online (or, lacking those, it discharges).
+    bool anyLine = false, lineOnline = false, discharging = false;
+    if (DIR* d = opendir("/sys/class/power_supply")) {
+        while (dirent* e = readdir(d)) {
+            if (e->d_name[0] == '.') continue;
+            const std::string dir = std::string("/sys/class/power_supply/") + e->d_name;
+            const std::string type = ReadSysLine(dir + "/type");
+            if (type == "Battery") {
+                hasBattery = true;
+                if (ReadSysLine(dir + "/status") == "Discharging") discharging = true;
+            } else if (type == "Mains" || type == "USB") {
+                anyLine = true;
+                if (ReadSysLine(dir + "/online") == "1") lineOnline = true;
+            }
+        }
+        closedir(d);
     }
+    onBattery = hasBattery && (anyLine ? !lineOnline : discharging);
+#endif
+}
+
+bool DeviceTuner::OnBattery() {
+    bool hasBattery = false, onBattery = false;
+    ReadPowerState(hasBattery, onBattery);
+    return onBattery;
+}
+
+DeviceProfile DeviceTuner::CollectProfile() {
+    DeviceProfile p{};
+
+    ReadPowerState(p.hasBattery, p.onBattery);
 
+#ifdef _WIN32
     p.activeProcessorGroups = GetActiveProcessorGroupCount();
     p.logicalProcessors = GetActiveProcessorCount(ALL_PROCESSOR_GROUPS);
 
@@ -62,54 +392,291 @@ DeviceProfile DeviceTuner::CollectProfile() {
     ms.dwLength = sizeof(ms);
     if (GlobalMemoryStatusEx(&ms)) p.ramBytes = ms.ullTotalPhys;
 
-    p.cpuMHz = ReadCpuMHzFromRegistry();
+#else
+    p.activeProcessorGroups = 1;
+    p.logicalProcessors = static_cast<DWORD>(sysconf(_SC_NPROCESSORS_ONLN));
+    p.ramBytes = static_cast<ULONGLONG>(sysconf(_SC_PHYS_PAGES)) * static_cast<ULONGLONG>(sysconf(_SC_PAGESIZE));
+
+#endif
+
+    // Allowed CPUs include isolated ones, which sit outside the inherited
+    // affinity but can be targeted explicitly.
+    const CpuTopology topo = CpuTopology::Detect();
+    for (const LogicalCpu& c : topo.Cpus()) {
+        if (!c.online) continue;
+        p.systemAffinity.Set(c.index);
+        if (c.allowed) p.processAffinity.Set(c.index);
+    }
+
+    p.cpuMHz = ReadCpuMHz();
+    p.cpuModel = ReadCpuModel();
+    p.osBuild = ReadOsBuild();
     ReadTimerCaps(p.timerMinMs, p.timerMaxMs);
 
     if (p.timerMinMs == 0) p.timerMinMs = 1;
     if (p.timerMaxMs == 0) p.timerMaxMs = 15;
 
-    GetProcessAffinityMask(GetCurrentProcess(), &p.processAffinityMask, &p.systemAffinityMask);
-
     return p;
 }
 
-double DeviceTuner::MeasureSleepP95OvershootUs(int iterations) {
-    std::vector<double> overs;
-    overs.reserve(iterations);
+double DeviceTuner::SleepOvershootUs() {
+    double t0 = QpcUs();
+    SleepOneMs();
+    double t1 = QpcUs();
 
-    for (int i = 0; i < iterations; i++) {
-        double t0 = QpcUs();
-        Sleep(1);
-        double t1 = QpcUs();
+    double over = (t1 - t0) - 1000.0;
+    return over < 0 ? 0 : over;
+}
 
-        double dt = t1 - t0;
-        double over = dt - 1000.0;
-        if (over < 0) over = 0;
-        overs.push_back(over);
-    }
+static double SortedQuantile(const std::vector<double>& sorted, double q) {
+    size_t idx = static_cast<size_t>(std::ceil(q * sorted.size())) - 1;
+    if (idx >= sorted.size()) idx = sorted.size() - 1;
+    return sorted[idx];
+}
+
+OvershootStats DeviceTuner::Summarize(std::vector<double> overs) {
+    OvershootStats s{};
+    s.samples = static_cast<int>(overs.size());
+    if (overs.empty()) return s;
 
     std::sort(overs.begin(), overs.end());
-    size_t idx = static_cast<size_t>(std::ceil(0.95 * overs.size())) - 1;
-    if (idx >= overs.size()) idx = overs.size() - 1;
-    return overs[idx];
+    s.p50Us = SortedQuantile(overs, 0.50);
+    s.p95Us = SortedQuantile(overs, 0.95);
+    s.p99Us = SortedQuantile(overs, 0.99);
+    s.maxUs = overs.back();
+    return s;
+}
+
+// Distribution-free bounds on the p95 of `sorted`: the order statistics
+// around rank 0.95 n, widened by z binomial standard deviations. A rank
+// outside [1, n] has no sample to stand for it, so that side is unbounded
+// (too few samples for z) rather than clamped to the min or max.
+static void P95Bounds(const std::vector<double>& sorted, double z, double& lo, double& hi) {
+    const double n = static_cast<double>(sorted.size());
+    const double d = z * std::sqrt(n * 0.95 * 0.05);
+    const double rankLo = std::floor(0.95 * n - d);
+    const double rankHi = std::ceil(0.95 * n + d);
+    lo = rankLo >= 1.0 ? sorted[static_cast<size_t>(rankLo) - 1] : -std::numeric_limits<double>::infinity();
+    hi = rankHi <= n ? sorted[static_cast<size_t>(rankHi) - 1] : std::numeric_limits<double>::infinity();
 }
 
-double DeviceTuner::MeasureSleepP95OnMask(DWORD_PTR mask, int iterations) {
-    HANDLE th = GetCurrentThread();
-    DWORD_PTR prev = 0;
-    if (mask) {
-        prev = SetThreadAffinityMask(th, mask);
-        if (prev == 0) return MeasureSleepP95OvershootUs(iterations);
+// Gain = p95(before) - p95(after), tested against `threshold`. Each p95 gets
+// a two-sided bound at level L, so the difference holds with confidence
+// 2L - 1, and across `looks` such tests with 1 - looks * (2 - 2L)
+// (Bonferroni both times). The verdict is +1 when the lower bound clears the
+// threshold, -1 when the upper bound misses it, 0 while still open.
+GainEstimate DeviceTuner::EstimateGain(std::vector<double> before, std::vector<double> after, double threshold,
+                                       int looks) {
+    GainEstimate g{};
+    if (before.empty() || after.empty()) return g;
+
+    std::sort(before.begin(), before.end());
+    std::sort(after.begin(), after.end());
+    g.gainUs = SortedQuantile(before, 0.95) - SortedQuantile(after, 0.95);
+
+    const auto interval = [&](double z, double& lo, double& hi) {
+        double bLo, bHi, aLo, aHi;
+        P95Bounds(before, z, bLo, bHi);
+        P95Bounds(after, z, aLo, aHi);
+        lo = bLo - aHi;
+        hi = bHi - aLo;
+    };
+    const double tests = static_cast<double>(std::max(1, looks));
+    const auto jointConfidence = [tests](double z) {
+        return std::max(0.0, 1.0 - tests * 2.0 * std::erfc(z / std::sqrt(2.0)));
+    };
+
+    // Widest interval that still excludes the threshold -> confidence of
+    // the verdict; the interval reported is the one at kRequiredConfidence.
+    for (double z = 0.0; z <= 8.0; z += 0.05) {
+        double lo, hi;
+        interval(z, lo, hi);
+        if (lo < threshold && hi >= threshold) break;
+        g.confidence = jointConfidence(z);
+    }
+
+    double z = 0.0;
+    while (jointConfidence(z) < kRequiredConfidence) z += 0.01;
+    interval(z, g.lowUs, g.highUs);
+    if (g.lowUs >= threshold) g.verdict = 1;
+    else if (g.highUs < threshold) g.verdict = -1;
+    return g;
+}
+
+// Groups indices into `cpus` into waves that can run concurrently. SMT
+// siblings share one core's pipeline, so they never share a wave; each wave
+// holds at most one thread per physical core.
+static std::vector<std::vector<size_t>> PlanWaves(const CpuTopology& topo, const std::vector<uint32_t>& cpus) {
+    std::vector<std::vector<size_t>> plan;
+    std::vector<bool> planned(cpus.size(), false);
+    for (size_t done = 0; done < cpus.size();) {
+        std::vector<size_t> wave;
+        std::vector<int32_t> cores;
+        for (size_t i = 0; i < cpus.size() && wave.size() < kMaxParallelProbes; i++) {
+            if (planned[i]) continue;
+            const LogicalCpu* cpu = topo.Find(cpus[i]);
+            const int32_t core = cpu ? cpu->core : static_cast<int32_t>(cpus[i]);
+            if (std::find(cores.begin(), cores.end(), core) != cores.end()) continue;
+            cores.push_back(core);
+            wave.push_back(i);
+            planned[i] = true;
+            done++;
+        }
+        plan.push_back(std::move(wave));
+    }
+    return plan;
+}
+
+std::vector<NoiseStats> DeviceTuner::MeasureNoise(const CpuTopology& topo,
+                                                  const std::vector<uint32_t>& cpus,
+                                                  double windowMs,
+                                                  double thresholdUs,
+                                                  const std::atomic<bool>* cancel) {
+    std::vector<NoiseStats> out(cpus.size());
+    for (const std::vector<size_t>& wave : PlanWaves(topo, cpus)) {
+        if (cancel && cancel->load(std::memory_order_relaxed)) break;
+        std::vector<std::thread> pool;
+        pool.reserve(wave.size());
+        for (size_t i : wave) {
+            pool.emplace_back([&, i] {
+                const LogicalCpu* cpu = topo.Find(cpus[i]);
+                if (!cpu) return;
+                ScopedCpuPin pin(*cpu);
+                if (!pin.Pinned()) return;
+                out[i] = NoiseProbe::Measure(windowMs, thresholdUs);
+                out[i].cpu = static_cast<int>(cpus[i]);
+            });
+        }
+        for (std::thread& t : pool) t.join();
+    }
+    return out;
+}
+
+std::vector<CoreCalibration> DeviceTuner::ProbeCores(const CpuTopology& topo,
+                                                     const std::vector<uint32_t>& cpus,
+                                                     std::vector<double>* unpinned,
+                                                     int* waves,
+                                                     const std::atomic<bool>* cancel) {
+    struct Probe {
+        std::mutex m;
+        std::vector<double> overs;
+        bool failed = false;
+    };
+
+    std::vector<CoreCalibration> out(cpus.size());
+    std::vector<std::unique_ptr<Probe>> probes;
+    for (size_t i = 0; i < cpus.size(); i++) {
+        out[i].cpu = static_cast<int>(cpus[i]);
+        probes.push_back(std::make_unique<Probe>());
+    }
+
+    const std::vector<std::vector<size_t>> plan = PlanWaves(topo, cpus);
+
+    // The unpinned baseline samples for as long as any wave runs.
+    Probe base;
+    std::atomic<bool> baseStop{false};
+    std::thread baseThread([&] {
+        while (!baseStop.load(std::memory_order_relaxed)) {
+            const double over = SleepOvershootUs();
+            std::lock_guard<std::mutex> lock(base.m);
+            if (base.overs.size() < kMaxSamples) base.overs.push_back(over);
+        }
+    });
+
+    const auto snapshot = [](Probe& p) {
+        std::lock_guard<std::mutex> lock(p.m);
+        return p.overs;
+    };
+
+    const auto cancelled = [cancel] { return cancel && cancel->load(std::memory_order_relaxed); };
+
+    const int looks = static_cast<int>(cpus.size()) * kWaveLooks;
+    int ran = 0;
+    bool decided = false;
+    for (size_t w = 0; w < plan.size() && !decided && !cancelled(); w++) {
+        const std::vector<size_t>& wave = plan[w];
+        std::atomic<bool> stop{false};
+        for (size_t i : wave) out[i].probed = true;
+        ran++;
+
+        // Stagger the loops across one sleep period so wakeups interleave
+        // instead of landing on the same timer tick.
+        std::vector<std::thread> pool;
+        pool.reserve(wave.size());
+        for (size_t t = 0; t < wave.size(); t++) {
+            Probe* probe = probes[wave[t]].get();
+            const LogicalCpu* cpu = topo.Find(cpus[wave[t]]);
+            const auto offset = std::chrono::microseconds(static_cast<long long>(1000 * (t + 1) / (wave.size() + 1)));
+            pool.emplace_back([probe, cpu, offset, &stop] {
+                ScopedCpuPin pin(*cpu);
+                if (!pin.Pinned()) {
+                    std::lock_guard<std::mutex> lock(probe->m);
+                    probe->failed = true;
+                    return;
+                }
+                std::this_thread::sleep_for(offset);
+                while (!stop.load(std::memory_order_relaxed)) {
+                    const double over = SleepOvershootUs();
+                    std::lock_guard<std::mutex> lock(probe->m);
+                    if (probe->overs.size() >= kMaxSamples) break;
+                    probe->overs.push_back(over);
+                }
+            });
+        }
+
+        // Sequential test: stop the wave once every core's gain over the
+        // baseline is settled either way, or one core clearly clears the
+        // threshold (then later, lower-ranked waves are skipped too).
+        const double started = QpcUs();
+        for (;;) {
+            std::this_thread::sleep_for(kCheckInterval);
+            const std::vector<double> baseline = snapshot(base);
+            bool allSettled = baseline.size() >= kMinSamples;
+            bool allFull = true;
+            for (size_t i : wave) {
+                std::vector<double> overs;
+                bool failed;
+                {
+                    std::lock_guard<std::mutex> lock(probes[i]->m);
+                    overs = probes[i]->overs;
+                    failed = probes[i]->failed;
+                }
+                if (failed) continue;
+                if (overs.size() < kMaxSamples) allFull = false;
+                if (overs.size() < kMinSamples || baseline.size() < kMinSamples) {
+                    allSettled = false;
+                    continue;
+                }
+                const int verdict = EstimateGain(baseline, overs, kAffinityGainUs, looks).verdict;
+                if (verdict > 0) decided = true;
+                if (verdict == 0) allSettled = false;
+            }
+            if (decided || allSettled || allFull || cancelled()) break;
+            if ((QpcUs() - started) / 1000.0 >= kWaveBudgetMs) break;
+        }
+
+        stop = true;
+        for (std::thread& t : pool) t.join();
     }
 
-    double p95 = MeasureSleepP95OvershootUs(iterations);
+    // Without candidates the baseline still needs its samples.
+    while (cpus.empty() && !cancelled() && snapshot(base).size() < kMinSamples * 2) {
+        std::this_thread::sleep_for(kCheckInterval);
+    }
+    baseStop = true;
+    baseThread.join();
 
-    if (mask && prev) SetThreadAffinityMask(th, prev);
-    return p95;
+    for (size_t i = 0; i < cpus.size(); i++) out[i].samples = std::move(probes[i]->overs);
+    if (unpinned) *unpinned = std::move(base.overs);
+    if (waves) *waves = ran;
+    return out;
 }
 
-CalibrationResult DeviceTuner::Calibrate(const DeviceProfile& p) {
+CalibrationResult DeviceTuner::Calibrate(const DeviceProfile& p, const CalibrationListener& progress,
+                                         const std::atomic<bool>* cancel) {
+    const auto cancelled = [cancel] { return cancel && cancel->load(std::memory_order_relaxed); };
     CalibrationResult r{};
+    r.measuredAt = CalibrationCache::Now();
 
     if (p.onBattery) {
         r.measured = true;
@@ -118,45 +685,139 @@ CalibrationResult DeviceTuner::Calibrate(const DeviceProfile& p) {
         return r;
     }
 
-    const int iters = 48;
+    const double started = QpcUs();
 
-    r.sleepP95OvershootUs_DefaultCore = MeasureSleepP95OvershootUs(iters);
-    r.sleepP95OvershootUs_NoBoost = r.sleepP95OvershootUs_DefaultCore;
+    // Per-core probes and the unpinned baseline run concurrently, each on
+    // its own thread; the boost pass changes process-wide timer state, so it
+    // runs on its own afterwards.
+    const CpuTopology topo = CpuTopology::Detect();
+    std::vector<uint32_t> candidates;
+    if (topo.AllowedCount() >= 2) candidates = topo.Candidates(kMaxAffinityCandidates);
 
-    UINT reqMs = std::max<UINT>(1, p.timerMinMs);
+    std::vector<double> unpinned;
+    r.cores = ProbeCores(topo, candidates, &unpinned, &r.probeWaves, cancel);
+    if (cancelled()) return r;
+    r.sleepP95OvershootUs_DefaultCore = Summarize(unpinned).p95Us;
 
-    timeBeginPeriod(reqMs);
-    r.sleepP95OvershootUs_Boost = MeasureSleepP95OvershootUs(iters);
-    timeEndPeriod(reqMs);
+    const CoreCalibration* best = nullptr;
+    for (CoreCalibration& core : r.cores) {
+        core.overshoot = Summarize(core.samples);
+        if (core.overshoot.samples == 0) continue; // could not pin
+        r.candidatesProbed++;
 
-    const double improveTimer = r.sleepP95OvershootUs_NoBoost - r.sleepP95OvershootUs_Boost;
-    r.timerBoostHelps = (improveTimer >= 500.0);
+        // Candidates arrive best-ranked first, so ties keep the better core.
+        if (!best || core.overshoot.p95Us < best->overshoot.p95Us) best = &core;
+    }
 
-    DWORD_PTR avail = p.processAffinityMask ? p.processAffinityMask : p.systemAffinityMask;
-    DWORD_PTR low = LowestBit(avail);
-    DWORD_PTR high = HighestBit(avail);
+    // Sleep overshoot mostly reflects timer granularity, which is often the
+    // same on every core. Among cores within kNoiseTieUs of the best p95,
+    // the one losing the least time to interrupts and preemption wins.
+    if (best) {
+        std::vector<uint32_t> tied;
+        std::vector<CoreCalibration*> tiedCores;
+        for (CoreCalibration& core : r.cores) {
+            if (core.overshoot.samples == 0) continue;
+            if (core.overshoot.p95Us > best->overshoot.p95Us + kNoiseTieUs) continue;
+            tied.push_back(static_cast<uint32_t>(core.cpu));
+            tiedCores.push_back(&core);
+        }
 
-    if (low && high && low != high) {
-        double p95Low = MeasureSleepP95OnMask(low, iters);
-        double p95High = MeasureSleepP95OnMask(high, iters);
+        if (tied.size() >= 2) {
+            const std::vector<NoiseStats> noise = MeasureNoise(topo, tied, kNoiseWindowMs,
+                                                               NoiseProbe::kDefaultThresholdUs, cancel);
+            const CoreCalibration* quietest = nullptr;
+            for (size_t i = 0; i < tied.size(); i++) {
+                tiedCores[i]->noise = noise[i];
+                if (noise[i].cpu < 0) continue;
+                if (!quietest || noise[i].stolenUs < quietest->noise.stolenUs) quietest = tiedCores[i];
+            }
+            if (quietest) {
+                best = quietest;
+                r.noiseCompared = static_cast<int>(tied.size());
+            }
+        }
+    }
+
+    if (best) {
+        r.bestCpu = best->cpu;
+        r.bestAffinity = CpuSet::Of(static_cast<uint32_t>(best->cpu));
+        r.sleepP95OvershootUs_BestCore = best->overshoot.p95Us;
 
-        if (p95Low <= p95High) {
-            r.bestAffinityMask = low;
-            r.sleepP95OvershootUs_BestCore = p95Low;
-        } else {
-            r.bestAffinityMask = high;
-            r.sleepP95OvershootUs_BestCore = p95High;
+        r.affinity = EstimateGain(unpinned, best->samples, kAffinityGainUs,
+                                  static_cast<int>(candidates.size()) * kWaveLooks);
+        r.affinityHelps = (r.affinity.verdict > 0);
+
+        char measured[160];
+        std::snprintf(measured, sizeof(measured),
+            "; p95 overshoot %.0f us vs %.0f us unpinned (gain %.0f..%.0f us, %.0f%% confident), best of %d probed",
+            r.sleepP95OvershootUs_BestCore, r.sleepP95OvershootUs_DefaultCore,
+            r.affinity.lowUs, r.affinity.highUs, r.affinity.confidence * 100.0, r.candidatesProbed);
+        r.affinityReason = topo.Describe(static_cast<uint32_t>(best->cpu)) + measured;
+        if (r.noiseCompared > 0) {
+            char quiet[128];
+            std::snprintf(quiet, sizeof(quiet), "; quietest of %d tied: %.0f gaps/s, %.3f%% stolen",
+                r.noiseCompared, best->noise.gapsPerSec, best->noise.stolenFraction * 100.0);
+            r.affinityReason += quiet;
         }
+    }
+
+    if (cancelled()) return r;
+
+    // Affinity is settled; publish it while the timer boost is measured.
+    if (progress) {
+        r.calibrationMs = (QpcUs() - started) / 1000.0;
+        progress(r);
+    }
+
+    // Boost on/off alternate in short blocks, so drift in background load
+    // hits both sides alike, until the gain is settled or the budget ends.
+    std::vector<double> off, on;
+    GainEstimate boost{};
+    const double boostStarted = QpcUs();
+    while (off.size() < kMaxSamples && (QpcUs() - boostStarted) / 1000.0 < kBoostBudgetMs) {
+        if (cancelled()) return r;
+        for (size_t i = 0; i < kBoostBlock; i++) off.push_back(SleepOvershootUs());
+
+#ifdef _WIN32
+        UINT reqMs = std::max<UINT>(1, p.timerMinMs);
+        timeBeginPeriod(reqMs);
+        for (size_t i = 0; i < kBoostBlock; i++) on.push_back(SleepOvershootUs());
+        timeEndPeriod(reqMs);
+#else
+        // Linux timer boost is the minimal timer slack InputThread applies.
+        const int prevSlack = prctl(PR_GET_TIMERSLACK, 0, 0, 0, 0);
+        prctl(PR_SET_TIMERSLACK, 1UL, 0, 0, 0);
+        for (size_t i = 0; i < kBoostBlock; i++) on.push_back(SleepOvershootUs());
+        if (prevSlack > 0) prctl(PR_SET_TIMERSLACK, static_cast<unsigned long>(prevSlack), 0, 0, 0);
+#endif
 
-        const double improveAff = r.sleepP95OvershootUs_DefaultCore - r.sleepP95OvershootUs_BestCore;
-        r.affinityHelps = (improveAff >= 300.0);
+        if (off.size() < kMinSamples) continue;
+        boost = EstimateGain(off, on, kTimerGainUs, kBoostLooks);
+        if (boost.verdict != 0) break;
     }
 
+    r.sleepP95OvershootUs_NoBoost = Summarize(off).p95Us;
+    r.sleepP95OvershootUs_Boost = Summarize(on).p95Us;
+    r.boostSamples = static_cast<int>(off.size() + on.size());
+    r.timerBoost = boost;
+    r.timerBoostHelps = (boost.verdict > 0);
+
+    r.calibrationMs = (QpcUs() - started) / 1000.0;
     r.measured = true;
     return r;
 }
 
-InputThread::Config DeviceTuner::ComputeConfig(SettingsDialog::Mode mode,
+TuningMode DeviceTuner::RecommendedMode(const DeviceProfile& p) {
+    const ULONGLONG ramGB = p.ramBytes / (1024ull * 1024ull * 1024ull);
+    const bool strongCPU = (p.logicalProcessors >= 8) || (p.cpuMHz >= 3200);
+
+    if (p.onBattery) return TuningMode::Light;
+    if (strongCPU && ramGB >= 16) return TuningMode::Max;
+    if (p.logicalProcessors >= 4 && ramGB >= 8) return TuningMode::Medium;
+    return TuningMode::Light;
+}
+
+InputThread::Config DeviceTuner::ComputeConfig(TuningMode mode,
                                               const DeviceProfile& p,
                                               const CalibrationResult& c) {
     InputThread::Config cfg{};
@@ -177,9 +838,11 @@ InputThread::Config DeviceTuner::ComputeConfig(SettingsDialog::Mode mode,
     }
 
     switch (mode) {
-    case SettingsDialog::Mode::Light:
+    case TuningMode::Light:
         cfg.enableThreadPriority = true;
         cfg.threadPriority = THREAD_PRIORITY_HIGHEST;
+        cfg.schedPolicy = InputThread::SchedPolicy::RoundRobin;
+        cfg.schedPriority = 10;
         cfg.enableProcessPriority = false;
 
         cfg.enableTimerBoost = false;
@@ -188,44 +851,74 @@ InputThread::Config DeviceTuner::ComputeConfig(SettingsDialog::Mode mode,
         cfg.enableAffinity = false;
         break;
 
-    case SettingsDialog::Mode::Medium:
+    case TuningMode::Medium:
         cfg.enableThreadPriority = true;
         cfg.threadPriority = THREAD_PRIORITY_HIGHEST;
+        cfg.schedPolicy = InputThread::SchedPolicy::Fifo;
+        cfg.schedPriority = 50;
         cfg.enableProcessPriority = false;
 
-        cfg.enableTimerBoost = (c.measured && c.timerBoostHelps);
+        cfg.enableTimerBoost = c.timerBoostHelps;
         cfg.timerResolutionMs = safeTimerMs;
 
-        cfg.enableAffinity = (c.measured && c.affinityHelps && c.bestAffinityMask != 0);
-        cfg.affinityMask = c.bestAffinityMask;
+        cfg.enableAffinity = (c.affinityHelps && !c.bestAffinity.Empty());
+        cfg.affinity = c.bestAffinity;
         break;
 
-    case SettingsDialog::Mode::Max:
+    case TuningMode::Max:
         cfg.enableThreadPriority = true;
         cfg.threadPriority = THREAD_PRIORITY_TIME_CRITICAL;
+        cfg.schedPolicy = InputThread::SchedPolicy::Fifo;
+        cfg.schedPriority = 80;
 
-        cfg.enableTimerBoost = (c.measured && c.timerBoostHelps);
+        cfg.enableTimerBoost = c.timerBoostHelps;
         cfg.timerResolutionMs = safeTimerMs;
 
-        cfg.enableAffinity = (c.measured && c.affinityHelps && c.bestAffinityMask != 0);
-        cfg.affinityMask = c.bestAffinityMask;
+        cfg.enableAffinity = (c.affinityHelps && !c.bestAffinity.Empty());
+        cfg.affinity = c.bestAffinity;
 
         cfg.enableProcessPriority = (strongCPU && ramGB >= 8 && cfg.enableTimerBoost);
         cfg.processPriority = HIGH_PRIORITY_CLASS;
 
-        if (p.logicalProcessors <= 4) cfg.threadPriority = THREAD_PRIORITY_HIGHEST;
+        if (p.logicalProcessors <= 4) {
+            cfg.threadPriority = THREAD_PRIORITY_HIGHEST;
+            cfg.schedPriority = 50;
+        }
         break;
+
+    case TuningMode::Recommend:
+        return ComputeConfig(RecommendedMode(p), p, c);
     }
 
     cfg.timerResolutionMs = std::max<UINT>(cfg.timerResolutionMs, safeTimerMs);
+
+    // What the input thread's sleeps will overshoot by, as calibrated.
+    cfg.waitOvershootUs = cfg.enableTimerBoost ? c.sleepP95OvershootUs_Boost : c.sleepP95OvershootUs_NoBoost;
+    if (cfg.waitOvershootUs <= 0.0) cfg.waitOvershootUs = c.sleepP95OvershootUs_DefaultCore;
     return cfg;
 }
 
-InputThread::Config DeviceTuner::ComputeConfigCached(SettingsDialog::Mode mode) {
+InputThread::Config DeviceTuner::ComputeConfigCached(TuningMode mode) {
     EnsureCached();
+    std::lock_guard<std::mutex> lock(g_cacheMutex);
     return ComputeConfig(mode, g_profile, g_calib);
 }
 
+bool DeviceTuner::SameCalibratedSettings(const InputThread::Config& a, const InputThread::Config& b) {
+    if (a.enableTimerBoost != b.enableTimerBoost || a.enableAffinity != b.enableAffinity) return false;
+    if (a.enableProcessPriority != b.enableProcessPriority) return false;
+    if (a.enableTimerBoost && a.timerResolutionMs != b.timerResolutionMs) return false;
+    return !a.enableAffinity || a.affinity == b.affinity;
+}
+
+InputThread::Config DeviceTuner::ApplyPartialCalibration(const InputThread::Config& current,
+                                                         const InputThread::Config& refined) {
+    InputThread::Config cfg = current;
+    cfg.enableAffinity = refined.enableAffinity;
+    cfg.affinity = refined.affinity;
+    return cfg;
+}
+
 InputThread::Config DeviceTuner::NormalizeForCurrentState(const InputThread::Config& inCfg) {
     DeviceProfile p = CollectProfile();
     InputThread::Config cfg = inCfg;
@@ -234,7 +927,9 @@ InputThread::Config DeviceTuner::NormalizeForCurrentState(const InputThread::Con
         cfg.enableTimerBoost = false;
         cfg.enableAffinity = false;
         cfg.enableProcessPriority = false;
+        cfg.enableBusyPoll = false;
         if (cfg.threadPriority == THREAD_PRIORITY_TIME_CRITICAL) cfg.threadPriority = THREAD_PRIORITY_HIGHEST;
+        if (cfg.schedPriority > 50) cfg.schedPriority = 50;
     }
 
     // Never below timer min if boost enabled
@@ -243,20 +938,17 @@ InputThread::Config DeviceTuner::NormalizeForCurrentState(const InputThread::Con
     }
 
     // Affinity must be within current process affinity
-    if (cfg.enableAffinity && cfg.affinityMask) {
-        DWORD_PTR procMask = 0, sysMask = 0;
-        GetProcessAffinityMask(GetCurrentProcess(), &procMask, &sysMask);
-        DWORD_PTR allowed = procMask ? procMask : sysMask;
-        if ((cfg.affinityMask & allowed) == 0) {
-            cfg.enableAffinity = false;
-            cfg.affinityMask = 0;
-        }
+    if (cfg.enableAffinity && !cfg.affinity.Empty()) {
+        const CpuSet& allowed = p.processAffinity.Empty() ? p.systemAffinity : p.processAffinity;
+        cfg.affinity &= allowed;
+        if (cfg.affinity.Empty()) cfg.enableAffinity = false;
     }
 
     return cfg;
 }
 
-DWORD DeviceTuner::ReadCpuMHzFromRegistry() {
+DWORD DeviceTuner::ReadCpuMHz() {
+#ifdef _WIN32
     HKEY hKey{};
     DWORD mhz = 0;
     DWORD sz = sizeof(mhz);
@@ -270,9 +962,23 @@ DWORD DeviceTuner::ReadCpuMHzFromRegistry() {
     }
 
     return mhz;
+#else
+    const std::string khz = ReadSysLine("/sys/devices/system/cpu/cpu0/cpufreq/cpuinfo_max_freq");
+    if (!khz.empty()) return static_cast<DWORD>(std::strtoul(khz.c_str(), nullptr, 10) / 1000);
+
+    std::ifstream f("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(f, line)) {
+        if (line.compare(0, 7, "cpu MHz") != 0) continue;
+        const size_t colon = line.find(':');
+        if (colon != std::string::npos) return static_cast<DWORD>(std::atof(line.c_str() + colon + 1));
+    }
+    return 0;
+#endif
 }
 
 void DeviceTuner::ReadTimerCaps(UINT& minMs, UINT& maxMs) {
+#ifdef _WIN32
     TIMECAPS tc{};
     if (timeGetDevCaps(&tc, sizeof(tc)) == TIMERR_NOERROR) {
         minMs = tc.wPeriodMin;
@@ -281,4 +987,75 @@ void DeviceTuner::ReadTimerCaps(UINT& minMs, UINT& maxMs) {
         minMs = 1;
         maxMs = 15;
     }
+#else
+    // High-resolution timers: there is no global period to raise.
+    minMs = 1;
+    maxMs = 1;
+#endif
+}
+
+std::string DeviceTuner::ReadCpuModel() {
+#ifdef _WIN32
+    HKEY hKey{};
+    wchar_t name[256]{};
+    DWORD sz = sizeof(name) - sizeof(wchar_t);
+
+    if (RegOpenKeyExW(HKEY_LOCAL_MACHINE,
+        L"HARDWARE\\DESCRIPTION\\System\\CentralProcessor\\0",
+        0, KEY_READ, &hKey) == ERROR_SUCCESS) {
+
+        RegQueryValueExW(hKey, L"ProcessorNameString", nullptr, nullptr, reinterpret_cast<LPBYTE>(name), &sz);
+        RegCloseKey(hKey);
+    }
+
+    std::string model;
+    for (const wchar_t* c = name; *c; c++) model.push_back(static_cast<char>(*c));
+#else
+    // x86 reports "model name"; arm64 only implementer/part ids.
+    std::ifstream f("/proc/cpuinfo");
+    std::string line, model, implementer, part;
+    while (std::getline(f, line)) {
+        const size_t colon = line.find(':');
+        if (colon == std::string::npos) continue;
+        const size_t start = line.find_first_not_of(" \t", colon + 1);
+        const std::string value = start == std::string::npos ? std::string() : line.substr(start);
+        if (line.compare(0, 10, "model name") == 0) {
+            model = value;
+            break;
+        }
+        if (line.compare(0, 15, "CPU implementer") == 0 && implementer.empty()) implementer = value;
+        if (line.compare(0, 8, "CPU part") == 0 && part.empty()) part = value;
+    }
+    if (model.empty() && !implementer.empty()) model = implementer + "/" + part;
+#endif
+
+    while (!model.empty() && model.back() == ' ') model.pop_back();
+    return model;
+}
+
+std::string DeviceTuner::ReadOsBuild() {
+#ifdef _WIN32
+    HKEY hKey{};
+    wchar_t build[32]{};
+    DWORD sz = sizeof(build) - sizeof(wchar_t);
+    DWORD ubr = 0;
+    DWORD ubrSz = sizeof(ubr);
+
+    if (RegOpenKeyExW(HKEY_LOCAL_MACHINE,
+        L"SOFTWARE\\Microsoft\\Windows NT\\CurrentVersion",
+        0, KEY_READ, &hKey) == ERROR_SUCCESS) {
+
+        RegQueryValueExW(hKey, L"CurrentBuild", nullptr, nullptr, reinterpret_cast<LPBYTE>(build), &sz);
+        RegQueryValueExW(hKey, L"UBR", nullptr, nullptr, reinterpret_cast<LPBYTE>(&ubr), &ubrSz);
+        RegCloseKey(hKey);
+    }
+
+    std::string out = "Windows ";
+    for (const wchar_t* c = build; *c; c++) out.push_back(static_cast<char>(*c));
+    return out + "." + std::to_string(ubr);
+#else
+    utsname u{};
+    if (uname(&u) != 0) return std::string();
+    return std::string(u.sysname) + " " + u.release + " " + u.version;
+#endif
 }
@@ -0,0 +1,212 @@
+#ifdef __linux__
+#include "../include/EvdevInputSource.h"
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <linux/input.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+
+// epoll user data for the wake eventfd; devices use their index.
+static constexpr uint64_t kWakeTag = ~0ull;
+static constexpr int kMaxReady = 16;
+
+std::unique_ptr<InputSource> CreateDefaultInputSource() {
+    return std::make_unique<EvdevInputSource>();
+}
+
+EvdevInputSource::EvdevInputSource() : scan_(true) {
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+}
+
+EvdevInputSource::EvdevInputSource(std::vector<std::string> paths) : paths_(std::move(paths)) {
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+}
+
+EvdevInputSource::EvdevInputSource(const std::vector<int>& fds) : external_fds_(fds) {
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+}
+
+EvdevInputSource::~EvdevInputSource() {
+    Close();
+    if (wake_fd_ >= 0) close(wake_fd_);
+}
+
+bool EvdevInputSource::AddDevice(int fd, bool owned, const std::string& path) {
+    Device d{};
+    d.fd = fd;
+    d.owned = owned;
+    d.path = path;
+    devices_.push_back(d);
+
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.u64 = devices_.size() - 1;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) != 0) {
+        devices_.pop_back();
+        if (owned) close(fd);
+        return false;
+    }
+    return true;
+}
+
+void EvdevInputSource::UseMonotonicStamps(int fd) {
+    int clk = CLOCK_MONOTONIC;
+    ioctl(fd, EVIOCSCLOCKID, &clk);
+}
+
+std::vector<std::string> EvdevInputSource::ScanDevices() {
+    std::vector<std::string> paths;
+    if (DIR* dir = opendir("/dev/input")) {
+        while (dirent* e = readdir(dir)) {
+            if (std::strncmp(e->d_name, "event", 5) == 0) paths.push_back(std::string("/dev/input/") + e->d_name);
+        }
+        closedir(dir);
+    }
+    std::sort(paths.begin(), paths.end());
+    return paths;
+}
+
+void EvdevInputSource::DropDevice(size_t index) {
+    Device& d = devices_[index];
+    if (d.fd < 0) return;
+
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, d.fd, nullptr);
+    if (d.owned) close(d.fd);
+    d.fd = -1;
+}
+
+bool EvdevInputSource::Open() {
+    Close();
+
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd_ < 0 || wake_fd_ < 0) return false;
+
+    // Clear a wake left over from a previous run.
+    uint64_t drained = 0;
+    while (read(wake_fd_, &drained, sizeof(drained)) > 0) {}
+
+    epoll_event wev{};
+    wev.events = EPOLLIN;
+    wev.data.u64 = kWakeTag;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &wev) != 0) return false;
+
+    std::vector<std::string> paths = paths_;
+    if (scan_) {
+        const std::vector<std::string> found = ScanDevices();
+        paths.insert(paths.end(), found.begin(), found.end());
+    }
+
+    for (const std::string& path : paths) {
+        const int fd = open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+        if (fd < 0) continue;
+
+        UseMonotonicStamps(fd);
+        AddDevice(fd, true, path);
+    }
+
+    for (int fd : external_fds_) {
+        const int flags = fcntl(fd, F_GETFL);
+        if (flags >= 0) fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+        UseMonotonicStamps(fd);
+        AddDevice(fd, false, std::string());
+    }
+
+    return !devices_.empty();
+}
+
+void EvdevInputSource::Close() {
+    for (size_t i = 0; i < devices_.size(); i++) DropDevice(i);
+    devices_.clear();
+    ready_.clear();
+    ready_pos_ = 0;
+
+    if (epoll_fd_ >= 0) {
+        close(epoll_fd_);
+        epoll_fd_ = -1;
+    }
+}
+
+InputSource::WaitResult EvdevInputSource::Wait(int timeoutMs) {
+    epoll_event evs[kMaxReady];
+
+    for (;;) {
+        const int n = epoll_wait(epoll_fd_, evs, kMaxReady, timeoutMs);
+        syscalls_++;
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return WaitResult::Exit;
+        }
+        if (n == 0) return WaitResult::Timeout;
+
+        ready_.clear();
+        ready_pos_ = 0;
+        for (int i = 0; i < n; i++) {
+            if (evs[i].data.u64 == kWakeTag) return WaitResult::Exit;
+            ready_.push_back(static_cast<size_t>(evs[i].data.u64));
+        }
+        return WaitResult::Ready;
+    }
+}
+
+int EvdevInputSource::Read(InputEvent* out, int max) {
+    input_event raw[64];
+    int total = 0;
+
+    while (total < max && ready_pos_ < ready_.size()) {
+        const size_t idx = ready_[ready_pos_];
+        Device& d = devices_[idx];
+        if (d.fd < 0) {
+            ready_pos_++;
+            continue;
+        }
+
+        const int want = std::min<int>(max - total, static_cast<int>(sizeof(raw) / sizeof(raw[0])));
+        const ssize_t got = read(d.fd, raw, static_cast<size_t>(want) * sizeof(input_event));
+        syscalls_++;
+
+        if (got < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN) DropDevice(idx); // ENODEV: unplugged
+            ready_pos_++;
+            continue;
+        }
+        if (got == 0) {
+            DropDevice(idx);
+            ready_pos_++;
+            continue;
+        }
+
+        const int count = static_cast<int>(static_cast<size_t>(got) / sizeof(input_event));
+        for (int i = 0; i < count; i++) {
+            InputEvent& ev = out[total + i];
+            ev.timestampNs = static_cast<uint64_t>(raw[i].input_event_sec) * 1000000000ull +
+                static_cast<uint64_t>(raw[i].input_event_usec) * 1000ull;
+            ev.device = static_cast<uint64_t>(d.fd);
+            ev.type = raw[i].type;
+            ev.code = raw[i].code;
+            ev.value = raw[i].value;
+        }
+        total += count;
+
+        // A short read means this fd is drained.
+        if (count < want) ready_pos_++;
+    }
+
+    return total;
+}
+
+void EvdevInputSource::Wake() {
+    const uint64_t one = 1;
+    if (wake_fd_ >= 0) {
+        ssize_t r = write(wake_fd_, &one, sizeof(one));
+        (void)r;
+    }
+}
+
+#endif // __linux__
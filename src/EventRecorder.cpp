@@ -0,0 +1,322 @@
+#include "../include/EventRecorder.h"
+#include "../include/LatencyMeasurer.h"
+#include <chrono>
+#include <cstring>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// File growth step; blocks are appended into the mapped tail.
+static constexpr size_t kGrowBytes = size_t(16) << 20;
+
+// Column resolutions written to the header.
+static constexpr uint32_t kArrivalUnitNs = 1000;
+static constexpr uint32_t kLatencyUnitNs = 10;
+
+// Writer cadence: drain the ring every 20 ms, close a partial block after 1 s.
+static constexpr auto kDrainInterval = std::chrono::milliseconds(20);
+static constexpr auto kFlushInterval = std::chrono::seconds(1);
+
+static const char kMagic[8] = { 'I', 'L', 'O', 'R', 'E', 'C', '0', '1' };
+
+void EventRecorder::RunColumn::Add(uint64_t v) {
+    if (run != 0 && v == value) {
+        run++;
+        return;
+    }
+    Finish();
+    value = v;
+    run = 1;
+}
+
+void EventRecorder::RunColumn::Finish() {
+    if (run == 0) return;
+    RecordingVarint::Put(bytes, value);
+    RecordingVarint::Put(bytes, run);
+    run = 0;
+}
+
+void EventRecorder::RunColumn::Clear() {
+    bytes.clear();
+    value = 0;
+    run = 0;
+}
+
+EventRecorder::EventRecorder() {
+    frequency_ = LatencyMeasurer::TickFrequency();
+}
+
+EventRecorder::~EventRecorder() {
+    Stop();
+}
+
+bool EventRecorder::Start(const std::string& path) {
+    Stop();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+        CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    file_ = file;
+#else
+    fd_ = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_ < 0) return false;
+#endif
+
+    if (!MapFile(kGrowBytes)) {
+        CloseFile();
+        return false;
+    }
+
+    const int64_t now = LatencyMeasurer::ReadTicks();
+    start_ns_ = frequency_ == 1000000000ll
+        ? static_cast<uint64_t>(now)
+        : static_cast<uint64_t>(static_cast<double>(now) * 1e9 / static_cast<double>(frequency_));
+
+    RecordingHeader h{};
+    std::memcpy(h.magic, kMagic, sizeof(kMagic));
+    h.version = kRecordingVersion;
+    h.headerSize = sizeof(RecordingHeader);
+    h.startNs = start_ns_;
+    h.arrivalUnitNs = kArrivalUnitNs;
+    h.latencyUnitNs = kLatencyUnitNs;
+    h.bytesUsed = sizeof(RecordingHeader);
+    std::memcpy(map_, &h, sizeof(h));
+
+    // The ring and block buffers (~3 MB) are allocated by the first recording
+    // and kept; Append() cannot reach them before active_ is set below.
+    if (ring_.empty()) {
+        ring_.resize(kCapacity);
+
+        // Worst case is a 10-byte varint per record per column.
+        arrival_col_.reserve(kBlockRecords * 10);
+        latency_col_.reserve(kBlockRecords * 10);
+        device_col_.bytes.reserve(kBlockRecords * 20);
+        type_col_.bytes.reserve(kBlockRecords * 20);
+        batch_col_.bytes.reserve(kBlockRecords * 20);
+    }
+
+    path_ = path;
+    last_arrival_units_ = 0;
+    block_count_ = 0;
+    arrival_col_.clear();
+    latency_col_.clear();
+    device_col_.Clear();
+    type_col_.Clear();
+    batch_col_.Clear();
+
+    // Skip whatever an earlier session left unread.
+    tail_.store(head_.load(std::memory_order_acquire), std::memory_order_release);
+    dropped_ = 0;
+    recorded_ = 0;
+    stop_requested_ = false;
+
+    writer_ = std::thread(&EventRecorder::WriterProc, this);
+    active_.store(true, std::memory_order_release);
+    return true;
+}
+
+void EventRecorder::Stop() {
+    if (!writer_.joinable()) return;
+
+    active_.store(false, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(writer_mutex_);
+        stop_requested_ = true;
+    }
+    writer_cv_.notify_all();
+    writer_.join();
+}
+
+void EventRecorder::WriterProc() {
+    using Clock = std::chrono::steady_clock;
+    auto lastFlush = Clock::now();
+
+    for (;;) {
+        bool stop = false;
+        {
+            std::unique_lock<std::mutex> lock(writer_mutex_);
+            writer_cv_.wait_for(lock, kDrainInterval, [this] { return stop_requested_; });
+            stop = stop_requested_;
+        }
+
+        Drain();
+
+        const auto now = Clock::now();
+        if (block_count_ > 0 && (stop || now - lastFlush >= kFlushInterval)) {
+            WriteBlock();
+            lastFlush = now;
+        }
+
+        if (stop) break;
+    }
+
+    if (map_) Header()->dropped = dropped_.load(std::memory_order_relaxed);
+    CloseFile();
+}
+
+void EventRecorder::Drain() {
+    const uint64_t head = head_.load(std::memory_order_acquire);
+    uint64_t tail = tail_.load(std::memory_order_relaxed);
+
+    while (tail < head) {
+        Encode(ring_[tail & kMask]);
+        tail++;
+
+        if (block_count_ >= kBlockRecords) {
+            tail_.store(tail, std::memory_order_release);
+            WriteBlock();
+        }
+    }
+    tail_.store(tail, std::memory_order_release);
+}
+
+void EventRecorder::Encode(const Pending& p) {
+    const auto toNs = [this](int64_t ticks) -> uint64_t {
+        if (ticks <= 0) return 0;
+        if (frequency_ == 1000000000ll) return static_cast<uint64_t>(ticks);
+        return static_cast<uint64_t>(static_cast<double>(ticks) * 1e9 / static_cast<double>(frequency_));
+    };
+
+    const uint64_t arrivalNs = toNs(p.endTicks);
+    const uint64_t latencyNs = (p.stampNs != 0 && p.stampNs <= arrivalNs)
+        ? arrivalNs - p.stampNs
+        : toNs(p.readTicks);
+
+    uint64_t units = arrivalNs > start_ns_ ? (arrivalNs - start_ns_) / kArrivalUnitNs : 0;
+    if (units < last_arrival_units_) units = last_arrival_units_;
+    RecordingVarint::Put(arrival_col_, units - last_arrival_units_);
+    last_arrival_units_ = units;
+
+    RecordingVarint::Put(latency_col_, RecordingLatency::Bucket((latencyNs + kLatencyUnitNs / 2) / kLatencyUnitNs));
+    device_col_.Add(p.device);
+    type_col_.Add(p.type);
+    batch_col_.Add(p.batch);
+    block_count_++;
+}
+
+bool EventRecorder::WriteBlock() {
+    if (block_count_ == 0) return true;
+
+    device_col_.Finish();
+    type_col_.Finish();
+    batch_col_.Finish();
+
+    const std::vector<uint8_t>* cols[kRecordingColumns] = {
+        &arrival_col_, &latency_col_, &device_col_.bytes, &type_col_.bytes, &batch_col_.bytes
+    };
+
+    uint32_t words[2 + kRecordingColumns] = { kRecordingBlockMagic, block_count_ };
+    size_t total = sizeof(words);
+    for (int i = 0; i < kRecordingColumns; i++) {
+        words[2 + i] = static_cast<uint32_t>(cols[i]->size());
+        total += cols[i]->size();
+    }
+
+    const uint32_t count = block_count_;
+    block_count_ = 0;
+
+    bool ok = Reserve(total);
+    if (ok) {
+        uint8_t* out = map_ + Header()->bytesUsed;
+        std::memcpy(out, words, sizeof(words));
+        out += sizeof(words);
+        for (int i = 0; i < kRecordingColumns; i++) {
+            if (!cols[i]->empty()) std::memcpy(out, cols[i]->data(), cols[i]->size());
+            out += cols[i]->size();
+        }
+
+        // Publish the block only once it is complete.
+        RecordingHeader* h = Header();
+        h->bytesUsed += total;
+        h->recordCount += count;
+        h->dropped = dropped_.load(std::memory_order_relaxed);
+        recorded_.fetch_add(count, std::memory_order_relaxed);
+    } else {
+        dropped_.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    arrival_col_.clear();
+    latency_col_.clear();
+    device_col_.Clear();
+    type_col_.Clear();
+    batch_col_.Clear();
+    return ok;
+}
+
+bool EventRecorder::Reserve(size_t bytes) {
+    if (!map_) return false;
+
+    const size_t need = static_cast<size_t>(Header()->bytesUsed) + bytes;
+    if (need <= map_size_) return true;
+
+    return MapFile((need + kGrowBytes - 1) / kGrowBytes * kGrowBytes);
+}
+
+bool EventRecorder::MapFile(size_t bytes) {
+    UnmapFile();
+
+#ifdef _WIN32
+    const ULONGLONG size = bytes;
+    HANDLE mapping = CreateFileMappingW(file_, nullptr, PAGE_READWRITE,
+        static_cast<DWORD>(size >> 32), static_cast<DWORD>(size & 0xFFFFFFFFull), nullptr);
+    if (!mapping) return false;
+    mapping_ = mapping;
+
+    map_ = static_cast<uint8_t*>(MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, bytes));
+#else
+    if (ftruncate(fd_, static_cast<off_t>(bytes)) != 0) return false;
+
+    void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    map_ = p == MAP_FAILED ? nullptr : static_cast<uint8_t*>(p);
+#endif
+
+    if (!map_) return false;
+    map_size_ = bytes;
+    return true;
+}
+
+void EventRecorder::UnmapFile() {
+#ifdef _WIN32
+    if (map_) UnmapViewOfFile(map_);
+    if (mapping_) CloseHandle(mapping_);
+    mapping_ = nullptr;
+#else
+    if (map_) munmap(map_, map_size_);
+#endif
+    map_ = nullptr;
+    map_size_ = 0;
+}
+
+// Unmaps and trims the file to the header plus complete blocks.
+void EventRecorder::CloseFile() {
+    const uint64_t used = map_ ? Header()->bytesUsed : 0;
+    UnmapFile();
+
+#ifdef _WIN32
+    if (file_) {
+        LARGE_INTEGER end{};
+        end.QuadPart = static_cast<LONGLONG>(used);
+        if (used && SetFilePointerEx(file_, end, nullptr, FILE_BEGIN)) SetEndOfFile(file_);
+        CloseHandle(file_);
+        file_ = nullptr;
+    }
+#else
+    if (fd_ >= 0) {
+        if (used) {
+            const int rc = ftruncate(fd_, static_cast<off_t>(used));
+            (void)rc;
+        }
+        close(fd_);
+        fd_ = -1;
+    }
+#endif
+}
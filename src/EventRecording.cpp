@@ -0,0 +1,166 @@
+#include "../include/EventRecording.h"
+#include <cstring>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char kMagic[8] = { 'I', 'L', 'O', 'R', 'E', 'C', '0', '1' };
+
+bool EventRecordingReader::RunColumn::Next(uint64_t& v) {
+    if (left == 0) {
+        if (!RecordingVarint::Get(p, end, value)) return false;
+        if (!RecordingVarint::Get(p, end, left) || left == 0) return false;
+    }
+    left--;
+    v = value;
+    return true;
+}
+
+EventRecordingReader::~EventRecordingReader() {
+    Close();
+}
+
+bool EventRecordingReader::Open(const std::string& path) {
+    Close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    file_ = file;
+
+    LARGE_INTEGER size{};
+    if (!GetFileSizeEx(file, &size) || size.QuadPart < static_cast<LONGLONG>(sizeof(RecordingHeader))) {
+        Close();
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        Close();
+        return false;
+    }
+    mapping_ = mapping;
+
+    base_ = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    size_ = static_cast<size_t>(size.QuadPart);
+#else
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(RecordingHeader))) {
+        close(fd);
+        return false;
+    }
+
+    void* p = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) return false;
+
+    madvise(p, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+    base_ = static_cast<const uint8_t*>(p);
+    mapped_size_ = static_cast<size_t>(st.st_size);
+    size_ = mapped_size_;
+#endif
+
+    if (!base_) {
+        Close();
+        return false;
+    }
+
+    std::memcpy(&header_, base_, sizeof(header_));
+    if (std::memcmp(header_.magic, kMagic, sizeof(kMagic)) != 0 ||
+        header_.version < 1 || header_.version > kRecordingVersion ||
+        header_.headerSize < sizeof(RecordingHeader) ||
+        header_.arrivalUnitNs == 0 || header_.latencyUnitNs == 0) {
+        Close();
+        return false;
+    }
+
+    // A live or crashed recording may still be longer than bytesUsed.
+    if (header_.bytesUsed < size_) size_ = static_cast<size_t>(header_.bytesUsed);
+    offset_ = header_.headerSize;
+    return true;
+}
+
+void EventRecordingReader::Close() {
+#ifdef _WIN32
+    if (base_) UnmapViewOfFile(base_);
+    if (mapping_) CloseHandle(mapping_);
+    if (file_) CloseHandle(file_);
+    mapping_ = nullptr;
+    file_ = nullptr;
+#else
+    if (base_) munmap(const_cast<uint8_t*>(base_), mapped_size_);
+    mapped_size_ = 0;
+#endif
+    base_ = nullptr;
+    size_ = 0;
+    offset_ = 0;
+    block_left_ = 0;
+    arrival_units_ = 0;
+    header_ = RecordingHeader{};
+}
+
+bool EventRecordingReader::LoadBlock() {
+    uint32_t words[2 + kRecordingColumns]{};
+    if (offset_ + sizeof(words) > size_) return false;
+    std::memcpy(words, base_ + offset_, sizeof(words));
+    if (words[0] != kRecordingBlockMagic || words[1] == 0) return false;
+
+    size_t pos = offset_ + sizeof(words);
+    const uint8_t* begin[kRecordingColumns]{};
+    const uint8_t* end[kRecordingColumns]{};
+    for (int i = 0; i < kRecordingColumns; i++) {
+        if (pos + words[2 + i] > size_) return false;
+        begin[i] = base_ + pos;
+        pos += words[2 + i];
+        end[i] = base_ + pos;
+    }
+
+    arrival_ = begin[0];
+    arrival_end_ = end[0];
+    latency_ = begin[1];
+    latency_end_ = end[1];
+    device_ = RunColumn{ begin[2], end[2] };
+    type_ = RunColumn{ begin[3], end[3] };
+    batch_ = RunColumn{ begin[4], end[4] };
+
+    block_left_ = words[1];
+    offset_ = pos;
+    return true;
+}
+
+bool EventRecordingReader::Next(EventRecord& out) {
+    if (!base_) return false;
+    if (block_left_ == 0 && !LoadBlock()) return false;
+
+    uint64_t delta = 0, latency = 0, device = 0, type = 0, batch = 0;
+    if (!RecordingVarint::Get(arrival_, arrival_end_, delta) ||
+        !RecordingVarint::Get(latency_, latency_end_, latency) ||
+        !device_.Next(device) || !type_.Next(type) || !batch_.Next(batch)) {
+        block_left_ = 0;
+        offset_ = size_;
+        return false;
+    }
+    block_left_--;
+
+    arrival_units_ += delta;
+    out.arrivalNs = header_.startNs + arrival_units_ * header_.arrivalUnitNs;
+    if (header_.version >= 2) latency = RecordingLatency::Value(latency);
+    out.latencyNs = latency * header_.latencyUnitNs;
+    out.device = device;
+    out.type = static_cast<uint16_t>(type);
+    out.batch = static_cast<uint16_t>(batch);
+    return true;
+}
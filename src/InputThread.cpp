@@ -1,19 +1,47 @@
 #include "../include/InputThread.h"
+#include "../include/PreciseWaiter.h"
+#include <algorithm>
+#include <cwchar>
+
+#ifdef _WIN32
 #include <avrt.h>
 #include <mmsystem.h>
-#include <strsafe.h>
 
 #pragma comment(lib, "avrt.lib")
 #pragma comment(lib, "winmm.lib")
-
-InputThread::InputThread() {
-    h_instance_ = GetModuleHandleW(nullptr);
-}
+#else
+#include <dirent.h>
+#include <errno.h>
+#include <sched.h>
+#include <fcntl.h>
+#include <sys/prctl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <cstring>
+#endif
+
+InputThread::InputThread() {}
 
 InputThread::~InputThread() {
     Stop();
 }
 
+void InputThread::SetInputSource(std::unique_ptr<InputSource> source) {
+    if (running_) return;
+    source_ = std::move(source);
+}
+
+void InputThread::SetPmQosPath(std::string path) {
+#ifndef _WIN32
+    if (running_) return;
+    pm_qos_path_ = std::move(path);
+#else
+    (void)path;
+#endif
+}
+
 InputThread::Config InputThread::GetConfig() const {
     std::lock_guard<std::mutex> lock(config_mutex_);
     return config_;
@@ -27,29 +55,43 @@ bool InputThread::Start(const Config& config) {
         std::lock_guard<std::mutex> lock(config_mutex_);
         config_ = config;
     }
+    batched_reads_ = config.enableBatchedReads;
+#ifndef _WIN32
+    busy_poll_ = config.enableBusyPoll;
+    busy_poller_.SetBudget(config.busyPollBudget);
+    if (config.enableBusyPoll) busy_poller_.StartPowerWatch();
+#endif
+
+    if (!source_) source_ = CreateDefaultInputSource();
+
+    // A previous thread that exited on its own still needs joining.
+    if (thread_.joinable()) thread_.join();
 
     should_exit_ = false;
     running_ = true;
 
     thread_ = std::thread(&InputThread::ThreadProc, this);
+#ifdef _WIN32
     thread_handle_ = reinterpret_cast<HANDLE>(thread_.native_handle());
+#endif
     return true;
 }
 
 void InputThread::Stop() {
     desired_running_ = false;
-    if (!running_) return;
+    if (!running_ && !thread_.joinable()) return;
 
     should_exit_ = true;
-
-    if (thread_id_ != 0) {
-        PostThreadMessageW(thread_id_, WM_QUIT, 0, 0);
-    }
+    if (source_) source_->Wake();
 
     if (thread_.joinable()) thread_.join();
 
+#ifdef _WIN32
     thread_handle_ = nullptr;
-    thread_id_ = 0;
+#else
+    thread_tid_ = 0;
+    busy_poller_.StopPowerWatch();
+#endif
     running_ = false;
 
     RestoreSystemSettings();
@@ -60,168 +102,265 @@ void InputThread::UpdateConfig(const Config& newConfig) {
         std::lock_guard<std::mutex> lock(config_mutex_);
         config_ = newConfig;
     }
+    batched_reads_ = newConfig.enableBatchedReads;
+#ifndef _WIN32
+    busy_poll_ = newConfig.enableBusyPoll;
+    busy_poller_.SetBudget(newConfig.busyPollBudget);
+    if (newConfig.enableBusyPoll && running_) busy_poller_.StartPowerWatch();
+#endif
 
     if (running_) {
-        ApplyAffinity();
-        ApplyThreadPriority();
-        ApplyProcessPriority();
-        ApplyTimerResolution();
+        if (PreciseWaiter* w = source_ ? source_->Waiter() : nullptr) w->SetMargin(newConfig.waitOvershootUs);
+        ApplySystemSettings();
     }
 }
 
 std::wstring InputThread::GetStatus() const {
     Config cfg = GetConfig();
-
-    wchar_t buf[640]{};
-    StringCchPrintfW(buf, _countof(buf),
-        L"Input Thread: %s\r\n"
-        L"Timer Boost: %s (%u ms)\r\n"
-        L"Process Priority: %s\r\n"
-        L"Thread Priority: %s\r\n"
-        L"Affinity: %s\r\n"
-        L"Samples: %zu",
-        running_ ? L"Running" : L"Stopped",
+    const LatencySnapshot snap = measurer_.Snapshot();
+    const LatencyStats& lat = snap.processing;
+    const LatencyStats& dlv = snap.delivery;
+    const ReadBatchStats& rb = snap.reads;
+
+#ifdef _WIN32
+    wchar_t timerBuf[64]{};
+    std::swprintf(timerBuf, sizeof(timerBuf) / sizeof(timerBuf[0]), L"%ls (%u ms)",
         cfg.enableTimerBoost ? L"Enabled" : L"Disabled",
-        cfg.enableTimerBoost ? cfg.timerResolutionMs : 0,
-        cfg.enableProcessPriority ? L"High" : L"Normal",
-        cfg.enableThreadPriority ? L"High" : L"Normal",
-        (cfg.enableAffinity && cfg.affinityMask) ? L"Pinned" : L"Default",
-        measurer_.GetSampleCount());
-
-    return std::wstring(buf);
-}
-
-LRESULT CALLBACK InputThread::HiddenWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
-    return DefWindowProcW(hwnd, msg, wParam, lParam);
-}
-
-bool InputThread::CreateHiddenWindow() {
-    const wchar_t* cls = L"ILO_InputMsgWnd";
-
-    WNDCLASSEXW wc{};
-    wc.cbSize = sizeof(wc);
-    wc.lpfnWndProc = HiddenWndProc;
-    wc.hInstance = h_instance_;
-    wc.lpszClassName = cls;
-
-    RegisterClassExW(&wc);
-
-    hwnd_ = CreateWindowExW(0, cls, L"", 0, 0, 0, 0, 0,
-        HWND_MESSAGE, nullptr, h_instance_, nullptr);
-
-    return hwnd_ != nullptr;
-}
-
-void InputThread::DestroyHiddenWindow() {
-    if (hwnd_) {
-        DestroyWindow(hwnd_);
-        hwnd_ = nullptr;
+        cfg.enableTimerBoost ? cfg.timerResolutionMs : 0);
+    const std::wstring timerBoost = timerBuf;
+    const std::wstring processPrio = cfg.enableProcessPriority ? L"High" : L"Normal";
+    const std::wstring threadPrio = cfg.enableThreadPriority ? L"High" : L"Normal";
+#else
+    std::wstring processPrio = L"Normal";
+    if (cfg.enableProcessPriority && process_nice_threads_ > 0) {
+        processPrio = L"nice " + std::to_wstring(process_nice_applied_.load()) +
+            L" (" + std::to_wstring(process_nice_threads_.load()) + L" threads)";
     }
-}
+    const std::wstring threadPrio = running_ ? SchedulingText() : std::wstring(L"Normal");
 
-bool InputThread::InitializeRawInput(HWND hwnd) {
-    RAWINPUTDEVICE rid[2]{};
+    std::wstring timerBoost = L"Disabled";
+    if (cfg.enableTimerBoost) {
+        const unsigned long slack = applied_slack_ns_;
+        const int qos = pm_qos_applied_us_;
+        timerBoost = L"slack " + (slack ? std::to_wstring(slack) + L" ns" : std::wstring(L"default")) +
+            L", PM QoS " + (qos >= 0 ? std::to_wstring(qos) + L" us" : std::wstring(L"unavailable"));
+    }
+#endif
 
-    rid[0].usUsagePage = 0x01;
-    rid[0].usUsage = 0x06; // keyboard
-    rid[0].dwFlags = RIDEV_INPUTSINK;
-    rid[0].hwndTarget = hwnd;
+    std::wstring affinity = L"Default";
+    if (cfg.enableAffinity && !cfg.affinity.Empty()) {
+        const std::string cpus = cfg.affinity.ToString();
+        affinity = L"Pinned to " + std::wstring(cpus.begin(), cpus.end());
+    }
 
-    rid[1].usUsagePage = 0x01;
-    rid[1].usUsage = 0x02; // mouse
-    rid[1].dwFlags = RIDEV_INPUTSINK;
-    rid[1].hwndTarget = hwnd;
+    wchar_t buf[1280]{};
+    std::swprintf(buf, sizeof(buf) / sizeof(buf[0]),
+        L"Input Thread: %ls (%ls)\r\n"
+        L"Timer Boost: %ls\r\n"
+        L"Process Priority: %ls\r\n"
+        L"Thread Priority: %ls\r\n"
+        L"Affinity: %ls\r\n"
+        L"Samples: %llu\r\n"
+        L"Latency (us): min %.1f / avg %.1f / p50 %.1f / p95 %.1f / p99 %.1f / p99.9 %.1f / max %.1f\r\n"
+        L"Jitter (us): %.1f\r\n"
+        L"Delivery (us): n %llu / p50 %.1f / p99 %.1f / p99.9 %.1f / max %.1f\r\n"
+        L"Reads: %ls, %llu events in %llu reads (batch avg %.1f / max %u)\r\n"
+        L"Recording: %ls (%llu events, %llu dropped)",
+        running_ ? L"Running" : L"Stopped",
+        source_ ? source_->Name() : L"none",
+        timerBoost.c_str(),
+        processPrio.c_str(),
+        threadPrio.c_str(),
+        affinity.c_str(),
+        static_cast<unsigned long long>(lat.count),
+        lat.minUs, lat.avgUs, lat.p50Us, lat.p95Us, lat.p99Us, lat.p999Us, lat.maxUs,
+        lat.jitterUs,
+        static_cast<unsigned long long>(dlv.count),
+        dlv.p50Us, dlv.p99Us, dlv.p999Us, dlv.maxUs,
+        cfg.enableBatchedReads ? L"Batched" : L"Per-event",
+        static_cast<unsigned long long>(rb.events),
+        static_cast<unsigned long long>(rb.reads),
+        rb.avgBatch, rb.maxBatch,
+        recorder_.IsActive() ? L"On" : L"Off",
+        static_cast<unsigned long long>(recorder_.Recorded()),
+        static_cast<unsigned long long>(recorder_.Dropped()));
+
+    std::wstring status = buf;
+#ifndef _WIN32
+    if (cfg.enableBusyPoll) {
+        // Blocked wakeups come from the baseline windows, so the difference
+        // is what polling saved under the same load.
+        const BusyPollStats bp = busy_poller_.Stats();
+        std::swprintf(buf, sizeof(buf) / sizeof(buf[0]),
+            L"\r\nBusy Poll: %ls, CPU %.0f%% of %.0f%% budget (%llu windows over budget)\r\n"
+            L"Wakeup (us): polled n %llu / avg %.1f / p99 %.1f, blocking n %llu / avg %.1f / p99 %.1f, removed %.1f",
+            bp.onBattery ? L"off (on battery)" : (bp.polling ? L"polling" : L"blocking"),
+            bp.spinFraction * 100.0, bp.budget * 100.0, static_cast<unsigned long long>(bp.budgetExhausted),
+            static_cast<unsigned long long>(bp.polledWakeups), bp.polledAvgUs, bp.polledP99Us,
+            static_cast<unsigned long long>(bp.blockedWakeups), bp.blockedAvgUs, bp.blockedP99Us,
+            bp.removedUs);
+        status += buf;
+    }
+#endif
+    if (PreciseWaiter* w = source_ ? source_->Waiter() : nullptr) {
+        // Spin time is CPU the waiter burnt; it is the price of the accuracy.
+        const WaiterStats ws = w->Stats();
+        std::swprintf(buf, sizeof(buf) / sizeof(buf[0]),
+            L"\r\nPrecise Wait: margin %.0f us, %llu waits (%llu missed), late avg %.1f / max %.1f us, "
+            L"spin %.1f ms (%.1f%% of waiting)",
+            ws.marginUs, static_cast<unsigned long long>(ws.waits), static_cast<unsigned long long>(ws.missed),
+            ws.avgLateUs, ws.maxLateUs, ws.spunUs / 1000.0, ws.spinFraction * 100.0);
+        status += buf;
+    }
 
-    return RegisterRawInputDevices(rid, 2, sizeof(rid[0])) != FALSE;
+    const DeviceStatsSnapshot ds = device_stats_.Snapshot();
+    for (int i = 0; i < ds.count; i++) {
+        const DeviceStats& d = ds.devices[i];
+        std::swprintf(buf, sizeof(buf) / sizeof(buf[0]),
+#ifdef _WIN32
+            L"\r\nDevice %#llx: %llu events, %.0f Hz (interval %.1f +/- %.1f us), %ls (us): "
+#else
+            L"\r\nDevice fd %llu: %llu events, %.0f Hz (interval %.1f +/- %.1f us), %ls (us): "
+#endif
+            L"p50 %.1f / p95 %.1f / p99 %.1f / max %.1f",
+            static_cast<unsigned long long>(d.device), static_cast<unsigned long long>(d.events),
+            d.rateHz, d.intervalUs, d.jitterUs, d.stamped ? L"delivery" : L"read",
+            d.p50Us, d.p95Us, d.p99Us, d.maxUs);
+        status += buf;
+    }
+    if (ds.untracked) {
+        std::swprintf(buf, sizeof(buf) / sizeof(buf[0]), L"\r\nDevices: %llu events from untracked devices (over %d)",
+            static_cast<unsigned long long>(ds.untracked), DeviceStatsSnapshot::kMaxDevices);
+        status += buf;
+    }
+    return status;
 }
 
 void InputThread::ThreadProc() {
-    thread_id_ = GetCurrentThreadId();
-
-    MSG dummy{};
-    PeekMessageW(&dummy, nullptr, 0, 0, PM_NOREMOVE);
+#ifndef _WIN32
+    thread_tid_ = static_cast<int>(syscall(SYS_gettid));
+#endif
 
+#ifdef _WIN32
     Config cfg = GetConfig();
 
     // MMCSS only when user intent is Medium/Max (enableThreadPriority)
     if (cfg.enableThreadPriority) {
         hMmcss_ = AvSetMmThreadCharacteristicsW(L"Pro Audio", &mmcss_task_index_);
     }
+#endif
 
-    ApplyAffinity();
-    ApplyThreadPriority();
-    ApplyProcessPriority();
-    ApplyTimerResolution();
-
-    if (!CreateHiddenWindow()) {
-        running_ = false;
-        Cleanup();
-        return;
-    }
+    ApplySystemSettings();
 
-    if (!InitializeRawInput(hwnd_)) {
+    if (!source_->Open()) {
+        source_->Close();
         running_ = false;
-        DestroyHiddenWindow();
         Cleanup();
         return;
     }
 
-    static thread_local std::vector<BYTE> buf;
-
-    MSG msg{};
-    while (!should_exit_ && GetMessageW(&msg, nullptr, 0, 0) > 0) {
-        if (msg.message == WM_INPUT) {
-            measurer_.StartMeasurement();
+    if (PreciseWaiter* waiter = source_->Waiter()) waiter->SetMargin(GetConfig().waitOvershootUs);
 
-            UINT size = 0;
-            GetRawInputData(reinterpret_cast<HRAWINPUT>(msg.lParam), RID_INPUT,
-                nullptr, &size, sizeof(RAWINPUTHEADER));
+    InputEvent events[kReadBatch];
+    device_stats_.Reset(); // device handles and fds are only meaningful per Open()
+#ifndef _WIN32
+    busy_poller_.Reset();
+#endif
 
-            if (size > 0) {
-                if (buf.size() < size) buf.resize(size);
-                UINT got = size;
-                if (GetRawInputData(reinterpret_cast<HRAWINPUT>(msg.lParam), RID_INPUT,
-                    buf.data(), &got, sizeof(RAWINPUTHEADER)) > 0) {
-                    // Timing only.
-                }
-            }
+    while (!should_exit_) {
+#ifndef _WIN32
+        if (timer_slack_pending_.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lock(settings_mutex_);
+            ApplyTimerSlack();
+        }
 
-            measurer_.EndMeasurement();
+        const bool polling = busy_poll_.load(std::memory_order_relaxed);
+        const InputSource::WaitResult w = polling
+            ? busy_poller_.Wait(*source_, kIdlePublishMs)
+            : source_->Wait(kIdlePublishMs);
+#else
+        const InputSource::WaitResult w = source_->Wait(kIdlePublishMs);
+#endif
+        if (w == InputSource::WaitResult::Exit) break;
+
+        if (w == InputSource::WaitResult::Timeout) {
+            measurer_.PublishIfDirty();
+            device_stats_.PublishIfDirty();
             continue;
         }
 
-        TranslateMessage(&msg);
-        DispatchMessageW(&msg);
+        const int want = batched_reads_.load(std::memory_order_relaxed) ? kReadBatch : 1;
+
+        measurer_.StartMeasurement();
+        const int n = source_->Read(events, want);
+        if (n < 0) break;
+        if (n == 0) continue;
+
+        measurer_.EndMeasurement();
+        measurer_.RecordBatch(static_cast<uint32_t>(n));
+#ifndef _WIN32
+        if (polling) busy_poller_.RecordWakeup(events, n, measurer_.LastEndTicks());
+#endif
+        recorder_.Append(events, n, measurer_.LastEndTicks(), measurer_.LastElapsedTicks());
+        for (int i = 0; i < n; i++) {
+            if (events[i].timestampNs) measurer_.RecordDelivery(events[i].timestampNs);
+            device_stats_.Record(events[i], measurer_.LastEndTicks(), measurer_.LastElapsedTicks());
+        }
+        device_stats_.PublishIfDue(measurer_.LastEndTicks());
     }
 
-    DestroyHiddenWindow();
+    measurer_.Flush();
+    device_stats_.PublishIfDirty();
+#ifndef _WIN32
+    busy_poller_.Flush();
+#endif
+    source_->Close();
     Cleanup();
+
+    // Source failure rather than Stop(): let the watchdog restart us.
+    if (!should_exit_) running_ = false;
+}
+
+// Both the input thread (on start) and UpdateConfig() callers apply settings,
+// and Stop() or the exiting thread restores them; settings_mutex_ keeps them
+// from interleaving on the saved originals.
+void InputThread::ApplySystemSettings() {
+    std::lock_guard<std::mutex> lock(settings_mutex_);
+    ApplyAffinity();
+    ApplyThreadPriority();
+    ApplyProcessPriority();
+    ApplyTimerResolution();
 }
 
 void InputThread::Cleanup() {
+#ifdef _WIN32
     if (hMmcss_) {
         AvRevertMmThreadCharacteristics(hMmcss_);
         hMmcss_ = nullptr;
     }
+#endif
 
     RestoreSystemSettings();
 }
 
+#ifdef _WIN32
+
 void InputThread::ApplyAffinity() {
     if (!thread_handle_) return;
 
     Config cfg = GetConfig();
 
-    if (cfg.enableAffinity && cfg.affinityMask) {
-        DWORD_PTR prev = SetThreadAffinityMask(thread_handle_, cfg.affinityMask);
-        if (prev != 0) {
-            if (original_affinity_mask_ == 0) original_affinity_mask_ = prev;
-            applied_affinity_mask_ = cfg.affinityMask;
+    if (cfg.enableAffinity && !cfg.affinity.Empty()) {
+        CpuSet prev;
+        if (!CpuSet::OfThread(thread_handle_, prev)) return;
+        if (cfg.affinity.ApplyTo(thread_handle_)) {
+            if (original_affinity_.Empty()) original_affinity_ = prev;
+            applied_affinity_ = cfg.affinity;
         }
     } else {
-        if (original_affinity_mask_ != 0 && applied_affinity_mask_ != 0) {
-            SetThreadAffinityMask(thread_handle_, original_affinity_mask_);
-            applied_affinity_mask_ = 0;
+        if (!original_affinity_.Empty() && !applied_affinity_.Empty()) {
+            original_affinity_.ApplyTo(thread_handle_);
+            applied_affinity_.Clear();
         }
     }
 }
@@ -267,6 +406,7 @@ void InputThread::ApplyTimerResolution() {
 }
 
 void InputThread::RestoreSystemSettings() {
+    std::lock_guard<std::mutex> lock(settings_mutex_);
     HANDLE hProc = GetCurrentProcess();
     SetPriorityClass(hProc, original_process_priority_);
 
@@ -275,10 +415,338 @@ void InputThread::RestoreSystemSettings() {
         applied_timer_resolution_ms_ = 0;
     }
 
-    if (original_affinity_mask_ != 0 && applied_affinity_mask_ != 0 && thread_handle_) {
-        SetThreadAffinityMask(thread_handle_, original_affinity_mask_);
-        applied_affinity_mask_ = 0;
+    if (!original_affinity_.Empty() && !applied_affinity_.Empty() && thread_handle_) {
+        original_affinity_.ApplyTo(thread_handle_);
+        applied_affinity_.Clear();
+    }
+
+    original_affinity_.Clear();
+}
+
+#else // Linux
+
+void InputThread::ApplyAffinity() {
+    const int tid = thread_tid_;
+    if (!tid) return;
+
+    Config cfg = GetConfig();
+
+    if (cfg.enableAffinity && !cfg.affinity.Empty()) {
+        CpuSet prev;
+        if (!CpuSet::OfThread(tid, prev)) return;
+        if (cfg.affinity.ApplyTo(tid)) {
+            if (original_affinity_.Empty()) original_affinity_ = prev;
+            applied_affinity_ = cfg.affinity;
+        }
+    } else {
+        if (!original_affinity_.Empty() && !applied_affinity_.Empty()) {
+            original_affinity_.ApplyTo(tid);
+            applied_affinity_.Clear();
+        }
+    }
+}
+
+#ifndef SCHED_DEADLINE
+#define SCHED_DEADLINE 6
+#endif
+
+// Kernel ABI for sched_getattr/sched_setattr (no glibc wrapper before 2.41).
+struct LinuxSchedAttr {
+    uint32_t size;
+    uint32_t sched_policy;
+    uint64_t sched_flags;
+    int32_t sched_nice;
+    uint32_t sched_priority;
+    uint64_t sched_runtime;
+    uint64_t sched_deadline;
+    uint64_t sched_period;
+};
+
+static bool GetSchedAttr(int tid, LinuxSchedAttr& a) {
+    std::memset(&a, 0, sizeof(a));
+    a.size = sizeof(a);
+    return syscall(SYS_sched_getattr, tid, &a, sizeof(a), 0) == 0;
+}
+
+static bool SetSchedAttr(int tid, const LinuxSchedAttr& a) {
+    return syscall(SYS_sched_setattr, tid, &a, 0) == 0;
+}
+
+static const wchar_t* PolicyName(uint32_t policy) {
+    switch (policy) {
+    case SCHED_FIFO: return L"SCHED_FIFO";
+    case SCHED_RR: return L"SCHED_RR";
+    case SCHED_DEADLINE: return L"SCHED_DEADLINE";
+    case SCHED_BATCH: return L"SCHED_BATCH";
+    case SCHED_IDLE: return L"SCHED_IDLE";
+    default: return L"SCHED_OTHER";
+    }
+}
+
+// Lowest nice value RLIMIT_NICE allows without CAP_SYS_NICE.
+static int NiceFloor() {
+    rlimit rl{};
+    if (getrlimit(RLIMIT_NICE, &rl) != 0 || rl.rlim_cur == RLIM_INFINITY) return -20;
+    return 20 - static_cast<int>(rl.rlim_cur);
+}
+
+bool InputThread::ApplySched(int tid, const SchedState& want) {
+    LinuxSchedAttr a{};
+    a.size = sizeof(a);
+    a.sched_policy = want.policy;
+    a.sched_nice = want.nice;
+    a.sched_priority = want.priority;
+    a.sched_runtime = want.runtimeNs;
+    a.sched_deadline = want.deadlineNs;
+    a.sched_period = want.periodNs;
+    if (!SetSchedAttr(tid, a)) return false;
+
+    effective_policy_ = want.policy;
+    effective_level_ = (want.policy == SCHED_FIFO || want.policy == SCHED_RR)
+        ? static_cast<int>(want.priority) : want.nice;
+    return true;
+}
+
+void InputThread::ApplyThreadPriority() {
+    const int tid = thread_tid_;
+    if (!tid) return;
+
+    Config cfg = GetConfig();
+
+    if (!original_sched_saved_) {
+        LinuxSchedAttr cur{};
+        if (GetSchedAttr(tid, cur)) {
+            original_sched_.policy = cur.sched_policy;
+            original_sched_.nice = cur.sched_nice;
+            original_sched_.priority = cur.sched_priority;
+            original_sched_.runtimeNs = cur.sched_runtime;
+            original_sched_.deadlineNs = cur.sched_deadline;
+            original_sched_.periodNs = cur.sched_period;
+            original_sched_saved_ = true;
+
+            effective_policy_ = cur.sched_policy;
+            effective_level_ = (cur.sched_policy == SCHED_FIFO || cur.sched_policy == SCHED_RR)
+                ? static_cast<int>(cur.sched_priority) : cur.sched_nice;
+        }
+    }
+
+    if (!cfg.enableThreadPriority) {
+        if (sched_applied_ && original_sched_saved_) ApplySched(tid, original_sched_);
+        sched_applied_ = false;
+        requested_policy_ = original_sched_.policy;
+        return;
+    }
+
+    SchedPolicy policy = cfg.schedPolicy;
+    int rtPriority = cfg.schedPriority;
+    if (policy == SchedPolicy::Auto) {
+        if (cfg.threadPriority >= THREAD_PRIORITY_HIGHEST) policy = SchedPolicy::Fifo;
+        else if (cfg.threadPriority > THREAD_PRIORITY_NORMAL) policy = SchedPolicy::RoundRobin;
+        else policy = SchedPolicy::Other;
+    }
+    if (rtPriority <= 0) {
+        if (cfg.threadPriority >= THREAD_PRIORITY_TIME_CRITICAL) rtPriority = 80;
+        else if (cfg.threadPriority >= THREAD_PRIORITY_HIGHEST) rtPriority = 50;
+        else rtPriority = 10;
+    }
+    rtPriority = std::min(std::max(rtPriority, 1), 99);
+
+    // Strongest first; each step is what we fall back to if the kernel says no.
+    bool ok = false;
+    if (policy == SchedPolicy::Deadline) {
+        requested_policy_ = SCHED_DEADLINE;
+        SchedState dl{};
+        dl.policy = SCHED_DEADLINE;
+        dl.runtimeNs = uint64_t(cfg.deadlineRuntimeUs) * 1000;
+        dl.deadlineNs = uint64_t(cfg.deadlineDeadlineUs) * 1000;
+        dl.periodNs = uint64_t(cfg.deadlinePeriodUs) * 1000;
+        ok = ApplySched(tid, dl); // EPERM without CAP_SYS_NICE, EBUSY under restricted affinity
+        if (!ok) policy = SchedPolicy::Fifo;
+    } else {
+        requested_policy_ = policy == SchedPolicy::Fifo ? SCHED_FIFO
+            : policy == SchedPolicy::RoundRobin ? SCHED_RR : SCHED_OTHER;
+    }
+
+    if (!ok && (policy == SchedPolicy::Fifo || policy == SchedPolicy::RoundRobin)) {
+        SchedState rt{};
+        rt.policy = policy == SchedPolicy::Fifo ? SCHED_FIFO : SCHED_RR;
+        rt.priority = static_cast<uint32_t>(rtPriority);
+        ok = ApplySched(tid, rt);
+
+        // Unprivileged: RLIMIT_RTPRIO caps the priority we may ask for.
+        rlimit rl{};
+        if (!ok && errno == EPERM && getrlimit(RLIMIT_RTPRIO, &rl) == 0 &&
+            rl.rlim_cur != RLIM_INFINITY && rl.rlim_cur > 0 && rl.rlim_cur < rt.priority) {
+            rt.priority = static_cast<uint32_t>(rl.rlim_cur);
+            ok = ApplySched(tid, rt);
+        }
+    }
+
+    if (!ok) {
+        SchedState other{};
+        other.policy = SCHED_OTHER;
+        other.nice = std::min(std::max(cfg.niceValue, -20), 19);
+        ok = ApplySched(tid, other);
+
+        // Unprivileged: RLIMIT_NICE bounds how far we may lower nice. Never
+        // end up nicer than the thread started.
+        const int floor = NiceFloor();
+        if (!ok && other.nice < floor && floor < original_sched_.nice) {
+            other.nice = floor;
+            ok = ApplySched(tid, other);
+        }
+    }
+
+    sched_applied_ = ok;
+}
+
+void InputThread::ApplyProcessPriority() {
+    Config cfg = GetConfig();
+    const int self = thread_tid_;
+
+    // Undo the previous pass first so a changed niceValue starts from scratch.
+    for (const auto& t : original_task_nice_) setpriority(PRIO_PROCESS, static_cast<id_t>(t.first), t.second);
+    original_task_nice_.clear();
+    process_nice_applied_ = 0;
+    process_nice_threads_ = 0;
+
+    if (!cfg.enableProcessPriority) return;
+
+    // Linux nice is per thread: apply it to every thread of the process except
+    // the input thread, which has its own policy.
+    int nice = std::min(std::max(cfg.niceValue, -20), 19);
+
+    DIR* dir = opendir("/proc/self/task");
+    if (!dir) return;
+
+    int applied = 0;
+    while (dirent* e = readdir(dir)) {
+        const int tid = std::atoi(e->d_name);
+        if (tid <= 0 || tid == self) continue;
+
+        errno = 0;
+        const int prev = getpriority(PRIO_PROCESS, static_cast<id_t>(tid));
+        if (prev == -1 && errno != 0) continue;
+
+        // Without CAP_SYS_NICE, settle for what RLIMIT_NICE allows.
+        bool ok = setpriority(PRIO_PROCESS, static_cast<id_t>(tid), nice) == 0;
+        const int floor = NiceFloor();
+        if (!ok && errno == EACCES && nice < floor && floor < prev) {
+            nice = floor;
+            ok = setpriority(PRIO_PROCESS, static_cast<id_t>(tid), nice) == 0;
+        }
+        if (ok) {
+            original_task_nice_.emplace_back(tid, prev);
+            applied++;
+        }
+    }
+    closedir(dir);
+
+    process_nice_applied_ = nice;
+    process_nice_threads_ = applied;
+}
+
+std::wstring InputThread::SchedulingText() const {
+    const uint32_t policy = effective_policy_;
+    const uint32_t requested = requested_policy_;
+
+    wchar_t buf[128]{};
+    if (policy == SCHED_FIFO || policy == SCHED_RR) {
+        std::swprintf(buf, sizeof(buf) / sizeof(buf[0]), L"%ls %d", PolicyName(policy), effective_level_.load());
+    } else if (policy == SCHED_DEADLINE) {
+        std::swprintf(buf, sizeof(buf) / sizeof(buf[0]), L"%ls", PolicyName(policy));
+    } else {
+        std::swprintf(buf, sizeof(buf) / sizeof(buf[0]), L"%ls nice %d", PolicyName(policy), effective_level_.load());
+    }
+
+    std::wstring text = buf;
+    if (requested != policy) {
+        text += L" (";
+        text += PolicyName(requested);
+        text += L" refused)";
+    }
+    return text;
+}
+
+void InputThread::ApplyTimerResolution() {
+    Config cfg = GetConfig();
+
+    // PM QoS: the request lasts as long as the fd stays open; rewriting the
+    // same fd updates it.
+    if (cfg.enableTimerBoost) {
+        if (pm_qos_fd_ < 0) pm_qos_fd_ = open(pm_qos_path_.c_str(), O_WRONLY | O_CLOEXEC);
+        if (pm_qos_fd_ >= 0) {
+            const int32_t us = static_cast<int32_t>(cfg.pmQosLatencyUs);
+            if (write(pm_qos_fd_, &us, sizeof(us)) == static_cast<ssize_t>(sizeof(us))) pm_qos_applied_us_ = us;
+        }
+    } else if (pm_qos_fd_ >= 0) {
+        close(pm_qos_fd_);
+        pm_qos_fd_ = -1;
+        pm_qos_applied_us_ = -1;
+    }
+
+    const int tid = thread_tid_;
+    if (tid && tid == static_cast<int>(syscall(SYS_gettid))) ApplyTimerSlack();
+    else if (tid) timer_slack_pending_ = true;
+}
+
+// Input thread only.
+void InputThread::ApplyTimerSlack() {
+    timer_slack_pending_ = false;
+    Config cfg = GetConfig();
+
+    if (!original_slack_saved_) {
+        const int cur = prctl(PR_GET_TIMERSLACK, 0, 0, 0, 0);
+        if (cur >= 0) {
+            original_slack_ns_ = static_cast<unsigned long>(cur);
+            original_slack_saved_ = true;
+        }
+    }
+
+    if (cfg.enableTimerBoost) {
+        // 0 would mean "reset to the default", so 1 ns is the floor.
+        const unsigned long slack = cfg.timerSlackNs ? cfg.timerSlackNs : 1;
+        if (prctl(PR_SET_TIMERSLACK, slack, 0, 0, 0) == 0) applied_slack_ns_ = slack;
+    } else if (applied_slack_ns_ != 0 && original_slack_saved_) {
+        prctl(PR_SET_TIMERSLACK, original_slack_ns_, 0, 0, 0);
+        applied_slack_ns_ = 0;
+    }
+}
+
+void InputThread::RestoreSystemSettings() {
+    std::lock_guard<std::mutex> lock(settings_mutex_);
+    const int tid = thread_tid_;
+
+    if (sched_applied_ && original_sched_saved_ && tid) ApplySched(tid, original_sched_);
+    sched_applied_ = false;
+    original_sched_saved_ = false;
+    requested_policy_ = effective_policy_.load();
+
+    for (const auto& t : original_task_nice_) setpriority(PRIO_PROCESS, static_cast<id_t>(t.first), t.second);
+    original_task_nice_.clear();
+    process_nice_applied_ = 0;
+    process_nice_threads_ = 0;
+
+    if (pm_qos_fd_ >= 0) {
+        close(pm_qos_fd_);
+        pm_qos_fd_ = -1;
     }
+    pm_qos_applied_us_ = -1;
 
-    original_affinity_mask_ = 0;
+    // Timer slack dies with the thread; restore it if we are still on it.
+    if (applied_slack_ns_ != 0 && tid && tid == static_cast<int>(syscall(SYS_gettid)) && original_slack_saved_) {
+        prctl(PR_SET_TIMERSLACK, original_slack_ns_, 0, 0, 0);
+    }
+    applied_slack_ns_ = 0;
+    original_slack_saved_ = false;
+    timer_slack_pending_ = false;
+
+    if (!original_affinity_.Empty() && !applied_affinity_.Empty() && tid) {
+        original_affinity_.ApplyTo(tid);
+        applied_affinity_.Clear();
+    }
+
+    original_affinity_.Clear();
 }
+
+#endif
@@ -0,0 +1,156 @@
+#include "../include/InputTrace.h"
+#include <cstring>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char kMagic[8] = { 'I', 'L', 'O', 'T', 'R', 'A', 'C', 'E' };
+
+static InputTraceHeader MakeHeader(uint64_t count) {
+    InputTraceHeader h{};
+    std::memcpy(h.magic, kMagic, sizeof(kMagic));
+    h.version = kInputTraceVersion;
+    h.recordSize = sizeof(InputTraceRecord);
+    h.count = count;
+    return h;
+}
+
+InputTraceWriter::~InputTraceWriter() {
+    Close();
+}
+
+bool InputTraceWriter::Open(const std::string& path) {
+    Close();
+
+    file_ = std::fopen(path.c_str(), "wb");
+    if (!file_) return false;
+
+    count_ = 0;
+    const InputTraceHeader h = MakeHeader(0);
+    if (std::fwrite(&h, sizeof(h), 1, file_) != 1) {
+        std::fclose(file_);
+        file_ = nullptr;
+        return false;
+    }
+    return true;
+}
+
+bool InputTraceWriter::Append(const InputEvent* events, size_t n) {
+    if (!file_) return false;
+
+    for (size_t i = 0; i < n; i++) {
+        InputTraceRecord r{};
+        r.timestampNs = events[i].timestampNs;
+        r.device = events[i].device;
+        r.type = events[i].type;
+        r.code = events[i].code;
+        r.value = events[i].value;
+        if (std::fwrite(&r, sizeof(r), 1, file_) != 1) return false;
+        count_++;
+    }
+    return true;
+}
+
+bool InputTraceWriter::Close() {
+    if (!file_) return false;
+
+    const InputTraceHeader h = MakeHeader(count_);
+    bool ok = std::fseek(file_, 0, SEEK_SET) == 0 && std::fwrite(&h, sizeof(h), 1, file_) == 1;
+    ok = (std::fclose(file_) == 0) && ok;
+    file_ = nullptr;
+    return ok;
+}
+
+MappedInputTrace::~MappedInputTrace() {
+    Close();
+}
+
+bool MappedInputTrace::Open(const std::string& path) {
+    Close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    file_ = file;
+
+    LARGE_INTEGER size{};
+    if (!GetFileSizeEx(file, &size) || size.QuadPart < static_cast<LONGLONG>(sizeof(InputTraceHeader))) {
+        Close();
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        Close();
+        return false;
+    }
+    mapping_ = mapping;
+
+    base_ = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    size_ = static_cast<size_t>(size.QuadPart);
+#else
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(InputTraceHeader))) {
+        close(fd);
+        return false;
+    }
+
+    void* p = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) return false;
+
+    // Replay walks the file front to back.
+    madvise(p, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+    base_ = p;
+    size_ = static_cast<size_t>(st.st_size);
+#endif
+
+    if (!base_) {
+        Close();
+        return false;
+    }
+
+    InputTraceHeader h{};
+    std::memcpy(&h, base_, sizeof(h));
+    const uint64_t available = (size_ - sizeof(h)) / sizeof(InputTraceRecord);
+    if (std::memcmp(h.magic, kMagic, sizeof(kMagic)) != 0 ||
+        h.version != kInputTraceVersion ||
+        h.recordSize != sizeof(InputTraceRecord) ||
+        h.count > available) {
+        Close();
+        return false;
+    }
+
+    records_ = reinterpret_cast<const InputTraceRecord*>(static_cast<const char*>(base_) + sizeof(h));
+    count_ = h.count;
+    return true;
+}
+
+void MappedInputTrace::Close() {
+#ifdef _WIN32
+    if (base_) UnmapViewOfFile(base_);
+    if (mapping_) CloseHandle(mapping_);
+    if (file_) CloseHandle(file_);
+    mapping_ = nullptr;
+    file_ = nullptr;
+#else
+    if (base_) munmap(const_cast<void*>(base_), size_);
+#endif
+    base_ = nullptr;
+    size_ = 0;
+    records_ = nullptr;
+    count_ = 0;
+}
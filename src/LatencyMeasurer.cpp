@@ -1,29 +1,380 @@
 #include "../include/LatencyMeasurer.h"
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+#include <utility>
 
-LatencyMeasurer::LatencyMeasurer() {
-    QueryPerformanceFrequency(&frequency_);
+// Histogram range: 1 unit .. 1 s at 3 significant digits (~170 KB at ns units).
+static constexpr int kHistDigits = 3;
+
+// t-digest compression: ~100 centroids, p99.9 within a few percent.
+static constexpr double kSketchCompression = 200.0;
+
+// Snapshot refresh rate while events are flowing.
+static constexpr int64_t kPublishPerSecond = 20;
+
+// Delivery deltas beyond this are stamps from another clock (e.g. a device
+// that rejected EVIOCSCLOCKID and still reports CLOCK_REALTIME).
+static constexpr int64_t kMaxDeliverySeconds = 10;
+
+template<typename P>
+BasicLatencyMeasurer<P>::Series::Series(Backend b, int64_t freq) {
+    Select(b, freq);
+}
+
+template<typename P>
+void BasicLatencyMeasurer<P>::Series::Select(Backend b, int64_t freq) {
+    backend_ = b;
+    latencies_.reset();
+    histogram_.reset();
+    sketch_.reset();
+
+    switch (b) {
+    case Backend::Ring:
+        latencies_ = std::make_unique<StatsRingBuffer<sample_type, 1000>>();
+        break;
+    case Backend::Histogram:
+        histogram_ = std::make_unique<LatencyHistogram>(1, P::HistogramUnitsPerSecond(freq), kHistDigits);
+        break;
+    case Backend::Sketch:
+        sketch_ = std::make_unique<QuantileSketch>(kSketchCompression);
+        break;
+    }
+}
+
+template<typename P>
+void BasicLatencyMeasurer<P>::Series::Record(int64_t ticks, int64_t freq) {
+    switch (backend_) {
+    case Backend::Ring:
+        latencies_->push(P::FromTicks(ticks, freq));
+        break;
+    case Backend::Histogram:
+        histogram_->record(P::HistogramValue(ticks, freq));
+        break;
+    case Backend::Sketch:
+        sketch_->push(static_cast<double>(P::FromTicks(ticks, freq)));
+        break;
+    }
+}
+
+template<typename P>
+void BasicLatencyMeasurer<P>::Series::Clear() {
+    if (latencies_) latencies_->clear();
+    if (histogram_) histogram_->clear();
+    if (sketch_) sketch_->clear();
+}
+
+template<typename P>
+void BasicLatencyMeasurer<P>::Series::Absorb(Series& batch) {
+    switch (backend_) {
+    case Backend::Ring:
+        batch.latencies_->forEach([this](sample_type v) { latencies_->push(v); });
+        break;
+    case Backend::Histogram:
+        histogram_->merge(*batch.histogram_);
+        break;
+    case Backend::Sketch:
+        sketch_->merge(*batch.sketch_);
+        break;
+    }
+    batch.Clear();
+}
+
+template<typename P>
+double BasicLatencyMeasurer<P>::Series::Min(int64_t f) const {
+    switch (backend_) {
+    case Backend::Histogram: return histogram_->min() * P::HistogramUnitUs(f);
+    case Backend::Sketch: return P::ValueUs(sketch_->min(), f);
+    default: return P::ValueUs(static_cast<double>(latencies_->min()), f);
+    }
+}
+
+template<typename P>
+double BasicLatencyMeasurer<P>::Series::Avg(int64_t f) const {
+    switch (backend_) {
+    case Backend::Histogram: return histogram_->average() * P::HistogramUnitUs(f);
+    case Backend::Sketch: return P::ValueUs(sketch_->average(), f);
+    default: return P::ValueUs(latencies_->mean(), f);
+    }
+}
+
+template<typename P>
+double BasicLatencyMeasurer<P>::Series::Max(int64_t f) const {
+    switch (backend_) {
+    case Backend::Histogram: return histogram_->max() * P::HistogramUnitUs(f);
+    case Backend::Sketch: return P::ValueUs(sketch_->max(), f);
+    default: return P::ValueUs(static_cast<double>(latencies_->max()), f);
+    }
+}
+
+template<typename P>
+double BasicLatencyMeasurer<P>::Series::Jitter(int64_t f) const {
+    switch (backend_) {
+    case Backend::Histogram: return histogram_->stddev() * P::HistogramUnitUs(f);
+    case Backend::Sketch: return P::ValueUs(sketch_->stddev(), f);
+    default: return P::ValueUs(latencies_->stddev(), f);
+    }
+}
+
+template<typename P>
+double BasicLatencyMeasurer<P>::Series::Percentile(double p, int64_t f) const {
+    switch (backend_) {
+    case Backend::Histogram: return histogram_->percentile(p) * P::HistogramUnitUs(f);
+    case Backend::Sketch: return P::ValueUs(sketch_->percentile(p), f);
+    default: return P::ValueUs(static_cast<double>(latencies_->percentile(p)), f);
+    }
+}
+
+template<typename P>
+size_t BasicLatencyMeasurer<P>::Series::Count() const {
+    switch (backend_) {
+    case Backend::Histogram: return static_cast<size_t>(histogram_->count());
+    case Backend::Sketch: return static_cast<size_t>(sketch_->count());
+    default: return latencies_->size();
+    }
+}
+
+template<typename P>
+LatencyStats BasicLatencyMeasurer<P>::Series::Summarize(int64_t f) const {
+    static const double kQuantiles[4] = { 0.50, 0.95, 0.99, 0.999 };
+    double q[4]{};
+
+    if (backend_ == Backend::Histogram) {
+        uint64_t raw[4]{};
+        histogram_->percentiles(kQuantiles, raw, 4);
+        const double unit = P::HistogramUnitUs(f);
+        for (int i = 0; i < 4; i++) q[i] = raw[i] * unit;
+    } else {
+        for (int i = 0; i < 4; i++) q[i] = Percentile(kQuantiles[i], f);
+    }
+
+    LatencyStats s{};
+    s.count = Count();
+    if (s.count == 0) return s;
+
+    s.minUs = Min(f);
+    s.avgUs = Avg(f);
+    s.jitterUs = Jitter(f);
+    s.p50Us = q[0];
+    s.p95Us = q[1];
+    s.p99Us = q[2];
+    s.p999Us = q[3];
+    s.maxUs = Max(f);
+    return s;
+}
+
+template<typename P>
+BasicLatencyMeasurer<P>::BasicLatencyMeasurer(Backend backend)
+    : backend_(backend),
+      processing_(backend, TickFrequency()),
+      delivery_(backend, TickFrequency()),
+      pending_processing_(backend, TickFrequency()),
+      pending_delivery_(backend, TickFrequency()),
+      merged_processing_(backend, TickFrequency()),
+      merged_delivery_(backend, TickFrequency()) {
+    frequency_ = TickFrequency();
+    publish_interval_ = frequency_ / kPublishPerSecond;
+    max_delivery_ticks_ = frequency_ * kMaxDeliverySeconds;
+}
+
+template<typename P>
+void BasicLatencyMeasurer<P>::StartMeasurement() {
+    start_time_ = ReadTicks();
+}
+
+template<typename P>
+void BasicLatencyMeasurer<P>::EndMeasurement() {
+    end_time_ = ReadTicks();
+    processing_.Record(end_time_ - start_time_, frequency_);
+
+    dirty_ = true;
+    if (end_time_ - last_publish_ >= publish_interval_) {
+        ApplyPendingReset();
+        Publish(end_time_);
+    }
+}
+
+template<typename P>
+void BasicLatencyMeasurer<P>::RecordDelivery(uint64_t eventTimestampNs) {
+    int64_t stamp = static_cast<int64_t>(eventTimestampNs);
+    if (frequency_ != 1000000000ll) {
+        stamp = static_cast<int64_t>(static_cast<double>(eventTimestampNs) * static_cast<double>(frequency_) / 1e9);
+    }
+
+    const int64_t waited = end_time_ - stamp;
+    if (waited < 0 || waited > max_delivery_ticks_) return;
+
+    delivery_.Record(waited, frequency_);
+    dirty_ = true;
+}
+
+template<typename P>
+void BasicLatencyMeasurer<P>::RecordBatch(uint32_t events) {
+    batch_sizes_.push(events);
+    batch_reads_++;
+    batch_events_ += events;
+}
+
+template<typename P>
+void BasicLatencyMeasurer<P>::PublishIfDirty() {
+    ApplyPendingReset();
+    if (!dirty_) return;
+
+    Publish(ReadTicks());
+}
+
+template<typename P>
+void BasicLatencyMeasurer<P>::Flush() {
+    ApplyPendingReset();
+    {
+        std::lock_guard<std::mutex> lock(exchange_mutex_);
+        DrainPending();
+    }
+    Publish(ReadTicks());
+}
+
+template<typename P>
+void BasicLatencyMeasurer<P>::ApplyPendingReset() {
+    if (!reset_requested_.load(std::memory_order_relaxed)) return;
+    if (!reset_requested_.exchange(false, std::memory_order_acquire)) return;
+    ResetRecorded();
 }
 
-void LatencyMeasurer::StartMeasurement() {
-    QueryPerformanceCounter(&start_time_);
+// Measuring thread: drops its own samples; readers drop theirs when the next
+// hand-off arrives with the new epoch.
+template<typename P>
+void BasicLatencyMeasurer<P>::ResetRecorded() {
+    processing_.Clear();
+    delivery_.Clear();
+    batch_sizes_.clear();
+    batch_reads_ = 0;
+    batch_events_ = 0;
+    epoch_++;
+    dirty_ = true;
 }
 
-void LatencyMeasurer::EndMeasurement() {
-    LARGE_INTEGER end_time{};
-    QueryPerformanceCounter(&end_time);
+// O(1) on the measuring thread: the read counters are stored as they are and
+// the series are swapped into the hand-off slot if a reader has emptied it.
+// Otherwise they keep accumulating until a later publish.
+template<typename P>
+void BasicLatencyMeasurer<P>::Publish(int64_t now) {
+    ReadBatchStats reads{};
+    reads.reads = batch_reads_;
+    reads.events = batch_events_;
+    reads.avgBatch = batch_sizes_.mean();
+    reads.maxBatch = batch_sizes_.max();
+    reads_.Store(reads);
+    last_publish_ = now;
 
-    LONGLONG elapsed = end_time.QuadPart - start_time_.QuadPart;
-    double latency_us = (elapsed * 1000000.0) / static_cast<double>(frequency_.QuadPart);
+    std::unique_lock<std::mutex> lock(exchange_mutex_, std::try_to_lock);
+    if (!lock.owns_lock() || pending_full_) return;
 
-    latencies_.push(latency_us);
+    std::swap(processing_, pending_processing_);
+    std::swap(delivery_, pending_delivery_);
+    pending_epoch_ = epoch_;
+    pending_full_ = true;
+    dirty_ = false;
 }
 
-double LatencyMeasurer::GetCurrentTimeUs() {
-    static LARGE_INTEGER freq{};
-    if (freq.QuadPart == 0) QueryPerformanceFrequency(&freq);
+template<typename P>
+void BasicLatencyMeasurer<P>::DrainPending() const {
+    if (!pending_full_) return;
 
+    if (pending_epoch_ != merged_epoch_) {
+        merged_processing_.Clear();
+        merged_delivery_.Clear();
+        merged_epoch_ = pending_epoch_;
+    }
+    merged_processing_.Absorb(pending_processing_);
+    merged_delivery_.Absorb(pending_delivery_);
+    pending_full_ = false;
+}
+
+template<typename P>
+LatencySnapshot BasicLatencyMeasurer<P>::Snapshot() const {
+    LatencySnapshot snap{};
+    {
+        std::lock_guard<std::mutex> lock(exchange_mutex_);
+        DrainPending();
+        snap.processing = merged_processing_.Summarize(frequency_);
+        snap.delivery = merged_delivery_.Summarize(frequency_);
+    }
+    snap.reads = reads_.Load();
+    return snap;
+}
+
+template<typename P>
+double BasicLatencyMeasurer<P>::GetPercentileLatency(double p) const {
+    std::lock_guard<std::mutex> lock(exchange_mutex_);
+    DrainPending();
+    return merged_processing_.Count() ? merged_processing_.Percentile(p, frequency_) : 0.0;
+}
+
+template<typename P>
+void BasicLatencyMeasurer<P>::SetBackend(Backend backend) {
+    backend_ = backend;
+    processing_.Select(backend, frequency_);
+    delivery_.Select(backend, frequency_);
+
+    std::lock_guard<std::mutex> lock(exchange_mutex_);
+    pending_processing_.Select(backend, frequency_);
+    pending_delivery_.Select(backend, frequency_);
+    merged_processing_.Select(backend, frequency_);
+    merged_delivery_.Select(backend, frequency_);
+    pending_full_ = false;
+    reads_.Store(ReadBatchStats{});
+    ResetRecorded();
+    merged_epoch_ = epoch_;
+}
+
+template<typename P>
+void BasicLatencyMeasurer<P>::Reset() {
+    ResetRecorded();
+
+    std::lock_guard<std::mutex> lock(exchange_mutex_);
+    pending_processing_.Clear();
+    pending_delivery_.Clear();
+    merged_processing_.Clear();
+    merged_delivery_.Clear();
+    pending_full_ = false;
+    merged_epoch_ = epoch_;
+    reads_.Store(ReadBatchStats{});
+}
+
+template<typename P>
+double BasicLatencyMeasurer<P>::GetCurrentTimeUs() {
+    static const int64_t freq = TickFrequency();
+    return (ReadTicks() * 1000000.0) / static_cast<double>(freq);
+}
+
+template<typename P>
+int64_t BasicLatencyMeasurer<P>::ReadTicks() {
+#ifdef _WIN32
     LARGE_INTEGER counter{};
     QueryPerformanceCounter(&counter);
+    return counter.QuadPart;
+#else
+    timespec ts{};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000ll + ts.tv_nsec;
+#endif
+}
 
-    return (counter.QuadPart * 1000000.0) / static_cast<double>(freq.QuadPart);
+template<typename P>
+int64_t BasicLatencyMeasurer<P>::TickFrequency() {
+#ifdef _WIN32
+    LARGE_INTEGER f{};
+    QueryPerformanceFrequency(&f);
+    return f.QuadPart;
+#else
+    return 1000000000ll;
+#endif
 }
+
+template class BasicLatencyMeasurer<MicrosecondSamples>;
+template class BasicLatencyMeasurer<TickSamples>;
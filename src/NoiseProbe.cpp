@@ -0,0 +1,52 @@
+#include "../include/NoiseProbe.h"
+#include "../include/LatencyMeasurer.h"
+#include <algorithm>
+
+NoiseStats NoiseProbe::Measure(double windowMs, double thresholdUs) {
+    NoiseStats s{};
+    s.windowMs = windowMs;
+    s.thresholdUs = thresholdUs;
+    if (windowMs <= 0.0 || thresholdUs <= 0.0) return s;
+
+    const int64_t freq = LatencyMeasurer::TickFrequency();
+    const double usPerTick = 1000000.0 / static_cast<double>(freq);
+    const int64_t threshold = std::max<int64_t>(1, static_cast<int64_t>(thresholdUs / usPerTick));
+    const int64_t window = static_cast<int64_t>(windowMs * 1000.0 / usPerTick);
+
+    // Bucket bounds in ticks, so the loop only compares integers.
+    int64_t bounds[NoiseStats::kBuckets]{};
+    for (int i = 0; i < NoiseStats::kBuckets; i++) bounds[i] = threshold << i;
+
+    int64_t stolen = 0;
+    int64_t maxGap = 0;
+    const int64_t start = LatencyMeasurer::ReadTicks();
+    int64_t last = start;
+    for (;;) {
+        const int64_t now = LatencyMeasurer::ReadTicks();
+        const int64_t gap = now - last;
+        last = now;
+
+        if (gap >= threshold) {
+            s.gaps++;
+            stolen += gap;
+            maxGap = std::max(maxGap, gap);
+            int b = NoiseStats::kBuckets - 1;
+            while (b > 0 && gap < bounds[b]) b--;
+            s.histogram[b]++;
+        }
+        if (now - start >= window) break;
+    }
+
+    const double elapsedUs = static_cast<double>(last - start) * usPerTick;
+    s.stolenUs = static_cast<double>(stolen) * usPerTick;
+    s.maxGapUs = static_cast<double>(maxGap) * usPerTick;
+    if (elapsedUs > 0.0) {
+        s.gapsPerSec = static_cast<double>(s.gaps) * 1000000.0 / elapsedUs;
+        s.stolenFraction = s.stolenUs / elapsedUs;
+    }
+    return s;
+}
+
+double NoiseProbe::BucketUs(const NoiseStats& s, int i) {
+    return s.thresholdUs * static_cast<double>(uint64_t(1) << i);
+}
@@ -0,0 +1,128 @@
+#include "../include/PreciseWaiter.h"
+#include "../include/LatencyMeasurer.h"
+#include "../include/Platform.h"
+#include <algorithm>
+#include <chrono>
+
+// Margin = overshoot envelope * kSafety + kGuardUs. The envelope jumps half
+// way to a larger overshoot at once but decays by 1/64 per sleep, so one
+// lucky wakeup does not shrink it below what the timer usually does.
+static constexpr double kSafety = 1.25;
+static constexpr double kGuardUs = 10.0;
+static constexpr double kGrow = 0.5;
+static constexpr double kDecay = 1.0 / 64.0;
+
+static double UsPerTick() {
+    static const double us = 1000000.0 / static_cast<double>(LatencyMeasurer::TickFrequency());
+    return us;
+}
+
+static double MarginFor(double overshootUs) {
+    return std::min(std::max(overshootUs * kSafety + kGuardUs, PreciseWaiter::kMinMarginUs),
+        PreciseWaiter::kMaxMarginUs);
+}
+
+PreciseWaiter::PreciseWaiter(double overshootUs) {
+    SetMargin(overshootUs);
+}
+
+void PreciseWaiter::SetMargin(double overshootUs) {
+    if (overshootUs <= 0.0) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    overshootUs_ = std::min(overshootUs, kMaxMarginUs);
+}
+
+void PreciseWaiter::Adapt(double overshootUs) {
+    if (overshootUs > overshootUs_) overshootUs_ += (overshootUs - overshootUs_) * kGrow;
+    else overshootUs_ -= (overshootUs_ - overshootUs) * kDecay;
+    overshootUs_ = std::min(overshootUs_, kMaxMarginUs);
+}
+
+void PreciseWaiter::CpuRelax() {
+#if defined(_WIN32)
+    YieldProcessor();
+#elif defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+// Sleeps until `target` (or Interrupt()), adapting the margin from how late
+// each wakeup was. Called with mutex_ held; `now` is updated.
+bool PreciseWaiter::SleepLocked(std::unique_lock<std::mutex>& lock, int64_t target, int64_t& now) {
+    const double usPerTick = UsPerTick();
+    while (now < target) {
+        if (interrupted_.load(std::memory_order_relaxed)) return false;
+
+        const double sleepNs = static_cast<double>(target - now) * usPerTick * 1000.0;
+        cv_.wait_for(lock, std::chrono::nanoseconds(static_cast<int64_t>(sleepNs)));
+        now = LatencyMeasurer::ReadTicks();
+
+        // Early returns are spurious or Interrupt(); only a late one says
+        // anything about the timer.
+        if (now >= target) Adapt(static_cast<double>(now - target) * usPerTick);
+    }
+    return !interrupted_.load(std::memory_order_relaxed);
+}
+
+bool PreciseWaiter::WaitUntil(int64_t deadlineTicks) {
+    const double usPerTick = UsPerTick();
+    const int64_t start = LatencyMeasurer::ReadTicks();
+    int64_t now = start;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    const int64_t target = deadlineTicks - static_cast<int64_t>(MarginFor(overshootUs_) / usPerTick);
+    if (!SleepLocked(lock, target, now)) return false;
+    lock.unlock();
+
+    const int64_t spinStart = now;
+    while (now < deadlineTicks) {
+        if (interrupted_.load(std::memory_order_relaxed)) return false;
+        CpuRelax();
+        now = LatencyMeasurer::ReadTicks();
+    }
+
+    lock.lock();
+    const double lateUs = static_cast<double>(now - deadlineTicks) * usPerTick;
+    stats_.waits++;
+    if (spinStart > deadlineTicks && spinStart > start) stats_.missed++;
+    stats_.sleptUs += static_cast<double>(spinStart - start) * usPerTick;
+    stats_.spunUs += static_cast<double>(now - spinStart) * usPerTick;
+    lateSumUs_ += lateUs;
+    stats_.maxLateUs = std::max(stats_.maxLateUs, lateUs);
+    return true;
+}
+
+bool PreciseWaiter::SleepUntil(int64_t deadlineTicks) {
+    int64_t now = LatencyMeasurer::ReadTicks();
+    std::unique_lock<std::mutex> lock(mutex_);
+    return SleepLocked(lock, deadlineTicks, now);
+}
+
+void PreciseWaiter::Interrupt() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    interrupted_ = true;
+    cv_.notify_all();
+}
+
+void PreciseWaiter::Reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    interrupted_ = false;
+}
+
+WaiterStats PreciseWaiter::Stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    WaiterStats s = stats_;
+    s.marginUs = MarginFor(overshootUs_);
+    const double total = s.sleptUs + s.spunUs;
+    if (total > 0.0) s.spinFraction = s.spunUs / total;
+    if (s.waits) s.avgLateUs = lateSumUs_ / static_cast<double>(s.waits);
+    return s;
+}
+
+void PreciseWaiter::ResetStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_ = WaiterStats{};
+    lateSumUs_ = 0.0;
+}
@@ -0,0 +1,187 @@
+#ifdef _WIN32
+#include "../include/RawInputSource.h"
+#include <algorithm>
+
+RawInputSource::RawInputSource() {
+    h_instance_ = GetModuleHandleW(nullptr);
+
+    // 8-byte aligned, as GetRawInputBuffer requires on 64-bit.
+    batch_buf_.resize((kMaxBatch * sizeof(RAWINPUT) + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+}
+
+RawInputSource::~RawInputSource() {
+    Close();
+}
+
+std::unique_ptr<InputSource> CreateDefaultInputSource() {
+    return std::make_unique<RawInputSource>();
+}
+
+LRESULT CALLBACK RawInputSource::HiddenWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
+    return DefWindowProcW(hwnd, msg, wParam, lParam);
+}
+
+bool RawInputSource::CreateHiddenWindow() {
+    const wchar_t* cls = L"ILO_InputMsgWnd";
+
+    WNDCLASSEXW wc{};
+    wc.cbSize = sizeof(wc);
+    wc.lpfnWndProc = HiddenWndProc;
+    wc.hInstance = h_instance_;
+    wc.lpszClassName = cls;
+
+    RegisterClassExW(&wc);
+
+    hwnd_ = CreateWindowExW(0, cls, L"", 0, 0, 0, 0, 0,
+        HWND_MESSAGE, nullptr, h_instance_, nullptr);
+
+    return hwnd_ != nullptr;
+}
+
+void RawInputSource::DestroyHiddenWindow() {
+    if (hwnd_) {
+        DestroyWindow(hwnd_);
+        hwnd_ = nullptr;
+    }
+}
+
+bool RawInputSource::InitializeRawInput(HWND hwnd) {
+    RAWINPUTDEVICE rid[2]{};
+
+    rid[0].usUsagePage = 0x01;
+    rid[0].usUsage = 0x06; // keyboard
+    rid[0].dwFlags = RIDEV_INPUTSINK;
+    rid[0].hwndTarget = hwnd;
+
+    rid[1].usUsagePage = 0x01;
+    rid[1].usUsage = 0x02; // mouse
+    rid[1].dwFlags = RIDEV_INPUTSINK;
+    rid[1].hwndTarget = hwnd;
+
+    return RegisterRawInputDevices(rid, 2, sizeof(rid[0])) != FALSE;
+}
+
+bool RawInputSource::Open() {
+    wake_requested_ = false;
+
+    // Make sure the thread has a message queue before Wake() can post to it.
+    MSG dummy{};
+    PeekMessageW(&dummy, nullptr, 0, 0, PM_NOREMOVE);
+    thread_id_ = GetCurrentThreadId();
+
+    if (!CreateHiddenWindow()) return false;
+
+    if (!InitializeRawInput(hwnd_)) {
+        DestroyHiddenWindow();
+        return false;
+    }
+
+    return true;
+}
+
+void RawInputSource::Close() {
+    SetIdleTimer(-1);
+    DestroyHiddenWindow();
+    pending_ = nullptr;
+    thread_id_ = 0;
+}
+
+void RawInputSource::SetIdleTimer(int timeoutMs) {
+    if (timeoutMs == idle_timer_ms_) return;
+
+    if (idle_timer_) {
+        KillTimer(nullptr, idle_timer_);
+        idle_timer_ = 0;
+    }
+
+    // Thread timer: WM_TIMER is only generated when the queue is empty, so the
+    // idle tick never competes with WM_INPUT.
+    if (timeoutMs >= 0) idle_timer_ = SetTimer(nullptr, 0, static_cast<UINT>(timeoutMs), nullptr);
+    idle_timer_ms_ = timeoutMs;
+}
+
+InputSource::WaitResult RawInputSource::Wait(int timeoutMs) {
+    SetIdleTimer(timeoutMs);
+
+    MSG msg{};
+    while (!wake_requested_) {
+        if (GetMessageW(&msg, nullptr, 0, 0) <= 0) return WaitResult::Exit;
+
+        if (msg.message == WM_INPUT) {
+            pending_ = reinterpret_cast<HRAWINPUT>(msg.lParam);
+            return WaitResult::Ready;
+        }
+
+        if (msg.message == WM_TIMER && msg.hwnd == nullptr) return WaitResult::Timeout;
+
+        TranslateMessage(&msg);
+        DispatchMessageW(&msg);
+    }
+
+    return WaitResult::Exit;
+}
+
+void RawInputSource::ToInputEvent(const RAWINPUT* ri, InputEvent& ev) {
+    ev = InputEvent{};
+    ev.device = reinterpret_cast<uint64_t>(ri->header.hDevice);
+    ev.type = static_cast<uint16_t>(ri->header.dwType);
+
+    if (ri->header.dwType == RIM_TYPEKEYBOARD) {
+        ev.code = ri->data.keyboard.MakeCode;
+        ev.value = ri->data.keyboard.Flags;
+    } else if (ri->header.dwType == RIM_TYPEMOUSE) {
+        ev.code = ri->data.mouse.usButtonFlags;
+        ev.value = ri->data.mouse.lLastX;
+    }
+}
+
+int RawInputSource::Read(InputEvent* out, int max) {
+    if (!pending_ || max <= 0) return 0;
+
+    HRAWINPUT h = pending_;
+    pending_ = nullptr;
+
+    // One call into the fixed record, no size probe. A HID report too large
+    // for it only needs its header (ToInputEvent reads nothing else).
+    UINT got = sizeof(record_);
+    if (GetRawInputData(h, RID_INPUT, &record_, &got, sizeof(RAWINPUTHEADER)) == static_cast<UINT>(-1)) {
+        got = sizeof(record_.header);
+        if (GetRawInputData(h, RID_HEADER, &record_.header, &got, sizeof(RAWINPUTHEADER)) == static_cast<UINT>(-1)) return 0;
+        if (record_.header.dwType != RIM_TYPEHID) return 0;
+    }
+
+    ToInputEvent(&record_, out[0]);
+    if (max == 1) return 1;
+
+    return 1 + ReadBuffered(out + 1, max - 1);
+}
+
+int RawInputSource::ReadBuffered(InputEvent* out, int max) {
+    // Size the request for `max` of the smallest record (keyboard), so one
+    // call can never return more than fits in `out`. Records that don't fit
+    // stay queued and wake the next Wait().
+    const UINT minRecord = RAWINPUT_ALIGN(sizeof(RAWINPUTHEADER) + sizeof(RAWKEYBOARD));
+    const UINT capacity = static_cast<UINT>(batch_buf_.size() * sizeof(batch_buf_[0]));
+    UINT bytes = std::min<UINT>(capacity, minRecord * static_cast<UINT>(max));
+
+    RAWINPUT* first = reinterpret_cast<RAWINPUT*>(batch_buf_.data());
+    const UINT count = GetRawInputBuffer(first, &bytes, sizeof(RAWINPUTHEADER));
+    if (count == 0 || count == static_cast<UINT>(-1)) return 0;
+
+    const RAWINPUT* ri = first;
+    const int n = std::min<int>(static_cast<int>(count), max);
+    for (int i = 0; i < n; i++) {
+        ToInputEvent(ri, out[i]);
+        ri = NEXTRAWINPUTBLOCK(ri);
+    }
+    return n;
+}
+
+void RawInputSource::Wake() {
+    wake_requested_ = true;
+
+    const DWORD tid = thread_id_;
+    if (tid != 0) PostThreadMessageW(tid, WM_QUIT, 0, 0);
+}
+
+#endif // _WIN32
@@ -0,0 +1,105 @@
+#include "../include/ReplayInputSource.h"
+#include "../include/LatencyMeasurer.h"
+#include <algorithm>
+
+ReplayInputSource::ReplayInputSource(std::string path, double speed, bool loop)
+    : path_(std::move(path)), speed_(std::max(speed, 0.0)), loop_(loop) {
+    frequency_ = LatencyMeasurer::TickFrequency();
+}
+
+ReplayInputSource::~ReplayInputSource() {
+    Close();
+}
+
+bool ReplayInputSource::Open() {
+    wake_requested_ = false;
+    waiter_.Reset();
+
+    if (!trace_.Open(path_) || trace_.Count() == 0) {
+        trace_.Close();
+        return false;
+    }
+
+    replayed_.store(0, std::memory_order_relaxed);
+    Rewind(LatencyMeasurer::ReadTicks());
+    return true;
+}
+
+void ReplayInputSource::Close() {
+    trace_.Close();
+    pos_ = 0;
+}
+
+void ReplayInputSource::Rewind(int64_t now) {
+    pos_ = 0;
+    origin_ticks_ = now;
+}
+
+// Measurer ticks at which record `index` is due.
+int64_t ReplayInputSource::DueTicks(uint64_t index) const {
+    const InputTraceRecord* r = trace_.Records();
+    const uint64_t first = r[0].timestampNs;
+    const uint64_t ts = std::max(r[index].timestampNs, first);
+    const double offsetNs = static_cast<double>(ts - first) / speed_;
+    return origin_ticks_ + static_cast<int64_t>(offsetNs * static_cast<double>(frequency_) / 1e9);
+}
+
+InputSource::WaitResult ReplayInputSource::Wait(int timeoutMs) {
+    const int64_t start = LatencyMeasurer::ReadTicks();
+    const int64_t deadline = timeoutMs < 0 ? INT64_MAX : start + frequency_ * timeoutMs / 1000;
+
+    for (;;) {
+        if (wake_requested_) return WaitResult::Exit;
+
+        const int64_t now = LatencyMeasurer::ReadTicks();
+        if (pos_ >= trace_.Count()) {
+            if (!loop_) return WaitResult::Exit;
+            Rewind(now);
+        }
+
+        if (speed_ == 0.0) return WaitResult::Ready;
+
+        const int64_t due = DueTicks(pos_);
+        if (now >= due) return WaitResult::Ready;
+        if (now >= deadline) return WaitResult::Timeout;
+
+        // Precise up to the next event; the idle timeout can be late.
+        const bool woke = due <= deadline ? waiter_.WaitUntil(due) : waiter_.SleepUntil(deadline);
+        if (!woke) return WaitResult::Exit;
+    }
+}
+
+int ReplayInputSource::Read(InputEvent* out, int max) {
+    const int64_t now = LatencyMeasurer::ReadTicks();
+    const InputTraceRecord* r = trace_.Records();
+    const uint64_t count = trace_.Count();
+
+    int n = 0;
+    while (n < max && pos_ < count) {
+        InputEvent& ev = out[n];
+        ev = InputEvent{};
+
+        if (speed_ != 0.0) {
+            const int64_t due = DueTicks(pos_);
+            if (due > now) break;
+            ev.timestampNs = frequency_ == 1000000000ll
+                ? static_cast<uint64_t>(due)
+                : static_cast<uint64_t>(static_cast<double>(due) * 1e9 / static_cast<double>(frequency_));
+        }
+
+        ev.device = r[pos_].device;
+        ev.type = r[pos_].type;
+        ev.code = r[pos_].code;
+        ev.value = r[pos_].value;
+        pos_++;
+        n++;
+    }
+
+    replayed_.fetch_add(static_cast<uint64_t>(n), std::memory_order_relaxed);
+    return n;
+}
+
+void ReplayInputSource::Wake() {
+    wake_requested_ = true;
+    waiter_.Interrupt();
+}
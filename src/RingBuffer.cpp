@@ -1,2 +1,178 @@
 #include "../include/RingBuffer.h"
-// Template implementation is in header.
+// Template implementation is in header; the SIMD aggregate kernels live here.
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define RB_SIMD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(RB_SIMD_X86) && (defined(__GNUC__) || defined(__clang__))
+#define RB_TARGET_AVX2 __attribute__((target("avx2")))
+#define RB_TARGET_SSE2 __attribute__((target("sse2")))
+#else
+#define RB_TARGET_AVX2
+#define RB_TARGET_SSE2
+#endif
+
+namespace {
+
+struct Kernels {
+    double (*min)(const double*, size_t);
+    double (*max)(const double*, size_t);
+    double (*sum)(const double*, size_t);
+    const char* name;
+};
+
+double MinScalar(const double* p, size_t n) { return *std::min_element(p, p + n); }
+double MaxScalar(const double* p, size_t n) { return *std::max_element(p, p + n); }
+double SumScalar(const double* p, size_t n) { return std::accumulate(p, p + n, 0.0); }
+
+#if defined(RB_SIMD_X86)
+
+RB_TARGET_SSE2 double MinSse2(const double* p, size_t n) {
+    if (n < 2) return MinScalar(p, n);
+    __m128d acc = _mm_loadu_pd(p);
+    size_t i = 2;
+    for (; i + 2 <= n; i += 2) acc = _mm_min_pd(acc, _mm_loadu_pd(p + i));
+    double lanes[2];
+    _mm_storeu_pd(lanes, acc);
+    double m = std::min(lanes[0], lanes[1]);
+    for (; i < n; i++) m = std::min(m, p[i]);
+    return m;
+}
+
+RB_TARGET_SSE2 double MaxSse2(const double* p, size_t n) {
+    if (n < 2) return MaxScalar(p, n);
+    __m128d acc = _mm_loadu_pd(p);
+    size_t i = 2;
+    for (; i + 2 <= n; i += 2) acc = _mm_max_pd(acc, _mm_loadu_pd(p + i));
+    double lanes[2];
+    _mm_storeu_pd(lanes, acc);
+    double m = std::max(lanes[0], lanes[1]);
+    for (; i < n; i++) m = std::max(m, p[i]);
+    return m;
+}
+
+RB_TARGET_SSE2 double SumSse2(const double* p, size_t n) {
+    __m128d a0 = _mm_setzero_pd();
+    __m128d a1 = _mm_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        a0 = _mm_add_pd(a0, _mm_loadu_pd(p + i));
+        a1 = _mm_add_pd(a1, _mm_loadu_pd(p + i + 2));
+    }
+    double lanes[2];
+    _mm_storeu_pd(lanes, _mm_add_pd(a0, a1));
+    double s = lanes[0] + lanes[1];
+    for (; i < n; i++) s += p[i];
+    return s;
+}
+
+RB_TARGET_AVX2 double MinAvx2(const double* p, size_t n) {
+    if (n < 8) return MinScalar(p, n);
+    __m256d a0 = _mm256_loadu_pd(p);
+    __m256d a1 = _mm256_loadu_pd(p + 4);
+    size_t i = 8;
+    for (; i + 8 <= n; i += 8) {
+        a0 = _mm256_min_pd(a0, _mm256_loadu_pd(p + i));
+        a1 = _mm256_min_pd(a1, _mm256_loadu_pd(p + i + 4));
+    }
+    double lanes[4];
+    _mm256_storeu_pd(lanes, _mm256_min_pd(a0, a1));
+    double m = std::min(std::min(lanes[0], lanes[1]), std::min(lanes[2], lanes[3]));
+    for (; i < n; i++) m = std::min(m, p[i]);
+    return m;
+}
+
+RB_TARGET_AVX2 double MaxAvx2(const double* p, size_t n) {
+    if (n < 8) return MaxScalar(p, n);
+    __m256d a0 = _mm256_loadu_pd(p);
+    __m256d a1 = _mm256_loadu_pd(p + 4);
+    size_t i = 8;
+    for (; i + 8 <= n; i += 8) {
+        a0 = _mm256_max_pd(a0, _mm256_loadu_pd(p + i));
+        a1 = _mm256_max_pd(a1, _mm256_loadu_pd(p + i + 4));
+    }
+    double lanes[4];
+    _mm256_storeu_pd(lanes, _mm256_max_pd(a0, a1));
+    double m = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+    for (; i < n; i++) m = std::max(m, p[i]);
+    return m;
+}
+
+RB_TARGET_AVX2 double SumAvx2(const double* p, size_t n) {
+    __m256d a0 = _mm256_setzero_pd();
+    __m256d a1 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        a0 = _mm256_add_pd(a0, _mm256_loadu_pd(p + i));
+        a1 = _mm256_add_pd(a1, _mm256_loadu_pd(p + i + 4));
+    }
+    double lanes[4];
+    _mm256_storeu_pd(lanes, _mm256_add_pd(a0, a1));
+    double s = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    for (; i < n; i++) s += p[i];
+    return s;
+}
+
+bool CpuHasAvx2() {
+#if defined(_MSC_VER)
+    int r[4]{};
+    __cpuid(r, 0);
+    if (r[0] < 7) return false;
+
+    __cpuid(r, 1);
+    const bool osxsave = (r[2] & (1 << 27)) != 0;
+    const bool avx = (r[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx) return false;
+    if ((_xgetbv(0) & 0x6) != 0x6) return false; // OS saves XMM+YMM state
+
+    __cpuidex(r, 7, 0);
+    return (r[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+
+bool CpuHasSse2() {
+#if defined(_M_X64) || defined(__x86_64__)
+    return true; // baseline on x86-64
+#elif defined(_MSC_VER)
+    int r[4]{};
+    __cpuid(r, 1);
+    return (r[3] & (1 << 26)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse2") != 0;
+#endif
+}
+
+#endif // RB_SIMD_X86
+
+Kernels SelectKernels() {
+#if defined(RB_SIMD_X86)
+    if (CpuHasAvx2()) return { MinAvx2, MaxAvx2, SumAvx2, "avx2" };
+    if (CpuHasSse2()) return { MinSse2, MaxSse2, SumSse2, "sse2" };
+#endif
+    return { MinScalar, MaxScalar, SumScalar, "scalar" };
+}
+
+const Kernels& ActiveKernels() {
+    static const Kernels k = SelectKernels();
+    return k;
+}
+
+} // namespace
+
+namespace RingBufferSimd {
+
+double Min(const double* p, size_t n) { return ActiveKernels().min(p, n); }
+double Max(const double* p, size_t n) { return ActiveKernels().max(p, n); }
+double Sum(const double* p, size_t n) { return ActiveKernels().sum(p, n); }
+const char* KernelName() { return ActiveKernels().name; }
+
+} // namespace RingBufferSimd
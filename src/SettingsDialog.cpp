@@ -154,36 +154,13 @@ void SettingsDialog::ShowModeMenu() {
     UpdateModeButtonText();
 }
 
+// ComputeConfig resolves Recommend itself (DeviceTuner::RecommendedMode).
 InputThread::Config SettingsDialog::ConfigForMode(Mode mode) {
-    if (mode == Mode::Recommend) {
-        const auto p = DeviceTuner::CollectProfile();
-        const ULONGLONG ramGB = p.ramBytes / (1024ull * 1024ull * 1024ull);
-        const bool strongCPU = (p.logicalProcessors >= 8) || (p.cpuMHz >= 3200);
-
-        Mode resolved = Mode::Light;
-        if (!p.onBattery) {
-            if (strongCPU && ramGB >= 16) resolved = Mode::Max;
-            else if (p.logicalProcessors >= 4 && ramGB >= 8) resolved = Mode::Medium;
-            else resolved = Mode::Light;
-        } else {
-            resolved = Mode::Light;
-        }
-
-        return DeviceTuner::ComputeConfigCached(resolved);
-    }
-
     return DeviceTuner::ComputeConfigCached(mode);
 }
 
 SettingsDialog::Mode SettingsDialog::RecommendModeForDevice() const {
-    const auto& p = DeviceTuner::CollectProfile();
-    const ULONGLONG ramGB = p.ramBytes / (1024ull * 1024ull * 1024ull);
-    const bool strongCPU = (p.logicalProcessors >= 8) || (p.cpuMHz >= 3200);
-
-    if (p.onBattery) return Mode::Light;
-    if (strongCPU && ramGB >= 16) return Mode::Max;
-    if (p.logicalProcessors >= 4 && ramGB >= 8) return Mode::Medium;
-    return Mode::Light;
+    return DeviceTuner::RecommendedMode(DeviceTuner::CollectProfile());
 }
 
 void SettingsDialog::ApplyMode(Mode mode) {
@@ -197,7 +174,8 @@ void SettingsDialog::ApplyMode(Mode mode) {
     }
 
     applied_mode_ = mode;
-    input_thread_.GetMeasurer().Reset();
+    input_thread_.GetMeasurer().RequestReset();
+    input_thread_.GetDeviceStats().RequestReset();
 
     // Persist backup of applied tuning
     ConfigStore::SaveApplied(static_cast<DWORD>(mode), cfg, true);
@@ -206,15 +184,7 @@ void SettingsDialog::ApplyMode(Mode mode) {
     wchar_t shown[64]{};
     if (mode == Mode::Recommend) {
         // Show resolved tier for clarity
-        const auto p = DeviceTuner::CollectProfile();
-        const ULONGLONG ramGB = p.ramBytes / (1024ull * 1024ull * 1024ull);
-        const bool strongCPU = (p.logicalProcessors >= 8) || (p.cpuMHz >= 3200);
-        const wchar_t* resolved = L"Nhẹ";
-        if (!p.onBattery) {
-            if (strongCPU && ramGB >= 16) resolved = L"Tối đa";
-            else if (p.logicalProcessors >= 4 && ramGB >= 8) resolved = L"Trung Bình";
-            else resolved = L"Nhẹ";
-        }
+        const wchar_t* resolved = ModeToText(RecommendModeForDevice());
         StringCchPrintfW(shown, _countof(shown), L"%s -> %s", modeText, resolved);
         modeText = shown;
     }
@@ -224,7 +194,7 @@ void SettingsDialog::ApplyMode(Mode mode) {
         L"Applied: %s | Boost:%s | Aff:%s | Proc:%s | Thr:%s",
         modeText,
         cfg.enableTimerBoost ? L"ON" : L"OFF",
-        (cfg.enableAffinity && cfg.affinityMask) ? L"ON" : L"OFF",
+        (cfg.enableAffinity && !cfg.affinity.Empty()) ? L"ON" : L"OFF",
         cfg.enableProcessPriority ? L"ON" : L"OFF",
         cfg.enableThreadPriority ? L"ON" : L"OFF");
     UpdateStatus(s);
@@ -253,7 +223,8 @@ void SettingsDialog::LoadSettings() {
         if (!input_thread_.IsRunning()) input_thread_.Start(cfg);
         else input_thread_.UpdateConfig(cfg);
 
-        input_thread_.GetMeasurer().Reset();
+        input_thread_.GetMeasurer().RequestReset();
+        input_thread_.GetDeviceStats().RequestReset();
         UpdateStatus(L"Running (loaded).");
     } else {
         UpdateStatus(L"Idle (not applied).");
@@ -0,0 +1,453 @@
+#ifdef __linux__
+#include "../include/UringInputSource.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <linux/input.h>
+#include <linux/io_uring.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+
+// Newer than some installed UAPI headers.
+static constexpr uint8_t kOpReadMultishot = 49; // IORING_OP_READ_MULTISHOT (6.7)
+
+// user_data of the wake eventfd poll; device reads use their index.
+static constexpr uint64_t kWakeTag = ~0ull;
+
+static constexpr unsigned kSqEntries = 128;
+static constexpr unsigned kCqEntries = 1024;
+static constexpr unsigned kBufferEvents = 64;
+static constexpr size_t kBufferBytes = kBufferEvents * sizeof(input_event);
+static constexpr unsigned kProvidedBuffers = 256; // power of two, shared by all fds
+static constexpr uint16_t kBufferGroup = 0;
+
+static int UringSetup(unsigned entries, io_uring_params* p) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, p));
+}
+
+static int UringEnter(int fd, unsigned submit, unsigned minComplete, unsigned flags, const void* arg, size_t argSize) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, submit, minComplete, flags, arg, argSize));
+}
+
+static int UringRegister(int fd, unsigned op, const void* arg, unsigned n) {
+    return static_cast<int>(syscall(__NR_io_uring_register, fd, op, arg, n));
+}
+
+static void* MapAnonymous(size_t size) {
+    void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    return p == MAP_FAILED ? nullptr : p;
+}
+
+static bool SupportsOp(int ringFd, uint8_t op) {
+    std::vector<unsigned char> mem(sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op));
+    io_uring_probe* probe = reinterpret_cast<io_uring_probe*>(mem.data());
+    if (UringRegister(ringFd, IORING_REGISTER_PROBE, probe, 256) != 0) return false;
+    return op <= probe->last_op && (probe->ops[op].flags & IO_URING_OP_SUPPORTED);
+}
+
+UringInputSource::UringInputSource() : scan_(true) {
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+}
+
+UringInputSource::UringInputSource(std::vector<std::string> paths)
+    : paths_(std::move(paths)), fallback_(paths_) {
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+}
+
+UringInputSource::UringInputSource(const std::vector<int>& fds) : external_fds_(fds), fallback_(fds) {
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+}
+
+UringInputSource::~UringInputSource() {
+    Close();
+    if (wake_fd_ >= 0) close(wake_fd_);
+}
+
+const wchar_t* UringInputSource::Name() const {
+    switch (mode_.load(std::memory_order_relaxed)) {
+    case Mode::Multishot: return L"evdev io_uring, multishot";
+    case Mode::FixedReads: return L"evdev io_uring, fixed reads";
+    case Mode::Epoll: return L"evdev epoll, io_uring unavailable";
+    default: return L"evdev io_uring";
+    }
+}
+
+size_t UringInputSource::DeviceCount() const {
+    return mode_ == Mode::Epoll ? fallback_.DeviceCount() : devices_.size();
+}
+
+uint64_t UringInputSource::SyscallCount() const {
+    return syscalls_ + fallback_.SyscallCount();
+}
+
+bool UringInputSource::MapRing(const io_uring_params& p) {
+    sq_map_size_ = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    cq_map_size_ = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+    const bool single = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single) sq_map_size_ = cq_map_size_ = std::max(sq_map_size_, cq_map_size_);
+
+    void* sq = mmap(nullptr, sq_map_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+    if (sq == MAP_FAILED) return false;
+    sq_map_ = sq;
+
+    if (single) {
+        cq_map_ = sq_map_;
+    } else {
+        void* cq = mmap(nullptr, cq_map_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_CQ_RING);
+        if (cq == MAP_FAILED) return false;
+        cq_map_ = cq;
+    }
+
+    sqes_size_ = p.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) return false;
+    sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+    unsigned char* s = static_cast<unsigned char*>(sq_map_);
+    sq_head_ = reinterpret_cast<unsigned*>(s + p.sq_off.head);
+    sq_tail_ = reinterpret_cast<unsigned*>(s + p.sq_off.tail);
+    sq_array_ = reinterpret_cast<unsigned*>(s + p.sq_off.array);
+    sq_mask_ = *reinterpret_cast<unsigned*>(s + p.sq_off.ring_mask);
+    sq_entries_ = p.sq_entries;
+    sq_local_tail_ = *sq_tail_;
+
+    unsigned char* c = static_cast<unsigned char*>(cq_map_);
+    cq_head_ = reinterpret_cast<unsigned*>(c + p.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(c + p.cq_off.tail);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(c + p.cq_off.cqes);
+    cq_mask_ = *reinterpret_cast<unsigned*>(c + p.cq_off.ring_mask);
+    return true;
+}
+
+bool UringInputSource::SetupRing() {
+    io_uring_params p{};
+    p.flags = IORING_SETUP_CQSIZE;
+    p.cq_entries = kCqEntries;
+    ring_fd_ = UringSetup(kSqEntries, &p);
+    if (ring_fd_ < 0) return false;
+
+    // EXT_ARG (5.11) carries Wait()'s timeout into io_uring_enter().
+    if (!(p.features & IORING_FEAT_EXT_ARG) || !MapRing(p)) return false;
+    return true;
+}
+
+// Multishot: one shared ring of provided buffers (5.19+). Otherwise one
+// registered buffer per device for READ_FIXED.
+bool UringInputSource::SetupBuffers(bool multishot) {
+    const size_t count = multishot ? kProvidedBuffers : devices_.size();
+    buffers_size_ = count * kBufferBytes;
+    buffers_ = static_cast<unsigned char*>(MapAnonymous(buffers_size_));
+    if (!buffers_) return false;
+
+    if (!multishot) {
+        std::vector<iovec> iov(count);
+        for (size_t i = 0; i < count; i++) iov[i] = iovec{ buffers_ + i * kBufferBytes, kBufferBytes };
+        return UringRegister(ring_fd_, IORING_REGISTER_BUFFERS, iov.data(), static_cast<unsigned>(count)) == 0;
+    }
+
+    buf_ring_size_ = kProvidedBuffers * sizeof(io_uring_buf);
+    buf_ring_ = static_cast<io_uring_buf*>(MapAnonymous(buf_ring_size_));
+    if (!buf_ring_) return false;
+
+    io_uring_buf_reg reg{};
+    reg.ring_addr = reinterpret_cast<uint64_t>(buf_ring_);
+    reg.ring_entries = kProvidedBuffers;
+    reg.bgid = kBufferGroup;
+    if (UringRegister(ring_fd_, IORING_REGISTER_PBUF_RING, &reg, 1) != 0) return false;
+
+    buf_tail_ = 0;
+    for (unsigned bid = 0; bid < kProvidedBuffers; bid++) ReturnBuffer(static_cast<int>(bid));
+    return true;
+}
+
+// The ring is addressed as plain io_uring_buf entries: the header's
+// io_uring_buf_ring flex array member lands 8 bytes late when compiled as
+// C++. Its tail overlays bufs[0].resv.
+void UringInputSource::ReturnBuffer(int bid) {
+    io_uring_buf& b = buf_ring_[buf_tail_ & (kProvidedBuffers - 1)];
+    b.addr = reinterpret_cast<uint64_t>(buffers_ + static_cast<size_t>(bid) * kBufferBytes);
+    b.len = static_cast<uint32_t>(kBufferBytes);
+    b.bid = static_cast<uint16_t>(bid);
+    buf_tail_++;
+    __atomic_store_n(&buf_ring_[0].resv, buf_tail_, __ATOMIC_RELEASE);
+}
+
+void UringInputSource::TeardownRing() {
+    // Closing the ring cancels every posted read.
+    if (ring_fd_ >= 0) close(ring_fd_);
+    ring_fd_ = -1;
+
+    if (sqes_) munmap(sqes_, sqes_size_);
+    if (cq_map_ && cq_map_ != sq_map_) munmap(cq_map_, cq_map_size_);
+    if (sq_map_) munmap(sq_map_, sq_map_size_);
+    if (buf_ring_) munmap(buf_ring_, buf_ring_size_);
+    if (buffers_) munmap(buffers_, buffers_size_);
+    sqes_ = nullptr;
+    cq_map_ = sq_map_ = nullptr;
+    buf_ring_ = nullptr;
+    buffers_ = nullptr;
+    sq_pending_ = 0;
+}
+
+bool UringInputSource::Open() {
+    Close();
+    if (wake_fd_ < 0) return false;
+
+    // Clear a wake left over from a previous run.
+    uint64_t drained = 0;
+    while (read(wake_fd_, &drained, sizeof(drained)) > 0) {}
+
+    if (!SetupRing()) {
+        TeardownRing();
+        mode_ = Mode::Epoll;
+        return fallback_.Open();
+    }
+
+    std::vector<std::string> paths = paths_;
+    if (scan_) paths = EvdevInputSource::ScanDevices();
+    for (const std::string& path : paths) {
+        const int fd = open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+        if (fd < 0) continue;
+        EvdevInputSource::UseMonotonicStamps(fd);
+        devices_.push_back(Device{ fd, true });
+    }
+    for (int fd : external_fds_) {
+        const int flags = fcntl(fd, F_GETFL);
+        if (flags >= 0) fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+        EvdevInputSource::UseMonotonicStamps(fd);
+        devices_.push_back(Device{ fd, false });
+    }
+    if (devices_.empty()) {
+        TeardownRing();
+        return false;
+    }
+
+    const bool multishot = SupportsOp(ring_fd_, kOpReadMultishot);
+    if (!SetupBuffers(multishot)) {
+        Close();
+        mode_ = Mode::Epoll;
+        return fallback_.Open();
+    }
+    mode_ = multishot ? Mode::Multishot : Mode::FixedReads;
+
+    PostWakePoll();
+    for (size_t i = 0; i < devices_.size(); i++) PostRead(i);
+    if (Enter(0, 0) < 0) {
+        Close();
+        mode_ = Mode::Epoll;
+        return fallback_.Open();
+    }
+    return true;
+}
+
+void UringInputSource::Close() {
+    if (mode_ == Mode::Epoll) fallback_.Close();
+    TeardownRing();
+
+    for (Device& d : devices_) {
+        if (d.owned && d.fd >= 0) close(d.fd);
+    }
+    devices_.clear();
+    chunk_ = Chunk{};
+    wake_seen_ = false;
+    mode_ = Mode::Closed;
+}
+
+io_uring_sqe* UringInputSource::NextSqe() {
+    // Full: hand what is queued to the kernel first.
+    if (sq_local_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) >= sq_entries_) Enter(0, 0);
+
+    const unsigned idx = sq_local_tail_ & sq_mask_;
+    sq_array_[idx] = idx;
+    io_uring_sqe* sqe = &sqes_[idx];
+    std::memset(sqe, 0, sizeof(*sqe));
+    sq_local_tail_++;
+    sq_pending_++;
+    return sqe;
+}
+
+void UringInputSource::PostWakePoll() {
+    io_uring_sqe* sqe = NextSqe();
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = wake_fd_;
+    sqe->poll32_events = POLLIN;
+    sqe->user_data = kWakeTag;
+}
+
+void UringInputSource::PostRead(size_t device) {
+    const Device& d = devices_[device];
+    if (d.fd < 0) return;
+
+    io_uring_sqe* sqe = NextSqe();
+    sqe->fd = d.fd;
+    sqe->user_data = device;
+    if (mode_ == Mode::Multishot) {
+        sqe->opcode = kOpReadMultishot;
+        sqe->flags = IOSQE_BUFFER_SELECT;
+        sqe->buf_group = kBufferGroup;
+    } else {
+        sqe->opcode = IORING_OP_READ_FIXED;
+        sqe->addr = reinterpret_cast<uint64_t>(buffers_ + device * kBufferBytes);
+        sqe->len = static_cast<uint32_t>(kBufferBytes);
+        sqe->buf_index = static_cast<uint16_t>(device);
+    }
+}
+
+// Submits the queued SQEs and, with minComplete, waits for completions in
+// the same call. Returns the io_uring_enter() result.
+int UringInputSource::Enter(unsigned minComplete, int timeoutMs) {
+    __atomic_store_n(sq_tail_, sq_local_tail_, __ATOMIC_RELEASE);
+
+    unsigned flags = 0;
+    io_uring_getevents_arg arg{};
+    __kernel_timespec ts{};
+    if (minComplete) {
+        flags = IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+        arg.sigmask_sz = _NSIG / 8;
+        if (timeoutMs >= 0) {
+            ts.tv_sec = timeoutMs / 1000;
+            ts.tv_nsec = static_cast<long long>(timeoutMs % 1000) * 1000000ll;
+            arg.ts = reinterpret_cast<uint64_t>(&ts);
+        }
+    }
+
+    const int r = UringEnter(ring_fd_, sq_pending_, minComplete, flags, minComplete ? &arg : nullptr,
+        minComplete ? sizeof(arg) : 0);
+    syscalls_++;
+    if (r > 0) sq_pending_ -= std::min<unsigned>(static_cast<unsigned>(r), sq_pending_);
+    return r;
+}
+
+bool UringInputSource::CqReady() const {
+    return *cq_head_ != __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+}
+
+InputSource::WaitResult UringInputSource::Wait(int timeoutMs) {
+    if (mode_ == Mode::Epoll) return fallback_.Wait(timeoutMs);
+    if (mode_ == Mode::Closed || wake_seen_) return WaitResult::Exit;
+    if (chunk_.pos < chunk_.count || CqReady()) return WaitResult::Ready;
+
+    // Polling: re-arms still need submitting, completions do not need a call.
+    if (timeoutMs == 0) {
+        if (sq_pending_) Enter(0, 0);
+        return CqReady() ? WaitResult::Ready : WaitResult::Timeout;
+    }
+
+    for (;;) {
+        if (Enter(1, timeoutMs) < 0) {
+            if (errno == EINTR) continue;
+            if (errno == ETIME) return CqReady() ? WaitResult::Ready : WaitResult::Timeout;
+            // EBUSY/EAGAIN: completions overflowed, reap them first.
+            if (errno != EBUSY && errno != EAGAIN) return WaitResult::Exit;
+        }
+        return CqReady() ? WaitResult::Ready : WaitResult::Timeout;
+    }
+}
+
+// Takes the next completion off the CQ into chunk_. False when the CQ is
+// empty or a wake arrived.
+bool UringInputSource::NextChunk() {
+    while (CqReady()) {
+        const unsigned head = *cq_head_;
+        const io_uring_cqe cqe = cqes_[head & cq_mask_];
+        __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+
+        if (cqe.user_data == kWakeTag) {
+            wake_seen_ = true;
+            return false;
+        }
+
+        const size_t idx = static_cast<size_t>(cqe.user_data);
+        const bool more = (cqe.flags & IORING_CQE_F_MORE) != 0;
+        const int bid = (cqe.flags & IORING_CQE_F_BUFFER) ? static_cast<int>(cqe.flags >> IORING_CQE_BUFFER_SHIFT) : -1;
+
+        if (idx >= devices_.size() || devices_[idx].fd < 0) {
+            if (bid >= 0) ReturnBuffer(bid);
+            continue;
+        }
+
+        if (cqe.res > 0) {
+            chunk_ = Chunk{};
+            chunk_.device = idx;
+            chunk_.count = cqe.res / static_cast<int>(sizeof(input_event));
+            chunk_.buffer = bid;
+            chunk_.rearm = mode_ == Mode::FixedReads || !more;
+            chunk_.data = mode_ == Mode::Multishot
+                ? buffers_ + static_cast<size_t>(bid) * kBufferBytes
+                : buffers_ + idx * kBufferBytes;
+            if (chunk_.count > 0) return true;
+            FinishChunk();
+            continue;
+        }
+
+        if (bid >= 0) ReturnBuffer(bid);
+        // ENOBUFS: every provided buffer was queued for us; they are back by
+        // the time this completion is reaped. 0 (EOF) or ENODEV: unplugged.
+        if (cqe.res == -ENOBUFS || cqe.res == -EAGAIN || cqe.res == -EINTR) {
+            if (!more) PostRead(idx);
+        } else if (!more) {
+            DropDevice(idx);
+        }
+    }
+    return false;
+}
+
+void UringInputSource::FinishChunk() {
+    if (chunk_.buffer >= 0) ReturnBuffer(chunk_.buffer);
+    if (chunk_.rearm) PostRead(chunk_.device);
+    chunk_ = Chunk{};
+}
+
+void UringInputSource::DropDevice(size_t index) {
+    Device& d = devices_[index];
+    if (d.fd < 0) return;
+    if (d.owned) close(d.fd);
+    d.fd = -1;
+}
+
+int UringInputSource::Read(InputEvent* out, int max) {
+    if (mode_ == Mode::Epoll) return fallback_.Read(out, max);
+    if (mode_ == Mode::Closed) return -1;
+
+    int total = 0;
+    while (total < max) {
+        if (chunk_.pos >= chunk_.count && !NextChunk()) break;
+
+        const input_event* raw = reinterpret_cast<const input_event*>(chunk_.data);
+        const int fd = devices_[chunk_.device].fd;
+        const int n = std::min(max - total, chunk_.count - chunk_.pos);
+        for (int i = 0; i < n; i++) {
+            const input_event& r = raw[chunk_.pos + i];
+            InputEvent& ev = out[total + i];
+            ev.timestampNs = static_cast<uint64_t>(r.input_event_sec) * 1000000000ull +
+                static_cast<uint64_t>(r.input_event_usec) * 1000ull;
+            ev.device = static_cast<uint64_t>(fd);
+            ev.type = r.type;
+            ev.code = r.code;
+            ev.value = r.value;
+        }
+        chunk_.pos += n;
+        total += n;
+
+        if (chunk_.pos >= chunk_.count) FinishChunk();
+    }
+    return total;
+}
+
+void UringInputSource::Wake() {
+    const uint64_t one = 1;
+    if (wake_fd_ >= 0) {
+        ssize_t r = write(wake_fd_, &one, sizeof(one));
+        (void)r;
+    }
+    fallback_.Wake();
+}
+
+#endif // __linux__
@@ -27,6 +27,9 @@ static std::condition_variable g_cv;
 
 static HWND g_hwndMain = nullptr;
 
+// Posted by the DeviceTuner worker when it publishes a refined calibration.
+static constexpr UINT WM_CALIBRATION_REFINED = WM_APP + 2;
+
 static bool InitializeApplication(HINSTANCE hInstance);
 static void CleanupApplication();
 static LRESULT CALLBACK MainWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
@@ -53,6 +56,26 @@ static void StartIfEnabledFromStore() {
     else g_inputThread.UpdateConfig(cfg);
 }
 
+// Re-applies the stored mode when a refined calibration changes what it
+// recommends (e.g. affinity now helps). Runs on the UI thread.
+static void ApplyRefinedCalibration() {
+    StoredConfig s{};
+    if (!ConfigStore::Load(s) || !s.enabled || !g_inputThread.ShouldBeRunning()) return;
+
+    const CalibrationResult c = DeviceTuner::Calibration();
+    const InputThread::Config current = g_inputThread.GetConfig();
+    InputThread::Config refined = DeviceTuner::ComputeConfig(static_cast<TuningMode>(s.appliedMode), DeviceTuner::Profile(), c);
+
+    // The affinity stage arrives before the timer boost is measured: pin the
+    // thread now, but keep (and don't persist) the rest until it completes.
+    if (!c.measured) refined = DeviceTuner::ApplyPartialCalibration(current, refined);
+    if (DeviceTuner::SameCalibratedSettings(current, refined)) return;
+
+    g_inputThread.UpdateConfig(refined);
+    if (c.measured) ConfigStore::SaveApplied(s.appliedMode, refined, true);
+    if (g_settingsDialog) g_settingsDialog->UpdateStatus(L"Calibration refined: tuning re-applied.");
+}
+
 static void WatchdogThread() {
     while (g_running) {
         std::unique_lock<std::mutex> lock(g_mutex);
@@ -76,6 +99,13 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE, PWSTR, int) {
 
     if (!InitializeApplication(hInstance)) return 1;
 
+    // Calibration runs in the background; the input thread starts now with
+    // the stored (or profile-only) config and is re-tuned as results arrive.
+    DeviceTuner::SetCalibrationListener([](const CalibrationResult&) {
+        PostMessageW(g_hwndMain, WM_CALIBRATION_REFINED, 0, 0);
+    });
+    DeviceTuner::EnsureCached();
+
     // Start optimizer without showing UI if previously enabled
     StartIfEnabledFromStore();
 
@@ -121,6 +151,8 @@ static bool InitializeApplication(HINSTANCE hInstance) {
 }
 
 static void CleanupApplication() {
+    DeviceTuner::SetCalibrationListener(nullptr);
+    DeviceTuner::StopCalibration();
     g_inputThread.Stop();
 
     if (g_trayIcon) {
@@ -168,6 +200,10 @@ static LRESULT CALLBACK MainWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM l
         }
         break;
 
+    case WM_CALIBRATION_REFINED:
+        ApplyRefinedCalibration();
+        break;
+
     case WM_DESTROY:
         PostQuitMessage(0);
         break;
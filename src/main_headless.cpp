@@ -0,0 +1,386 @@
+#ifndef _WIN32
+// Headless entry point for Linux: runs the input thread on evdev and prints
+// the status block periodically. No tray, no registry.
+#include "../include/InputThread.h"
+#include "../include/CpuTopology.h"
+#include "../include/DeviceTuner.h"
+#include "../include/CalibrationCache.h"
+#include "../include/EvdevInputSource.h"
+#include "../include/InputTrace.h"
+#include "../include/ReplayInputSource.h"
+#include "../include/UringInputSource.h"
+#include <signal.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+static std::atomic<bool> g_stop{false};
+
+static void OnSignal(int) { g_stop = true; }
+
+// Tees every event the input thread reads into an .ilotrace for later replay.
+class CaptureInputSource : public InputSource {
+public:
+    CaptureInputSource(std::unique_ptr<InputSource> inner, InputTraceWriter& writer)
+        : inner_(std::move(inner)), writer_(writer) {}
+
+    const wchar_t* Name() const override { return inner_->Name(); }
+    bool Open() override { return inner_->Open(); }
+    void Close() override { inner_->Close(); }
+    WaitResult Wait(int timeoutMs) override { return inner_->Wait(timeoutMs); }
+    void Wake() override { inner_->Wake(); }
+    PreciseWaiter* Waiter() override { return inner_->Waiter(); }
+
+    int Read(InputEvent* out, int max) override {
+        const int n = inner_->Read(out, max);
+        if (n > 0) writer_.Append(out, static_cast<size_t>(n));
+        return n;
+    }
+
+private:
+    std::unique_ptr<InputSource> inner_;
+    InputTraceWriter& writer_;
+};
+
+static bool ParseSched(const std::string& spec, InputThread::Config& cfg) {
+    const size_t colon = spec.find(':');
+    const std::string name = spec.substr(0, colon);
+    const std::string args = colon == std::string::npos ? std::string() : spec.substr(colon + 1);
+
+    if (name == "other") cfg.schedPolicy = InputThread::SchedPolicy::Other;
+    else if (name == "fifo") cfg.schedPolicy = InputThread::SchedPolicy::Fifo;
+    else if (name == "rr") cfg.schedPolicy = InputThread::SchedPolicy::RoundRobin;
+    else if (name == "deadline") cfg.schedPolicy = InputThread::SchedPolicy::Deadline;
+    else return false;
+
+    if (!args.empty()) {
+        if (cfg.schedPolicy == InputThread::SchedPolicy::Deadline) {
+            unsigned runtime = 0, deadline = 0, period = 0;
+            if (std::sscanf(args.c_str(), "%u/%u/%u", &runtime, &deadline, &period) != 3) return false;
+            cfg.deadlineRuntimeUs = runtime;
+            cfg.deadlineDeadlineUs = deadline;
+            cfg.deadlinePeriodUs = period;
+        } else {
+            cfg.schedPriority = std::atoi(args.c_str());
+        }
+    }
+
+    cfg.enableThreadPriority = true;
+    return true;
+}
+
+static bool ApplyMode(const std::string& mode, InputThread::Config& cfg) {
+    cfg.enableThreadPriority = true;
+    if (mode == "light") {
+        cfg.threadPriority = THREAD_PRIORITY_HIGHEST;
+        cfg.schedPolicy = InputThread::SchedPolicy::RoundRobin;
+        cfg.schedPriority = 10;
+    } else if (mode == "medium") {
+        cfg.threadPriority = THREAD_PRIORITY_HIGHEST;
+        cfg.schedPolicy = InputThread::SchedPolicy::Fifo;
+        cfg.schedPriority = 50;
+        cfg.enableTimerBoost = true;
+    } else if (mode == "max" || mode == "max+") {
+        cfg.threadPriority = THREAD_PRIORITY_TIME_CRITICAL;
+        cfg.schedPolicy = InputThread::SchedPolicy::Fifo;
+        cfg.schedPriority = 80;
+        cfg.enableProcessPriority = true;
+        cfg.enableTimerBoost = true;
+        cfg.enableBusyPoll = (mode == "max+");
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Prints what DeviceTuner sees and measures on this machine.
+static void PrintCalibration() {
+    const CalibrationResult c = DeviceTuner::WaitForCalibration();
+    const DeviceProfile p = DeviceTuner::Profile();
+    const CpuTopology topo = CpuTopology::Detect();
+
+    std::printf("Profile: %u CPUs, %u MHz, %llu MB RAM%s\n",
+        p.logicalProcessors, p.cpuMHz, static_cast<unsigned long long>(p.ramBytes >> 20),
+        p.onBattery ? ", on battery" : (p.hasBattery ? ", on AC" : ""));
+    std::printf("Topology: %s\n", topo.Summary().c_str());
+    for (uint32_t index : topo.Candidates(topo.Cpus().size())) {
+        std::printf("  %s\n", topo.Describe(index).c_str());
+    }
+
+    const auto verdict = [](const GainEstimate& g) {
+        return g.verdict > 0 ? "helps" : (g.verdict < 0 ? "no gain" : "undecided, treated as no gain");
+    };
+    std::printf("Timer boost: p95 overshoot %.0f us -> %.0f us, gain %.0f..%.0f us at %.0f%% (%s, %.0f%% confident, %d samples)\n",
+        c.sleepP95OvershootUs_NoBoost, c.sleepP95OvershootUs_Boost,
+        c.timerBoost.lowUs, c.timerBoost.highUs, DeviceTuner::kRequiredConfidence * 100.0,
+        verdict(c.timerBoost), c.timerBoost.confidence * 100.0, c.boostSamples);
+    if (c.bestCpu >= 0) {
+        std::printf("Affinity: %s (%s)\n", c.affinityReason.c_str(), verdict(c.affinity));
+    } else {
+        std::printf("Affinity: not probed (fewer than two usable CPUs)\n");
+    }
+    for (const CoreCalibration& core : c.cores) {
+        const OvershootStats& o = core.overshoot;
+        if (!core.probed) std::printf("  cpu %d: skipped, settled by an earlier wave\n", core.cpu);
+        else if (o.samples == 0) std::printf("  cpu %d: not pinnable\n", core.cpu);
+        else std::printf("  cpu %d: overshoot p50 %.0f / p95 %.0f / p99 %.0f / max %.0f us (%d samples)\n",
+            core.cpu, o.p50Us, o.p95Us, o.p99Us, o.maxUs, o.samples);
+        if (core.noise.cpu >= 0) {
+            std::printf("          noise %.0f gaps/s, %.3f%% stolen, max gap %.0f us\n",
+                core.noise.gapsPerSec, core.noise.stolenFraction * 100.0, core.noise.maxGapUs);
+        }
+    }
+    std::printf("Calibration: %zu cores in %d wave%s, %.0f ms",
+        c.cores.size(), c.probeWaves, c.probeWaves == 1 ? "" : "s", c.calibrationMs);
+    if (c.fromCache) {
+        std::printf(" (cached, measured %.1f h ago)",
+            static_cast<double>(CalibrationCache::Now() - c.measuredAt) / 3600.0);
+    }
+    std::printf("\n");
+}
+
+// Spins NoiseProbe on every allowed CPU and prints what interrupts them.
+static void PrintNoise(double windowMs, double thresholdUs) {
+    const CpuTopology topo = CpuTopology::Detect();
+    std::vector<uint32_t> cpus;
+    for (const LogicalCpu& c : topo.Cpus()) {
+        if (c.allowed) cpus.push_back(c.index);
+    }
+
+    std::printf("Noise: %.0f ms window, gaps >= %.1f us\n", windowMs, thresholdUs);
+    const std::vector<NoiseStats> all = DeviceTuner::MeasureNoise(topo, cpus, windowMs, thresholdUs);
+    for (size_t i = 0; i < all.size(); i++) {
+        const NoiseStats& n = all[i];
+        if (n.cpu < 0) {
+            std::printf("  cpu %u: not pinnable\n", cpus[i]);
+            continue;
+        }
+        std::printf("  cpu %d: %llu gaps (%.0f/s), stolen %.0f us (%.3f%%), max %.0f us\n",
+            n.cpu, static_cast<unsigned long long>(n.gaps), n.gapsPerSec, n.stolenUs,
+            n.stolenFraction * 100.0, n.maxGapUs);
+        for (int b = 0; b < NoiseStats::kBuckets; b++) {
+            if (n.histogram[b] == 0) continue;
+            std::printf("    >= %6.0f us: %llu\n", NoiseProbe::BucketUs(n, b),
+                static_cast<unsigned long long>(n.histogram[b]));
+        }
+    }
+}
+
+static void Usage(const char* argv0) {
+    std::fprintf(stderr,
+        "usage: %s [options]\n"
+        "  -d, --device PATH     evdev node to read (repeatable; default: all /dev/input/event*)\n"
+        "      --io NAME         epoll | uring: how evdev is read (default: epoll; uring\n"
+        "                        falls back to epoll where io_uring is unavailable)\n"
+        "  -t, --duration SEC    stop after SEC seconds (default: run until SIGINT)\n"
+        "  -i, --interval SEC    status print interval (default: 1)\n"
+        "  -a, --affinity MASK   pin the input thread (hex CPU mask, any width)\n"
+        "      --cpus LIST       pin the input thread to a CPU list (\"2,4-7\")\n"
+        "  -b, --backend NAME    ring | histogram | sketch (default: histogram)\n"
+        "  -r, --replay FILE     read events from an .ilotrace instead of evdev\n"
+        "  -s, --speed X         replay speed: 1 = recorded timing, N = N times faster,\n"
+        "                        0 = as fast as possible (default: 1)\n"
+        "      --loop            restart the replay at the end of the trace\n"
+        "  -c, --capture FILE    write every event read to an .ilotrace\n"
+        "  -R, --record FILE     record per-event latency to an .ilorec (see ilo_rec)\n"
+        "  -m, --mode NAME       light | medium | max: thread/process priority as the tray modes set it;\n"
+        "                        max+ adds --busy-poll. On battery the modes drop the timer\n"
+        "                        boost, pinning, process priority and busy polling\n"
+        "      --sched SPEC      input thread policy: other | fifo[:PRIO] | rr[:PRIO] |\n"
+        "                        deadline[:RUNTIME/DEADLINE/PERIOD] (microseconds)\n"
+        "      --nice N          nice for SCHED_OTHER and, with -P, for the other threads\n"
+        "  -P, --process-priority  renice the process's other threads\n"
+        "  -T, --timer-boost     minimal timer slack + PM QoS latency request\n"
+        "      --slack NS        timer slack with -T (default: 1)\n"
+        "      --pm-qos US       CPU idle exit-latency target with -T (default: 0)\n"
+        "      --pm-qos-path P   PM QoS device (default: /dev/cpu_dma_latency)\n"
+        "      --busy-poll       poll the devices without blocking (\"Max+\"); off on battery\n"
+        "      --busy-poll-budget F  CPU fraction polling may use (default: 0.5)\n"
+        "      --wait-overshoot US  expected sleep overshoot seeding the replay's\n"
+        "                        sleep-then-spin margin (default: learned as it runs)\n"
+        "      --calibrate       print the CPU topology and DeviceTuner calibration, then exit\n"
+        "      --recalibrate     like --calibrate, but measure now instead of using the cache\n"
+        "      --noise MS        spin MS per CPU recording OS noise gaps (interrupts,\n"
+        "                        preemption), print per-CPU counts and histograms, then exit\n"
+        "      --noise-threshold US  smallest gap counted by --noise (default: 10)\n",
+        argv0);
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string> devices;
+    std::string replayPath;
+    std::string capturePath;
+    std::string recordPath;
+    std::string pmQosPath;
+    double speed = 1.0;
+    bool loop = false;
+    bool ioUring = false;
+    double duration = 0.0;
+    double interval = 1.0;
+    double noiseMs = 0.0;
+    double noiseThresholdUs = NoiseProbe::kDefaultThresholdUs;
+    bool modePreset = false;
+    InputThread::Config cfg{};
+    LatencyMeasurer::Backend backend = LatencyMeasurer::Backend::Histogram;
+
+    for (int i = 1; i < argc; i++) {
+        const std::string a = argv[i];
+        const bool hasValue = i + 1 < argc;
+
+        if ((a == "-d" || a == "--device") && hasValue) devices.push_back(argv[++i]);
+        else if ((a == "-t" || a == "--duration") && hasValue) duration = std::atof(argv[++i]);
+        else if ((a == "-i" || a == "--interval") && hasValue) interval = std::atof(argv[++i]);
+        else if ((a == "-r" || a == "--replay") && hasValue) replayPath = argv[++i];
+        else if ((a == "-s" || a == "--speed") && hasValue) speed = std::atof(argv[++i]);
+        else if (a == "--loop") loop = true;
+        else if (a == "--io" && hasValue) {
+            const std::string io = argv[++i];
+            if (io == "uring") ioUring = true;
+            else if (io == "epoll") ioUring = false;
+            else {
+                Usage(argv[0]);
+                return 2;
+            }
+        }
+        else if ((a == "-c" || a == "--capture") && hasValue) capturePath = argv[++i];
+        else if ((a == "-R" || a == "--record") && hasValue) recordPath = argv[++i];
+        else if ((a == "-m" || a == "--mode") && hasValue) {
+            if (!ApplyMode(argv[++i], cfg)) {
+                Usage(argv[0]);
+                return 2;
+            }
+            modePreset = true;
+        } else if (a == "--sched" && hasValue) {
+            if (!ParseSched(argv[++i], cfg)) {
+                Usage(argv[0]);
+                return 2;
+            }
+        } else if (a == "--nice" && hasValue) cfg.niceValue = std::atoi(argv[++i]);
+        else if (a == "-P" || a == "--process-priority") cfg.enableProcessPriority = true;
+        else if (a == "-T" || a == "--timer-boost") cfg.enableTimerBoost = true;
+        else if (a == "--slack" && hasValue) cfg.timerSlackNs = static_cast<UINT>(std::strtoul(argv[++i], nullptr, 10));
+        else if (a == "--pm-qos" && hasValue) cfg.pmQosLatencyUs = static_cast<UINT>(std::strtoul(argv[++i], nullptr, 10));
+        else if (a == "--pm-qos-path" && hasValue) pmQosPath = argv[++i];
+        else if (a == "--busy-poll") cfg.enableBusyPoll = true;
+        else if (a == "--busy-poll-budget" && hasValue) cfg.busyPollBudget = std::atof(argv[++i]);
+        else if (a == "--wait-overshoot" && hasValue) cfg.waitOvershootUs = std::atof(argv[++i]);
+        else if (a == "--noise" && hasValue) noiseMs = std::atof(argv[++i]);
+        else if (a == "--noise-threshold" && hasValue) noiseThresholdUs = std::atof(argv[++i]);
+        else if (a == "--calibrate" || a == "--recalibrate") {
+            if (a == "--recalibrate") DeviceTuner::Recalibrate();
+            PrintCalibration();
+            return 0;
+        }
+        else if ((a == "-a" || a == "--affinity" || a == "--cpus") && hasValue) {
+            std::string spec = argv[++i];
+            if (a != "--cpus" && spec.compare(0, 2, "0x") != 0 && spec.compare(0, 2, "0X") != 0) spec = "0x" + spec;
+            if (!CpuSet::Parse(spec, cfg.affinity)) {
+                Usage(argv[0]);
+                return 2;
+            }
+            cfg.enableAffinity = !cfg.affinity.Empty();
+        } else if ((a == "-b" || a == "--backend") && hasValue) {
+            const std::string b = argv[++i];
+            if (b == "ring") backend = LatencyMeasurer::Backend::Ring;
+            else if (b == "sketch") backend = LatencyMeasurer::Backend::Sketch;
+            else if (b == "histogram") backend = LatencyMeasurer::Backend::Histogram;
+            else {
+                Usage(argv[0]);
+                return 2;
+            }
+        } else {
+            Usage(argv[0]);
+            return 2;
+        }
+    }
+
+    if (noiseMs > 0.0) {
+        PrintNoise(noiseMs, noiseThresholdUs > 0.0 ? noiseThresholdUs : NoiseProbe::kDefaultThresholdUs);
+        return 0;
+    }
+
+    if (interval <= 0.0) interval = 1.0;
+
+    struct sigaction sa{};
+    sa.sa_handler = OnSignal;
+    sigaction(SIGINT, &sa, nullptr);
+    sigaction(SIGTERM, &sa, nullptr);
+
+    InputThread input;
+    input.GetMeasurer().SetBackend(backend);
+    if (!pmQosPath.empty()) input.SetPmQosPath(pmQosPath);
+
+    std::unique_ptr<InputSource> source;
+    ReplayInputSource* replay = nullptr;
+    if (!replayPath.empty()) {
+        auto r = std::make_unique<ReplayInputSource>(replayPath, speed, loop);
+        replay = r.get();
+        source = std::move(r);
+    }
+    else if (ioUring) {
+        source = devices.empty() ? std::make_unique<UringInputSource>() : std::make_unique<UringInputSource>(devices);
+    }
+    else if (!devices.empty()) source = std::make_unique<EvdevInputSource>(devices);
+    else source = CreateDefaultInputSource();
+
+    InputTraceWriter capture;
+    if (!capturePath.empty()) {
+        if (!capture.Open(capturePath)) {
+            std::fprintf(stderr, "cannot write %s\n", capturePath.c_str());
+            return 1;
+        }
+        source = std::make_unique<CaptureInputSource>(std::move(source), capture);
+    }
+    input.SetInputSource(std::move(source));
+
+    if (!recordPath.empty() && !input.StartRecording(recordPath)) {
+        std::fprintf(stderr, "cannot write %s\n", recordPath.c_str());
+        return 1;
+    }
+
+    // Modes follow the power state like the tray's; bare flags are taken as given.
+    if (modePreset) cfg = DeviceTuner::NormalizeForCurrentState(cfg);
+    input.Start(cfg);
+
+    using Clock = std::chrono::steady_clock;
+    const auto t0 = Clock::now();
+    auto nextPrint = t0 + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(interval));
+
+    while (!g_stop) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+        if (!input.IsRunning()) {
+            if (!replay) std::fprintf(stderr, "input thread stopped (no readable evdev devices?)\n");
+            else if (replay->Replayed() == 0) std::fprintf(stderr, "cannot replay %s\n", replayPath.c_str());
+            else std::fprintf(stderr, "replay finished (%llu events)\n", static_cast<unsigned long long>(replay->Replayed()));
+            break;
+        }
+
+        const auto now = Clock::now();
+        if (now >= nextPrint) {
+            std::printf("%ls\n\n", input.GetStatus().c_str());
+            std::fflush(stdout);
+            nextPrint += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(interval));
+        }
+
+        if (duration > 0.0 && std::chrono::duration<double>(now - t0).count() >= duration) break;
+    }
+
+    input.Stop();
+    input.StopRecording();
+    DeviceTuner::StopCalibration();
+    std::printf("%ls\n", input.GetStatus().c_str());
+
+    if (!capturePath.empty()) {
+        const unsigned long long n = capture.Count();
+        if (!capture.Close()) std::fprintf(stderr, "error writing %s\n", capturePath.c_str());
+        else std::fprintf(stderr, "captured %llu events to %s\n", n, capturePath.c_str());
+    }
+    return 0;
+}
+#endif // !_WIN32
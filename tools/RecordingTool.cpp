@@ -0,0 +1,134 @@
+// ilo_rec: converts an .ilorec session recording (EventRecorder) to CSV or
+// prints latency/arrival histograms.
+#include "../include/EventRecording.h"
+#include "../include/LatencyHistogram.h"
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+static void Usage(const char* argv0) {
+    std::fprintf(stderr,
+        "usage: %s COMMAND FILE\n"
+        "  info   header, record count and bytes per record\n"
+        "  csv    one line per event: arrival_us,latency_us,device,type,batch\n"
+        "  hist   latency quantiles and log2 histograms of latency and inter-arrival gap\n",
+        argv0);
+}
+
+static int Info(EventRecordingReader& reader, const std::string& path) {
+    const RecordingHeader& h = reader.Header();
+
+    uint64_t n = 0;
+    EventRecord r{};
+    while (reader.Next(r)) n++;
+
+    std::printf("file:        %s\n", path.c_str());
+    std::printf("records:     %" PRIu64 " (header says %" PRIu64 ")\n", n, h.recordCount);
+    std::printf("dropped:     %" PRIu64 "\n", h.dropped);
+    std::printf("bytes:       %" PRIu64 "\n", h.bytesUsed);
+    std::printf("bytes/event: %.2f\n", n ? static_cast<double>(h.bytesUsed - h.headerSize) / n : 0.0);
+    std::printf("units:       arrival %u ns, latency %u ns\n", h.arrivalUnitNs, h.latencyUnitNs);
+    return 0;
+}
+
+static int Csv(EventRecordingReader& reader) {
+    const uint64_t start = reader.Header().startNs;
+
+    std::printf("arrival_us,latency_us,device,type,batch\n");
+    EventRecord r{};
+    while (reader.Next(r)) {
+        std::printf("%.3f,%.3f,%" PRIu64 ",%u,%u\n",
+            static_cast<double>(r.arrivalNs - start) / 1000.0,
+            static_cast<double>(r.latencyNs) / 1000.0,
+            r.device, static_cast<unsigned>(r.type), static_cast<unsigned>(r.batch));
+    }
+    return 0;
+}
+
+static void PrintLog2(const char* title, const uint64_t* buckets, int count, uint64_t total) {
+    std::printf("\n%s\n", title);
+
+    uint64_t peak = 0;
+    for (int i = 0; i < count; i++) peak = buckets[i] > peak ? buckets[i] : peak;
+    if (peak == 0) return;
+
+    for (int i = 0; i < count; i++) {
+        if (!buckets[i]) continue;
+        const uint64_t lo = i == 0 ? 0 : (uint64_t(1) << (i - 1));
+        const uint64_t hi = uint64_t(1) << i;
+        const int bar = static_cast<int>(50 * buckets[i] / peak);
+        std::printf("  %9" PRIu64 " .. %-9" PRIu64 " %10" PRIu64 " %6.2f%% %.*s\n",
+            lo, hi, buckets[i], 100.0 * buckets[i] / total, bar,
+            "##################################################");
+    }
+}
+
+static int Bucket(uint64_t v) {
+    int b = 0;
+    while (v && b < 63) {
+        v >>= 1;
+        b++;
+    }
+    return b;
+}
+
+static int Hist(EventRecordingReader& reader) {
+    // ns, 1 ns .. 60 s at 3 significant digits
+    LatencyHistogram latency(1, 60ull * 1000000000ull, 3);
+    uint64_t latencyLog2[64]{};
+    uint64_t gapLog2[64]{};
+
+    uint64_t n = 0;
+    uint64_t lastArrival = 0;
+    EventRecord r{};
+    while (reader.Next(r)) {
+        latency.record(r.latencyNs);
+        latencyLog2[Bucket(r.latencyNs / 1000)]++;
+        if (n > 0) gapLog2[Bucket((r.arrivalNs - lastArrival) / 1000)]++;
+        lastArrival = r.arrivalNs;
+        n++;
+    }
+
+    if (n == 0) {
+        std::printf("no records\n");
+        return 0;
+    }
+
+    static const double kQ[5] = { 0.50, 0.90, 0.99, 0.999, 0.9999 };
+    uint64_t q[5]{};
+    latency.percentiles(kQ, q, 5);
+
+    std::printf("events %" PRIu64 "\n", n);
+    std::printf("latency (us): min %.1f / avg %.1f / p50 %.1f / p90 %.1f / p99 %.1f / p99.9 %.1f / p99.99 %.1f / max %.1f\n",
+        latency.min() / 1000.0, latency.average() / 1000.0,
+        q[0] / 1000.0, q[1] / 1000.0, q[2] / 1000.0, q[3] / 1000.0, q[4] / 1000.0,
+        latency.max() / 1000.0);
+
+    PrintLog2("latency (us)", latencyLog2, 64, n);
+    if (n > 1) PrintLog2("inter-arrival gap (us)", gapLog2, 64, n - 1);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        Usage(argv[0]);
+        return 2;
+    }
+
+    const std::string cmd = argv[1];
+    const std::string path = argv[2];
+
+    EventRecordingReader reader;
+    if (!reader.Open(path)) {
+        std::fprintf(stderr, "cannot read %s\n", path.c_str());
+        return 1;
+    }
+
+    if (cmd == "info") return Info(reader, path);
+    if (cmd == "csv") return Csv(reader);
+    if (cmd == "hist") return Hist(reader);
+
+    Usage(argv[0]);
+    return 2;
+}